@@ -298,7 +298,7 @@ void CollectionSystemManager::loadAutoCollectionSystems()
 						}
 
 						if (include) {
-							CollectionFileData* newGame = new CollectionFileData(*gameIt, newSys);
+							CollectionFileData* newGame = new (newSys->getArena()) CollectionFileData(*gameIt, newSys);
 							rootFolder->addChild(newGame);
 							index->addToIndex(newGame);
 						}
@@ -352,12 +352,11 @@ void CollectionSystemManager::updateCollectionSystems(FileData* file)
 			FileData* rootFolder = (*sysIt)->getRootFolder();
 			FileFilterIndex* fileIndex = (*sysIt)->getIndex();
 			std::string name = (*sysIt)->getName();
+			const FileData::SortType sortType = getSortType(mCollectionSystemDecls[name].defaultSort);
 			if (found) {
 				// if we found it, we need to update it
+				// it already shares the game's metadata, it just needs to be re-indexed and moved
 				FileData* collectionEntry = children.at(key);
-				// remove from index, so we can re-index metadata after refreshing
-				fileIndex->removeFromIndex(collectionEntry);
-				collectionEntry->refreshMetadata();
 				if (name == "favorites" && file->metadata.get("favorite") == "false") {
 					// need to check if still marked as favorite, if not remove
 					ViewController::get()->getGameListView((*sysIt)).get()->remove(collectionEntry, false);
@@ -365,8 +364,8 @@ void CollectionSystemManager::updateCollectionSystems(FileData* file)
 				}
 				else
 				{
-					// re-index with new metadata
 					fileIndex->addToIndex(collectionEntry);
+					rootFolder->resortChild(collectionEntry, sortType);
 					ViewController::get()->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
 				}
 			}
@@ -375,15 +374,14 @@ void CollectionSystemManager::updateCollectionSystems(FileData* file)
 				// we didn't find it here - we need to check if we should add it
 				if (name == "recent" && file->metadata.get("playcount") > "0" ||
 					name == "favorites" && file->metadata.get("favorite") == "true") {
-					CollectionFileData* newGame = new CollectionFileData(file, (*sysIt));
-					rootFolder->addChild(newGame);
+					CollectionFileData* newGame = new ((*sysIt)->getArena()) CollectionFileData(file, (*sysIt));
+					rootFolder->addChildSorted(newGame, sortType);
 					fileIndex->addToIndex(newGame);
 					ViewController::get()->onFileChanged(file, FILE_METADATA_CHANGED);
 					ViewController::get()->getGameListView((*sysIt))->onFileChanged(newGame, FILE_METADATA_CHANGED);
 				}
 			}
-			rootFolder->sort(getSortType(mCollectionSystemDecls[name].defaultSort));
-			ViewController::get()->onFileChanged(rootFolder, FILE_SORTED);
+			// the entry is already in place, so the views are only repopulated once above
 		}
 	}
 }
@@ -393,18 +391,73 @@ void CollectionSystemManager::deleteCollectionFiles(FileData* file)
 {
 	// collection files use the full path as key, to avoid clashes
 	std::string key = file->getFullPath();
-	// find games in collection systems
-	for(auto sysIt = SystemData::sSystemVector.begin(); sysIt != SystemData::sSystemVector.end(); sysIt++)
+	// find games in collection systems, disabled ones too as their entries point at the game
+	for(auto sysIt = mAllCollectionSystems.begin(); sysIt != mAllCollectionSystems.end(); sysIt++)
 	{
-		if ((*sysIt)->isCollection()) {
-			const std::unordered_map<std::string, FileData*>& children = (*sysIt)->getRootFolder()->getChildrenByFilename();
+		SystemData* system = sysIt->second.system;
+		const std::unordered_map<std::string, FileData*>& children = system->getRootFolder()->getChildrenByFilename();
+
+		bool found = children.find(key) != children.end();
+		if (found) {
+			FileData* collectionEntry = children.at(key);
+			if (std::find(SystemData::sSystemVector.begin(), SystemData::sSystemVector.end(), system) != SystemData::sSystemVector.end())
+				ViewController::get()->getGameListView(system).get()->remove(collectionEntry, false);
+			else
+				delete collectionEntry;
+		}
+	}
+}
 
-			bool found = children.find(key) != children.end();
-			if (found) {
-				FileData* collectionEntry = children.at(key);
-				ViewController::get()->getGameListView((*sysIt)).get()->remove(collectionEntry, false);
-			}
+void CollectionSystemManager::deleteCollectionFiles(const std::vector<FileData*>& files)
+{
+	for(auto sysIt = mAllCollectionSystems.begin(); sysIt != mAllCollectionSystems.end(); sysIt++)
+	{
+		SystemData* system = sysIt->second.system;
+		const std::unordered_map<std::string, FileData*>& children = system->getRootFolder()->getChildrenByFilename();
+
+		std::unordered_set<FileData*> entries;
+		for(auto it = files.begin(); it != files.end(); it++)
+		{
+			auto found = children.find((*it)->getFullPath());
+			if(found != children.end())
+				entries.insert(found->second);
 		}
+
+		if(entries.empty())
+			continue;
+
+		ViewController::get()->onFilesRemoving(system, entries);
+		for(auto it = entries.begin(); it != entries.end(); it++)
+			delete *it;
+		ViewController::get()->onFileChanged(system->getRootFolder(), FILE_REMOVED);
+	}
+}
+
+void CollectionSystemManager::addToAutoCollections(const std::vector<FileData*>& files)
+{
+	// new files haven't been played or marked as favorite yet, so they only go in "all games"
+	for(auto sysIt = mAllCollectionSystems.begin(); sysIt != mAllCollectionSystems.end(); sysIt++)
+	{
+		if(sysIt->second.decl.type != AUTO_ALL_GAMES)
+			continue;
+
+		SystemData* system = sysIt->second.system;
+		FileData* rootFolder = system->getRootFolder();
+		const FileData::SortType sortType = getSortType(sysIt->second.decl.defaultSort);
+		bool added = false;
+		for(auto it = files.begin(); it != files.end(); it++)
+		{
+			if(!includeFileInAutoCollections(*it))
+				continue;
+
+			CollectionFileData* newGame = new (system->getArena()) CollectionFileData(*it, system);
+			rootFolder->addChildSorted(newGame, sortType);
+			system->getIndex()->addToIndex(newGame);
+			added = true;
+		}
+
+		if(added)
+			ViewController::get()->onFileChanged(rootFolder, FILE_ADDED);
 	}
 }
 
@@ -426,6 +479,7 @@ bool CollectionSystemManager::toggleGameInCollection(FileData* file, std::string
 			s = new GuiInfoPopup(mWindow, "Removed '" + removeParenthesis(file->getName()) + "' from 'Favorites'", 4000);
 		}
 		mWindow->setInfoPopup(s);
+		file->onMetadataChanged();
 		updateCollectionSystems(file->getSourceFileData());
 		return true;
 	}
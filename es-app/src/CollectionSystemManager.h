@@ -47,6 +47,8 @@ public:
 	void loadCollectionSystems();
 	void updateCollectionSystems(FileData* file);
 	void deleteCollectionFiles(FileData* file);
+	void deleteCollectionFiles(const std::vector<FileData*>& files); // one view update per collection
+	void addToAutoCollections(const std::vector<FileData*>& files); // games that were just found on disk
 	inline std::map<std::string, CollectionSystemData> getCollectionSystems() { return mAllCollectionSystems; };
 	void updateSystemsList();
 	bool isThemeAutoCompatible();
@@ -2,20 +2,135 @@
 #include "FileSorts.h"
 #include "views/ViewController.h"
 #include "SystemData.h"
+#include "GameSearchIndex.h"
+#include "GameFolderWatcher.h"
 #include "Log.h"
 #include "AudioManager.h"
 #include "VolumeControl.h"
 #include "Util.h"
+#include <cstddef>
+#include <cstring>
 
 namespace fs = boost::filesystem;
 
+const std::vector<FileData*> FileData::sNoChildren;
+const std::unordered_map<std::string, FileData*> FileData::sNoChildrenByFilename;
+
+std::map<const char*, FileDataArena*> FileDataArena::sBlocks;
+
+FileDataArena::FileDataArena() : mBlockUsed(BLOCK_SIZE), mLargeBytes(0)
+{
+}
+
+FileDataArena::~FileDataArena()
+{
+	for(auto it = mBlocks.begin(); it != mBlocks.end(); it++)
+		sBlocks.erase(it->get());
+}
+
+// keep everything aligned for any type
+size_t FileDataArena::roundUp(size_t size)
+{
+	const size_t align = alignof(std::max_align_t);
+	return (size + align - 1) & ~(align - 1);
+}
+
+void* FileDataArena::allocate(size_t size)
+{
+	size = roundUp(size);
+
+	auto freed = mFree.find(size);
+	if(freed != mFree.end() && !freed->second.empty())
+	{
+		void* mem = freed->second.back();
+		freed->second.pop_back();
+		return mem;
+	}
+
+	if(size > BLOCK_SIZE / 4)
+	{
+		// would waste too much of a block, put it in front of the current one so it's still freed with us
+		char* mem = new char[size];
+		mBlocks.insert(mBlocks.end() - (mBlocks.empty() ? 0 : 1), std::unique_ptr<char[]>(mem));
+		sBlocks[mem] = this;
+		mLargeBytes += size;
+		return mem;
+	}
+
+	if(mBlockUsed + size > BLOCK_SIZE)
+	{
+		mBlocks.push_back(std::unique_ptr<char[]>(new char[BLOCK_SIZE]));
+		sBlocks[mBlocks.back().get()] = this;
+		mBlockUsed = 0;
+	}
+
+	void* mem = mBlocks.back().get() + mBlockUsed;
+	mBlockUsed += size;
+	return mem;
+}
+
+void FileDataArena::release(void* ptr, size_t size)
+{
+	mFree[roundUp(size)].push_back(ptr);
+}
+
+const char* FileDataArena::copyString(const std::string& str)
+{
+	char* mem = (char*)allocate(str.length() + 1);
+	memcpy(mem, str.c_str(), str.length() + 1);
+	return mem;
+}
+
+void FileDataArena::releaseString(const char* str)
+{
+	release(const_cast<char*>(str), strlen(str) + 1);
+}
+
+FileDataArena* FileDataArena::getArena(const void* ptr)
+{
+	// the last block that starts at or before ptr
+	auto it = sBlocks.upper_bound((const char*)ptr);
+	assert(it != sBlocks.begin());
+	return (--it)->second;
+}
+
+void* FileData::operator new(size_t size, FileDataArena& arena)
+{
+	return arena.allocate(size);
+}
+
+void FileData::operator delete(void* ptr, FileDataArena& arena)
+{
+}
+
+void FileData::operator delete(void* ptr, size_t size)
+{
+	FileDataArena::getArena(ptr)->release(ptr, size);
+}
+
 FileData::FileData(FileType type, const fs::path& path, SystemEnvironmentData* envData, SystemData* system)
-	: mType(type), mPath(path), mSystem(system), mEnvData(envData), mSourceFileData(NULL), mParent(NULL), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
+	: metadata(mMetadata), mSourceFileData(NULL), mParent(NULL), mType(type),
+	mGameCount(type == GAME ? 1 : 0), mDisplayedGameCount(type == GAME ? 1 : 0), mFilterId(-1), mSearchId(-1),
+	mMetadata(type == GAME ? GAME_METADATA : FOLDER_METADATA), mEnvData(envData), mSystem(system) // metadata is REALLY set in the constructor!
 {
+	// everything in a system is under its start path, so that part is only stored once
+	const std::string& pathStr = path.generic_string();
+	const std::string& startPath = envData->mStartPath;
+	mPathIsRelative = !startPath.empty() && pathStr.compare(0, startPath.length(), startPath) == 0 &&
+		(pathStr.length() == startPath.length() || pathStr[startPath.length()] == '/' || startPath.back() == '/');
+	mPath = system->getArena().copyString(mPathIsRelative ? pathStr.substr(startPath.length()) : pathStr);
+
 	// metadata needs at least a name field (since that's what getName() will return)
 	if(metadata.get("name").empty())
 		metadata.set("name", getDisplayName());
-	mSystemName = system->getName();
+}
+
+FileData::FileData(FileData* source, SystemData* system)
+	: metadata(source->metadata), mSourceFileData(source), mParent(NULL), mType(source->mType), mPathIsRelative(source->mPathIsRelative),
+	mGameCount(source->mType == GAME ? 1 : 0), mDisplayedGameCount(source->mType == GAME ? 1 : 0), mFilterId(-1), mSearchId(-1),
+	mMetadata(source->metadata.getType()), mPath(source->mPath), mEnvData(source->mEnvData), mSystem(system)
+{
+	// the source's system outlives its collection entries, see deleteSystems()
 }
 
 FileData::~FileData()
@@ -24,13 +139,36 @@ FileData::~FileData()
 		mParent->removeChild(this);
 
 	mSystem->getIndex()->removeFromIndex(this);
+	GameSearchIndex::getInstance()->removeGame(this);
 
-	mChildren.clear();
+	if(mChildren)
+	{
+		// they don't need to remove themselves from us one by one
+		for(auto it = mChildren->list.begin(); it != mChildren->list.end(); it++)
+		{
+			(*it)->mParent = NULL;
+			delete *it;
+		}
+	}
+
+	// a collection entry's is its game's
+	if(!mSourceFileData)
+		mSystem->getArena().releaseString(mPath);
+}
+
+fs::path FileData::getPath() const
+{
+	return mPathIsRelative ? fs::path(mEnvData->mStartPath + mPath) : fs::path(mPath);
+}
+
+const std::string& FileData::getSystemName() const
+{
+	return (mSourceFileData ? mSourceFileData : this)->mSystem->getName();
 }
 
 std::string FileData::getDisplayName() const
 {
-	std::string stem = mPath.stem().generic_string();
+	std::string stem = getPath().stem().generic_string();
 	if(mSystem && mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO))
 		stem = PlatformIds::getCleanMameName(stem.c_str());
 
@@ -58,23 +196,39 @@ const std::string& FileData::getName()
 const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
 
 	FileFilterIndex* idx = mSystem->getIndex();
-	if (idx->isFiltered()) {
-		mFilteredChildren.clear();
-		for(auto it = mChildren.begin(); it != mChildren.end(); it++)
+	if (mChildren && idx->isFiltered()) {
+		mChildren->filtered.clear();
+		for(auto it = mChildren->list.begin(); it != mChildren->list.end(); it++)
 		{
 			if (idx->showFile((*it))) {
-				mFilteredChildren.push_back(*it);
+				mChildren->filtered.push_back(*it);
 			}
 		}
 
-		return mFilteredChildren;
+		return mChildren->filtered;
 	}
 	else
 	{
-		return mChildren;
+		return getChildren();
 	}
 }
 
+const std::unordered_map<std::string, FileData*>& FileData::getChildrenByFilename() const
+{
+	if(!mChildren)
+		return sNoChildrenByFilename;
+
+	if(!mChildren->byFilename)
+	{
+		mChildren->byFilename.reset(new std::unordered_map<std::string, FileData*>());
+		mChildren->byFilename->reserve(mChildren->list.size());
+		for(auto it = mChildren->list.begin(); it != mChildren->list.end(); it++)
+			(*mChildren->byFilename)[(*it)->getKey()] = *it;
+	}
+
+	return *mChildren->byFilename;
+}
+
 const std::string& FileData::getVideoPath() const
 {
 	return metadata.get("video");
@@ -89,8 +243,9 @@ std::vector<FileData*> FileData::getFilesRecursive(unsigned int typeMask, bool d
 {
 	std::vector<FileData*> out;
 	FileFilterIndex* idx = mSystem->getIndex();
+	const std::vector<FileData*>& children = getChildren();
 
-	for(auto it = mChildren.begin(); it != mChildren.end(); it++)
+	for(auto it = children.begin(); it != children.end(); it++)
 	{
 		if((*it)->getType() & typeMask)
 		{
@@ -108,6 +263,60 @@ std::vector<FileData*> FileData::getFilesRecursive(unsigned int typeMask, bool d
 	return out;
 }
 
+FileData* FileData::getDisplayedGame(unsigned int index) const
+{
+	if(mType == GAME)
+		return index == 0 && mDisplayedGameCount ? const_cast<FileData*>(this) : NULL;
+
+	// skip over whole folders using their counts rather than looking at every game
+	if(index >= mDisplayedGameCount)
+		return NULL;
+
+	const std::vector<FileData*>& children = getChildren();
+	for(auto it = children.begin(); it != children.end(); it++)
+	{
+		if(index < (*it)->mDisplayedGameCount)
+			return (*it)->getDisplayedGame(index);
+
+		index -= (*it)->mDisplayedGameCount;
+	}
+
+	return NULL;
+}
+
+void FileData::setDisplayed(bool displayed)
+{
+	assert(mType == GAME);
+	if(displayed != (mDisplayedGameCount != 0))
+		adjustGameCounts(0, displayed ? 1 : -1);
+}
+
+void FileData::refreshDisplayedCounts(FileFilterIndex* idx)
+{
+	if(mType == GAME)
+	{
+		mDisplayedGameCount = idx->showFile(this) ? 1 : 0;
+		return;
+	}
+
+	mDisplayedGameCount = 0;
+	const std::vector<FileData*>& children = getChildren();
+	for(auto it = children.begin(); it != children.end(); it++)
+	{
+		(*it)->refreshDisplayedCounts(idx);
+		mDisplayedGameCount += (*it)->mDisplayedGameCount;
+	}
+}
+
+void FileData::adjustGameCounts(int games, int displayed)
+{
+	for(FileData* file = this; file != NULL; file = file->mParent)
+	{
+		file->mGameCount += games;
+		file->mDisplayedGameCount += displayed;
+	}
+}
+
 std::string FileData::getKey() {
 	return getFileName();
 }
@@ -118,29 +327,52 @@ FileData* FileData::getSourceFileData()
 }
 
 void FileData::addChild(FileData* file)
+{
+	if(insertChild(file))
+		markOutOfOrder(NULL);
+}
+
+bool FileData::insertChild(FileData* file)
 {
 	assert(mType == FOLDER);
 	assert(file->getParent() == NULL);
 
-	const std::string key = file->getKey();
-	if (mChildrenByFilename.find(key) == mChildrenByFilename.end())
+	if(!mChildren)
+		mChildren.reset(new Children());
+
+	// the filename map is only kept up to date once something has needed it, until then
+	// it's up to the caller not to add the same file twice (a folder can't have duplicates anyway)
+	if(mChildren->byFilename)
 	{
-		mChildrenByFilename[key] = file;
-		mChildren.push_back(file);
-		file->mParent = this;
+		const std::string key = file->getKey();
+		if(mChildren->byFilename->find(key) != mChildren->byFilename->end())
+			return false;
+
+		(*mChildren->byFilename)[key] = file;
 	}
+
+	mChildren->list.push_back(file);
+	mChildren->firstByLetter.reset();
+	file->mParent = this;
+	adjustGameCounts(file->mGameCount, file->mDisplayedGameCount);
+	return true;
 }
 
 void FileData::removeChild(FileData* file)
 {
 	assert(mType == FOLDER);
 	assert(file->getParent() == this);
-	mChildrenByFilename.erase(file->getKey());
-	for(auto it = mChildren.begin(); it != mChildren.end(); it++)
+	if(mChildren->byFilename)
+		mChildren->byFilename->erase(file->getKey());
+	for(auto it = mChildren->list.begin(); it != mChildren->list.end(); it++)
 	{
 		if(*it == file)
 		{
-			mChildren.erase(it);
+			mChildren->list.erase(it);
+			mChildren->firstByLetter.reset();
+			if(mChildren->outOfPlace == file)
+				mChildren->outOfPlace = NULL;
+			adjustGameCounts(-(int)file->mGameCount, -(int)file->mDisplayedGameCount);
 			return;
 		}
 	}
@@ -152,16 +384,27 @@ void FileData::removeChild(FileData* file)
 
 void FileData::sort(ComparisonFunction& comparator, bool ascending)
 {
-	std::stable_sort(mChildren.begin(), mChildren.end(), comparator);
+	if(!mChildren)
+		return;
+
+	std::vector<FileData*>& children = mChildren->list;
+	std::stable_sort(children.begin(), children.end(), comparator);
 
-	for(auto it = mChildren.begin(); it != mChildren.end(); it++)
+	for(auto it = children.begin(); it != children.end(); it++)
 	{
 		if((*it)->getChildren().size() > 0)
 			(*it)->sort(comparator, ascending);
 	}
 
 	if(!ascending)
-		std::reverse(mChildren.begin(), mChildren.end());
+		std::reverse(children.begin(), children.end());
+
+	mChildren->sortedBy = &comparator;
+	mChildren->sortedAscending = ascending;
+	mChildren->outOfPlace = NULL;
+	mChildren->outOfOrder = false;
+	mChildren->subtreeOutOfOrder = false;
+	mChildren->firstByLetter.reset();
 }
 
 void FileData::sort(const SortType& type)
@@ -169,6 +412,158 @@ void FileData::sort(const SortType& type)
 	sort(*type.comparisonFunction, type.ascending);
 }
 
+bool FileData::wasLastSortedBy(const SortType& type) const
+{
+	return mChildren && mChildren->sortedBy == type.comparisonFunction && mChildren->sortedAscending == type.ascending;
+}
+
+bool FileData::isSortedBy(const SortType& type) const
+{
+	return wasLastSortedBy(type) && !mChildren->outOfPlace && !mChildren->outOfOrder;
+}
+
+// child is the one that may have moved, NULL if it could be any of them
+void FileData::markOutOfOrder(FileData* child)
+{
+	if(child && (!mChildren->outOfPlace || mChildren->outOfPlace == child))
+		mChildren->outOfPlace = child;
+	else
+		mChildren->outOfOrder = true;
+
+	for(FileData* folder = mParent; folder && !folder->mChildren->subtreeOutOfOrder; folder = folder->mParent)
+		folder->mChildren->subtreeOutOfOrder = true;
+}
+
+void FileData::onMetadataChanged()
+{
+	FileData* game = getSourceFileData();
+	if(game->mParent)
+	{
+		game->mParent->mChildren->firstByLetter.reset();
+		game->mParent->markOutOfOrder(game);
+	}
+
+	// the collection entries share the metadata, so they may have moved too
+	if(game->getType() != GAME)
+		return;
+
+	const std::string key = game->getFullPath();
+	for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
+	{
+		if(!(*it)->isCollection())
+			continue;
+
+		FileData* root = (*it)->getRootFolder();
+		const std::unordered_map<std::string, FileData*>& children = root->getChildrenByFilename();
+		auto entry = children.find(key);
+		if(entry != children.end())
+		{
+			root->mChildren->firstByLetter.reset();
+			root->markOutOfOrder(entry->second);
+		}
+	}
+}
+
+bool FileData::addChildSorted(FileData* file, const SortType& type)
+{
+	const bool sorted = isSortedBy(type);
+	if(!insertChild(file))
+		return false; // already had one with that name
+
+	if(!sorted)
+	{
+		sort(type);
+		return true;
+	}
+
+	if(file->getChildren().size() > 0)
+		file->sort(type);
+	return placeSorted(file, type);
+}
+
+bool FileData::resortChild(FileData* file, const SortType& type)
+{
+	assert(file->getParent() == this);
+
+	// file is the one that changed, the others have to still be in order
+	if(!wasLastSortedBy(type) || mChildren->outOfOrder || (mChildren->outOfPlace && mChildren->outOfPlace != file))
+	{
+		sort(type);
+		return true;
+	}
+
+	if(file->getChildren().size() > 0)
+		file->sort(type);
+	mChildren->outOfPlace = NULL;
+	return placeSorted(file, type);
+}
+
+bool FileData::placeSorted(FileData* file, const SortType& type)
+{
+	std::vector<FileData*>& children = mChildren->list;
+	auto current = std::find(children.begin(), children.end(), file);
+	const size_t oldPos = current - children.begin();
+	children.erase(current);
+
+	// a descending sort is an ascending stable_sort reversed, so the file goes after anything it
+	// compares equal to when ascending and before it when descending
+	ComparisonFunction* comparator = type.comparisonFunction;
+	std::vector<FileData*>::iterator pos;
+	if(type.ascending)
+		pos = std::upper_bound(children.begin(), children.end(), file, comparator);
+	else
+		pos = std::lower_bound(children.begin(), children.end(), file,
+			[comparator](const FileData* child, const FileData* value) { return comparator(value, child); });
+
+	const size_t newPos = pos - children.begin();
+	children.insert(pos, file);
+	mChildren->firstByLetter.reset();
+	return newPos != oldPos;
+}
+
+bool FileData::isTreeSortedBy(const SortType& type) const
+{
+	if(!mChildren)
+		return true;
+
+	return isSortedBy(type) && !mChildren->subtreeOutOfOrder;
+}
+
+int FileData::getFirstChildIndexForLetter(char letter)
+{
+	if(!mChildren)
+		return -1;
+
+	std::vector<FileData*>& children = mChildren->list;
+	if(!mChildren->firstByLetter)
+	{
+		std::vector<int>* table = new std::vector<int>(256, -1);
+		for(int i = (int)children.size() - 1; i >= 0; i--)
+		{
+			const std::string& name = children[i]->getName();
+			if(!name.empty())
+				(*table)[toupper((unsigned char)name[0])] = i;
+		}
+		mChildren->firstByLetter.reset(table);
+	}
+
+	const std::vector<int>& table = *mChildren->firstByLetter;
+	const int target = toupper((unsigned char)letter);
+	if(table[target] != -1 || mChildren->sortedBy != &FileSorts::compareName || mChildren->outOfPlace || mChildren->outOfOrder)
+		return table[target];
+
+	// the nearest letter that comes after it in the list's order
+	const int step = mChildren->sortedAscending ? 1 : -1;
+	for(int c = target + step; c >= 0 && c < 256; c += step)
+	{
+		if(table[c] != -1)
+			return table[c];
+	}
+
+	// past the end
+	return children.empty() ? -1 : (int)children.size() - 1;
+}
+
 void FileData::launchGame(Window* window)
 {
 	LOG(LogInfo) << "Attempting to launch game...";
@@ -200,6 +595,9 @@ void FileData::launchGame(Window* window)
 	AudioManager::getInstance()->init();
 	window->normalizeNextUpdate();
 
+	// anything that ran alongside it may have added or removed games
+	GameFolderWatcher::getInstance()->rescanSoon();
+
 	//update number of times the game has been launched
 
 	FileData* gameToUpdate = getSourceFileData();
@@ -210,21 +608,13 @@ void FileData::launchGame(Window* window)
 	//update last played time
 	boost::posix_time::ptime time = boost::posix_time::second_clock::universal_time();
 	gameToUpdate->metadata.setTime("lastplayed", time);
+	gameToUpdate->onMetadataChanged();
 	CollectionSystemManager::get()->updateCollectionSystems(gameToUpdate);
 }
 
 CollectionFileData::CollectionFileData(FileData* file, SystemData* system)
-	: FileData(file->getType(), file->getPath(), file->getSystemEnvData(), system)/*,
-	  mSourceFileData(file->getSourceFileData()),
-	  mParent(NULL),
-	  metadata(file->getSourceFileData()->metadata)*/
-{
-	// we use this constructor to create a clone of the filedata, and change its system
-	mSourceFileData = file->getSourceFileData();
-	refreshMetadata();
-	mParent = NULL;
-	metadata = mSourceFileData->metadata;
-	mSystemName = mSourceFileData->getSystem()->getName();
+	: FileData(file->getSourceFileData(), system), mNameVersion(0)
+{
 }
 
 CollectionFileData::~CollectionFileData()
@@ -244,19 +634,13 @@ FileData* CollectionFileData::getSourceFileData()
 	return mSourceFileData;
 }
 
-void CollectionFileData::refreshMetadata()
-{
-	metadata = mSourceFileData->metadata;
-	mDirty = true;
-}
-
 const std::string& CollectionFileData::getName()
 {
-	if (mDirty) {
-		mCollectionFileName = removeParenthesis(mSourceFileData->metadata.get("name"));
+	if (mNameVersion != metadata.getVersion()) {
+		mCollectionFileName = removeParenthesis(metadata.get("name"));
 		boost::trim(mCollectionFileName);
 		mCollectionFileName += " [" + strToUpper(mSourceFileData->getSystem()->getName()) + "]";
-		mDirty = false;
+		mNameVersion = metadata.getVersion();
 	}
 	return mCollectionFileName;
 }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <unordered_map>
+#include <map>
 #include <string>
 #include <vector>
+#include <memory>
 #include <boost/filesystem.hpp>
 #include "MetaData.h"
 
 class SystemData;
+class FileFilterIndex;
 struct SystemEnvironmentData;
 
 enum FileType
@@ -28,19 +31,58 @@ enum FileChangeType
 const char* fileTypeToString(FileType type);
 FileType stringToFileType(const char* str);
 
+// Memory for one system's FileData and their paths. It's handed out from large blocks one after
+// the other, so a system's tree sits together in memory without any per node allocation overhead,
+// and it's all freed with the system. Memory given back early (deleted FileData, their paths) is
+// kept by size and handed out again for the next allocation of that size, so however long the
+// folder watcher runs, the arena only holds as much of each size as was ever in use at once.
+// Not thread safe, a system's tree is only built by one thread at a time.
+class FileDataArena
+{
+public:
+	FileDataArena();
+	~FileDataArena();
+
+	void* allocate(size_t size);
+	void release(void* ptr, size_t size); // size as given to allocate()
+	const char* copyString(const std::string& str); // until releaseString()
+	void releaseString(const char* str);
+
+	static FileDataArena* getArena(const void* ptr); // the one ptr was allocated from
+
+	inline size_t getMemUsage() const { return mBlocks.size() * BLOCK_SIZE + mLargeBytes; }
+
+private:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	static size_t roundUp(size_t size);
+
+	std::vector< std::unique_ptr<char[]> > mBlocks;
+	size_t mBlockUsed; // of mBlocks.back()
+	size_t mLargeBytes; // allocations bigger than a block get their own
+	std::unordered_map< size_t, std::vector<void*> > mFree; // by rounded up size
+
+	static std::map<const char*, FileDataArena*> sBlocks; // every arena's blocks by where they start
+};
+
 // A tree node that holds information for a file.
+// Always created in its system's arena, with new (system->getArena()) FileData(...).
 class FileData
 {
 public:
 	FileData(FileType type, const boost::filesystem::path& path, SystemEnvironmentData* envData, SystemData* system);
-	virtual ~FileData();
+	virtual ~FileData(); // also deletes the children
+
+	static void* operator new(size_t size, FileDataArena& arena);
+	static void operator delete(void* ptr, FileDataArena& arena); // only if the constructor throws
+	static void operator delete(void* ptr, size_t size); // back to the arena it came from
 
 	virtual const std::string& getName();
 	inline FileType getType() const { return mType; }
-	inline const boost::filesystem::path& getPath() const { return mPath; }
+	boost::filesystem::path getPath() const;
 	inline FileData* getParent() const { return mParent; }
-	inline const std::unordered_map<std::string, FileData*>& getChildrenByFilename() const { return mChildrenByFilename; }
-	inline const std::vector<FileData*>& getChildren() const { return mChildren; }
+	const std::unordered_map<std::string, FileData*>& getChildrenByFilename() const; // built the first time it's needed
+	inline const std::vector<FileData*>& getChildren() const { return mChildren ? mChildren->list : sNoChildren; }
 	inline SystemData* getSystem() const { return mSystem; }
 	inline SystemEnvironmentData* getSystemEnvData() const { return mEnvData; }
 	virtual const std::string& getThumbnailPath() const;
@@ -50,18 +92,34 @@ public:
 	const std::vector<FileData*>& getChildrenListToDisplay();
 	std::vector<FileData*> getFilesRecursive(unsigned int typeMask, bool displayedOnly = false) const;
 
+	// Games in this folder and everything under it (1 or 0 for a game), kept up to date as children
+	// come and go. The displayed count is only current once the system's index has updated it,
+	// see FileFilterIndex::updateDisplayedCounts().
+	inline unsigned int getGameCount() const { return mGameCount; }
+	inline unsigned int getDisplayedGameCount() const { return mDisplayedGameCount; }
+	FileData* getDisplayedGame(unsigned int index) const; // in child order, NULL if out of range
+
+	void setDisplayed(bool displayed); // games only, updates the counts of every folder above
+	void refreshDisplayedCounts(FileFilterIndex* idx);
+
+	// dense id given out by the system's FileFilterIndex, -1 while it isn't indexed
+	inline int getFilterId() const { return mFilterId; }
+	inline void setFilterId(int id) { mFilterId = id; }
+
+	// where GameSearchIndex keeps it, -1 if it isn't searchable
+	inline int getSearchId() const { return mSearchId; }
+	inline void setSearchId(int id) { mSearchId = id; }
+
 	void addChild(FileData* file); // Error if mType != FOLDER
 	void removeChild(FileData* file); //Error if mType != FOLDER
 
 	inline bool isPlaceHolder() { return mType == PLACEHOLDER; };
 
-	virtual inline void refreshMetadata() { return; };
-
 	virtual std::string getKey();
 	inline std::string getFullPath() { return getPath().string(); };
 	inline std::string getFileName() { return getPath().filename().string(); };
 	virtual FileData* getSourceFileData();
-	inline std::string getSystemName() const { return mSystemName; };
+	const std::string& getSystemName() const;
 
 	// Returns our best guess at the "real" name for this file (will attempt to perform MAME name translation)
 	std::string getDisplayName() const;
@@ -84,21 +142,73 @@ public:
 
 	void sort(ComparisonFunction& comparator, bool ascending = true);
 	void sort(const SortType& type);
-	MetaDataList metadata;
+
+	// Put one child where sort(type) would, with a binary search if the others are already sorted
+	// that way and a full sort otherwise. Returns true if anything moved.
+	bool addChildSorted(FileData* file, const SortType& type);
+	bool resortChild(FileData* file, const SortType& type);
+	bool isTreeSortedBy(const SortType& type) const; // this folder and every folder under it
+	bool wasLastSortedBy(const SortType& type) const; // even if something has changed since
+
+	// Index of the first child whose name starts with letter (ignoring case). If there isn't one and the
+	// children are sorted by name, the one where it would have been. -1 otherwise.
+	// Looked up in a table that's only rebuilt after the children or their names change.
+	int getFirstChildIndexForLetter(char letter);
+
+	MetaDataList& metadata; // a collection entry's is the one of the game it's for
+	// Call after changing metadata, so the folders the game and its collection entries are in know
+	// they may be out of order and rebuild their letter tables.
+	void onMetadataChanged();
 
 protected:
+	FileData(FileData* source, SystemData* system); // a collection entry, shares the path and metadata of source
+
 	FileData* mSourceFileData;
 	FileData* mParent;
-	std::string mSystemName;
 
 private:
+	void adjustGameCounts(int games, int displayed);
+	bool isSortedBy(const SortType& type) const;
+	bool insertChild(FileData* file); // addChild() without touching the order, false if it was already there
+	void markOutOfOrder(FileData* child);
+	bool placeSorted(FileData* file, const SortType& type);
+
 	FileType mType;
-	boost::filesystem::path mPath;
+	bool mPathIsRelative;
+	unsigned int mGameCount;
+	unsigned int mDisplayedGameCount;
+	int mFilterId;
+	int mSearchId;
+	MetaDataList mMetadata; // left empty by collection entries
+	const char* mPath; // in the system's arena, relative to the start path unless it's outside of it
 	SystemEnvironmentData* mEnvData;
 	SystemData* mSystem;
-	std::unordered_map<std::string,FileData*> mChildrenByFilename;
-	std::vector<FileData*> mChildren;
-	std::vector<FileData*> mFilteredChildren;
+
+	// only folders with something in them have one of these
+	struct Children
+	{
+		std::vector<FileData*> list;
+		std::vector<FileData*> filtered;
+		std::unique_ptr< std::unordered_map<std::string, FileData*> > byFilename;
+
+		// the last sort(), and what's happened since: the one child whose metadata changed, or
+		// more than that (children added out of order too), or the same in a folder under this one
+		ComparisonFunction* sortedBy;
+		bool sortedAscending;
+		FileData* outOfPlace;
+		bool outOfOrder;
+		bool subtreeOutOfOrder;
+
+		// first child for each leading byte of the name, upper case, -1 if none
+		std::unique_ptr< std::vector<int> > firstByLetter;
+
+		Children() : sortedBy(NULL), sortedAscending(true), outOfPlace(NULL), outOfOrder(false), subtreeOutOfOrder(false) {}
+	};
+
+	std::unique_ptr<Children> mChildren;
+
+	static const std::vector<FileData*> sNoChildren;
+	static const std::unordered_map<std::string, FileData*> sNoChildrenByFilename;
 };
 
 class CollectionFileData : public FileData
@@ -107,11 +217,10 @@ public:
 	CollectionFileData(FileData* file, SystemData* system);
 	~CollectionFileData();
 	const std::string& getName();
-	void refreshMetadata();
 	FileData* getSourceFileData();
 	std::string getKey();
 private:
-	// needs to be updated when metadata changes
+	// made again when metadata's version changes
 	std::string mCollectionFileName;
-	bool mDirty;
+	unsigned int mNameVersion;
 };
\ No newline at end of file
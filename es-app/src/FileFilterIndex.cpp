@@ -4,7 +4,8 @@
 #define INCLUDE_UNKNOWN false;
 
 FileFilterIndex::FileFilterIndex()
-	: filterByGenre(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), filterByFavorites(false)
+	: mShownDirty(false), filterByGenre(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), filterByFavorites(false),
+	mRootFolder(NULL), mDisplayedCountsDirty(false)
 {
 	FilterDataDecl filterDecls[] = {
 		//type 				//allKeys 				//filteredBy 		//filteredKeys 				//primaryKey 	//hasSecondaryKey 	//secondaryKey 	//menuLabel
@@ -16,6 +17,11 @@ FileFilterIndex::FileFilterIndex()
 	};
 
 	filterDataDecl = std::vector<FilterDataDecl>(filterDecls, filterDecls + sizeof(filterDecls) / sizeof(filterDecls[0]));
+
+	for(int i = 0; i < FILTER_TYPES; i++)
+		mAllIndexKeys[i] = NULL;
+	for(auto it = filterDataDecl.begin(); it != filterDataDecl.end(); ++it)
+		mAllIndexKeys[it->type] = it->allIndexKeys;
 }
 
 FileFilterIndex::~FileFilterIndex()
@@ -112,22 +118,164 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 	return key;
 }
 
+void IdBitmap::orWith(const IdBitmap& other)
+{
+	if(other.mWords.size() > mWords.size())
+		mWords.resize(other.mWords.size(), 0);
+
+	for(size_t i = 0; i < other.mWords.size(); i++)
+		mWords[i] |= other.mWords[i];
+}
+
+void IdBitmap::andWith(const IdBitmap& other)
+{
+	if(mWords.size() > other.mWords.size())
+		mWords.resize(other.mWords.size());
+
+	for(size_t i = 0; i < mWords.size(); i++)
+		mWords[i] &= other.mWords[i];
+}
+
 void FileFilterIndex::addToIndex(FileData* game)
 {
-	manageGenreEntryInIndex(game);
-	managePlayerEntryInIndex(game);
-	managePubDevEntryInIndex(game);
-	manageRatingsEntryInIndex(game);
-	manageFavoritesEntryInIndex(game);
+	// re-indexed from scratch in case it was already in, the keys are worked out once here
+	unpostGame(game);
+	postGame(game);
+
+	// its metadata may have changed, so it may have come into or gone out of the filter
+	if(game->getType() == GAME && !mDisplayedCountsDirty)
+		game->setDisplayed(showFile(game));
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
 {
-	manageGenreEntryInIndex(game, true);
-	managePlayerEntryInIndex(game, true);
-	managePubDevEntryInIndex(game, true);
-	manageRatingsEntryInIndex(game, true);
-	manageFavoritesEntryInIndex(game, true);
+	// what it was indexed under is remembered, so this doesn't care if its metadata has changed since
+	unpostGame(game);
+}
+
+void FileFilterIndex::postGame(FileData* game)
+{
+	unsigned int id;
+	if(!mFreeIds.empty())
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}else{
+		id = mGames.size();
+		mGames.push_back(IndexedGame());
+	}
+	game->setFilterId(id);
+
+	IndexedGame& entry = mGames[id];
+	entry = IndexedGame();
+
+	manageGenreEntryInIndex(game, entry);
+	managePlayerEntryInIndex(game, entry);
+	managePubDevEntryInIndex(game, entry);
+	manageRatingsEntryInIndex(game, entry);
+	manageFavoritesEntryInIndex(game, entry);
+
+	for(auto it = filterDataDecl.begin(); it != filterDataDecl.end(); ++it)
+	{
+		// unknown keys can't be filtered for, so they don't need a bitmap
+		std::string key = getIndexableKey(game, it->type, false);
+		entry.keys[it->type][0] = key == UNKNOWN_LABEL ? NULL : &mPostings[it->type][key];
+
+		entry.keys[it->type][1] = NULL;
+		if(it->hasSecondaryKey)
+		{
+			std::string secKey = getIndexableKey(game, it->type, true);
+			if(secKey != UNKNOWN_LABEL && secKey != key)
+				entry.keys[it->type][1] = &mPostings[it->type][secKey];
+		}
+
+		for(int i = 0; i < 2; i++)
+		{
+			if(entry.keys[it->type][i])
+				entry.keys[it->type][i]->set(id);
+		}
+	}
+
+	if(!mShownDirty && matchesFilters(id))
+		mShown.set(id);
+}
+
+void FileFilterIndex::unpostGame(FileData* game)
+{
+	if(game->getFilterId() < 0)
+		return;
+
+	unsigned int id = game->getFilterId();
+	IndexedGame& entry = mGames[id];
+	for(int i = 0; i < entry.countedSize; i++)
+	{
+		if(--(entry.counted[i]->second) <= 0)
+			mAllIndexKeys[entry.countedType[i]]->erase(entry.counted[i]);
+	}
+	entry.countedSize = 0;
+
+	for(int type = 0; type < FILTER_TYPES; type++)
+	{
+		for(int i = 0; i < 2; i++)
+		{
+			if(entry.keys[type][i])
+				entry.keys[type][i]->clear(id);
+		}
+	}
+
+	mShown.clear(id);
+	mFreeIds.push_back(id);
+	game->setFilterId(-1);
+}
+
+bool FileFilterIndex::matchesFilters(unsigned int id)
+{
+	for(auto it = filterDataDecl.begin(); it != filterDataDecl.end(); ++it)
+	{
+		if(!*(it->filteredByRef))
+			continue;
+
+		bool match = false;
+		for(auto key = it->currentFilteredKeys->begin(); key != it->currentFilteredKeys->end() && !match; ++key)
+		{
+			auto posting = mPostings[it->type].find(*key);
+			match = posting != mPostings[it->type].end() && posting->second.test(id);
+		}
+
+		if(!match)
+			return false;
+	}
+
+	return true;
+}
+
+void FileFilterIndex::updateShown()
+{
+	if(!mShownDirty)
+		return;
+	mShownDirty = false;
+
+	bool first = true;
+	mShown.reset();
+	for(auto it = filterDataDecl.begin(); it != filterDataDecl.end(); ++it)
+	{
+		if(!*(it->filteredByRef))
+			continue;
+
+		IdBitmap matches;
+		for(auto key = it->currentFilteredKeys->begin(); key != it->currentFilteredKeys->end(); ++key)
+		{
+			auto posting = mPostings[it->type].find(*key);
+			if(posting != mPostings[it->type].end())
+				matches.orWith(posting->second);
+		}
+
+		if(first)
+			mShown = matches;
+		else
+			mShown.andWith(matches);
+		first = false;
+	}
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
@@ -154,6 +302,8 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 			}
 		}
 	}
+	mShownDirty = true;
+	mDisplayedCountsDirty = true;
 	return;
 }
 
@@ -165,9 +315,21 @@ void FileFilterIndex::clearAllFilters()
 		*(filterData.filteredByRef) = false;
 		filterData.currentFilteredKeys->clear();
 	}
+	mShownDirty = true;
+	mDisplayedCountsDirty = true;
 	return;
 }
 
+void FileFilterIndex::updateDisplayedCounts()
+{
+	if(!mDisplayedCountsDirty || !mRootFolder)
+		return;
+
+	// cleared first, showFile() uses the counts for folders
+	mDisplayedCountsDirty = false;
+	mRootFolder->refreshDisplayedCounts(this);
+}
+
 void FileFilterIndex::debugPrintIndexes()
 {
 	LOG(LogError) << "Printing Indexes...";
@@ -194,53 +356,18 @@ bool FileFilterIndex::showFile(FileData* game)
 	if (!isFiltered())
 		return true;
 
-	// if folder, needs further inspection - i.e. see if folder contains at least one element
-	// that should be shown
+	// if folder, it's shown if there's at least one game under it that is
 	if (game->getType() == FOLDER) {
-		std::vector<FileData*> children = game->getChildren();
-		// iterate through all of the children, until there's a match
-
-		for (std::vector<FileData*>::iterator it = children.begin(); it != children.end(); ++it ) {
-			if (showFile(*it))
-			{
-				return true;
-			}
-		}
-		return false;
+		updateDisplayedCounts();
+		return game->getDisplayedGameCount() > 0;
 	}
 
-	bool keepGoing = false;
-
-	for (std::vector<FilterDataDecl>::iterator it = filterDataDecl.begin(); it != filterDataDecl.end(); ++it ) {
-		FilterDataDecl filterData = (*it);
-		if(*(filterData.filteredByRef))
-		{
-			// try to find a match
-			std::string key = getIndexableKey(game, filterData.type, false);
-			keepGoing = isKeyBeingFilteredBy(key, filterData.type);
+	// games that were never indexed (no gamelist entry) are indexed now
+	if (game->getFilterId() < 0)
+		postGame(game);
 
-			// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
-			if (!keepGoing)
-			{
-				if (!filterData.hasSecondaryKey)
-				{
-					return false;
-				}
-				std::string secKey = getIndexableKey(game, filterData.type, true);
-				if (secKey != UNKNOWN_LABEL)
-				{
-					keepGoing = isKeyBeingFilteredBy(secKey, filterData.type);
-				}
-			}
-			// if still nothing, then it's not a match
-			if (!keepGoing)
-				return false;
-
-		}
-
-	}
-
-	return keepGoing;
+	updateShown();
+	return mShown.test(game->getFilterId());
 }
 
 bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
@@ -266,7 +393,7 @@ bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type
 	return false;
 }
 
-void FileFilterIndex::manageGenreEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageGenreEntryInIndex(FileData* game, IndexedGame& entry)
 {
 
 	std::string key = getIndexableKey(game, GENRE_FILTER, false);
@@ -280,16 +407,16 @@ void FileFilterIndex::manageGenreEntryInIndex(FileData* game, bool remove)
 		return;
 	}
 
-	manageIndexEntry(&genreIndexAllKeys, key, remove);
+	manageIndexEntry(GENRE_FILTER, key, entry);
 
 	key = getIndexableKey(game, GENRE_FILTER, true);
 	if (!includeUnknown && key == UNKNOWN_LABEL)
 	{
-		manageIndexEntry(&genreIndexAllKeys, key, remove);
+		manageIndexEntry(GENRE_FILTER, key, entry);
 	}
 }
 
-void FileFilterIndex::managePlayerEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::managePlayerEntryInIndex(FileData* game, IndexedGame& entry)
 {
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
@@ -301,10 +428,10 @@ void FileFilterIndex::managePlayerEntryInIndex(FileData* game, bool remove)
 		return;
 	}
 
-	manageIndexEntry(&playersIndexAllKeys, key, remove);
+	manageIndexEntry(PLAYER_FILTER, key, entry);
 }
 
-void FileFilterIndex::managePubDevEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::managePubDevEntryInIndex(FileData* game, IndexedGame& entry)
 {
 	std::string pub = getIndexableKey(game, PUBDEV_FILTER, false);
 	std::string dev = getIndexableKey(game, PUBDEV_FILTER, true);
@@ -328,22 +455,22 @@ void FileFilterIndex::managePubDevEntryInIndex(FileData* game, bool remove)
 
 	if (unknownDev && unknownPub) {
 		// if no info at all
-		manageIndexEntry(&pubDevIndexAllKeys, pub, remove);
+		manageIndexEntry(PUBDEV_FILTER, pub, entry);
 	}
 	else
 	{
 		if (!unknownDev) {
 			// if no info at all
-			manageIndexEntry(&pubDevIndexAllKeys, dev, remove);
+			manageIndexEntry(PUBDEV_FILTER, dev, entry);
 		}
 		if (!unknownPub) {
 			// if no info at all
-			manageIndexEntry(&pubDevIndexAllKeys, pub, remove);
+			manageIndexEntry(PUBDEV_FILTER, pub, entry);
 		}
 	}
 }
 
-void FileFilterIndex::manageRatingsEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageRatingsEntryInIndex(FileData* game, IndexedGame& entry)
 {
 	std::string key = getIndexableKey(game, RATINGS_FILTER, false);
 
@@ -355,10 +482,10 @@ void FileFilterIndex::manageRatingsEntryInIndex(FileData* game, bool remove)
 		return;
 	}
 
-	manageIndexEntry(&ratingsIndexAllKeys, key, remove);
+	manageIndexEntry(RATINGS_FILTER, key, entry);
 }
 
-void FileFilterIndex::manageFavoritesEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageFavoritesEntryInIndex(FileData* game, IndexedGame& entry)
 {
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
@@ -368,40 +495,21 @@ void FileFilterIndex::manageFavoritesEntryInIndex(FileData* game, bool remove)
 		return;
 	}
 
-	manageIndexEntry(&favoritesIndexAllKeys, key, remove);
+	manageIndexEntry(FAVORITES_FILTER, key, entry);
 }
 
-void FileFilterIndex::manageIndexEntry(std::map<std::string, int>* index, std::string key, bool remove) {
+void FileFilterIndex::manageIndexEntry(FilterIndexType type, std::string key, IndexedGame& entry) {
 	bool includeUnknown = INCLUDE_UNKNOWN;
 	if (!includeUnknown && key == UNKNOWN_LABEL)
 		return;
-	if (remove) {
-		// removing entry
-		if (index->find(key) == index->end())
-		{
-			// this shouldn't happen
-			LOG(LogInfo) << "Couldn't find entry in index! " << key;
-		}
-		else
-		{
-			(index->at(key))--;
-			if(index->at(key) <= 0) {
-				index->erase(key);
-			}
-		}
-	}
-	else
-	{
-		// adding entry
-		if (index->find(key) == index->end())
-		{
-			(*index)[key] = 1;
-		}
-		else
-		{
-			(index->at(key))++;
-		}
-	}
+
+	// adding entry
+	assert(entry.countedSize < MAX_COUNTED);
+	auto it = mAllIndexKeys[type]->insert(std::make_pair(key, 0)).first;
+	it->second++;
+	entry.counted[entry.countedSize] = it;
+	entry.countedType[entry.countedSize] = type;
+	entry.countedSize++;
 }
 
 void FileFilterIndex::clearIndex(std::map<std::string, int> indexMap)
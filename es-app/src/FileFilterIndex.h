@@ -1,6 +1,8 @@
 #pragma once
 
 #include <map>
+#include <vector>
+#include <stdint.h>
 #include "FileData.h"
 #include "Log.h"
 #include <boost/math/special_functions/round.hpp>
@@ -31,6 +33,22 @@ struct FilterDataDecl
 	std::string menuLabel; // text to show in menu
 };
 
+// One bit per game id, so whole filters can be combined a word at a time.
+class IdBitmap
+{
+public:
+	inline void set(unsigned int id) { if(id / 64 >= mWords.size()) mWords.resize(id / 64 + 1, 0); mWords[id / 64] |= (uint64_t)1 << (id % 64); }
+	inline void clear(unsigned int id) { if(id / 64 < mWords.size()) mWords[id / 64] &= ~((uint64_t)1 << (id % 64)); }
+	inline bool test(unsigned int id) const { return id / 64 < mWords.size() && ((mWords[id / 64] >> (id % 64)) & 1); }
+	inline void reset() { mWords.clear(); }
+
+	void orWith(const IdBitmap& other);
+	void andWith(const IdBitmap& other);
+
+private:
+	std::vector<uint64_t> mWords;
+};
+
 class FileFilterIndex
 {
 public:
@@ -45,17 +63,49 @@ public:
 	bool isFiltered() { return (filterByGenre || filterByPlayers || filterByPubDev || filterByRatings || filterByFavorites); };
 	bool isKeyBeingFilteredBy(std::string key, FilterIndexType type);
 	std::vector<FilterDataDecl>& getFilterDataDecls();
+
+	// the tree whose displayed game counts follow this index's filters
+	inline void setRootFolder(FileData* root) { mRootFolder = root; mDisplayedCountsDirty = true; };
+	// recounts the displayed games if the filters changed since the last time, O(1) otherwise
+	void updateDisplayedCounts();
 private:
+	static const int FILTER_TYPES = FAVORITES_FILTER + 1;
+	static const int MAX_COUNTED = 8; // one key per type, two for pubdev
+
 	std::vector<FilterDataDecl> filterDataDecl;
 	std::string getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary);
 
-	void manageGenreEntryInIndex(FileData* game, bool remove = false);
-	void managePlayerEntryInIndex(FileData* game, bool remove = false);
-	void managePubDevEntryInIndex(FileData* game, bool remove = false);
-	void manageRatingsEntryInIndex(FileData* game, bool remove = false);
-	void manageFavoritesEntryInIndex(FileData* game, bool remove = false);
+	// Each indexed game gets a dense id and is added to the bitmap of every key it matches on,
+	// so applying the filters is an OR over the selected keys of each type and an AND across types.
+	struct IndexedGame
+	{
+		IdBitmap* keys[FILTER_TYPES][2]; // the postings it's in, primary and secondary key
+		// the *IndexAllKeys entries it's counted in, so it can be taken out again after its metadata
+		// has changed (a collection entry's changes along with its game's)
+		std::map<std::string, int>::iterator counted[MAX_COUNTED];
+		unsigned char countedType[MAX_COUNTED];
+		unsigned char countedSize;
+	};
+
+	void postGame(FileData* game);
+	void unpostGame(FileData* game);
+	bool matchesFilters(unsigned int id);
+	void updateShown();
+
+	std::map<std::string, IdBitmap> mPostings[FILTER_TYPES];
+	std::vector<IndexedGame> mGames; // by id
+	std::vector<unsigned int> mFreeIds;
+	IdBitmap mShown; // ids that pass the current filters
+	bool mShownDirty;
+
+	void manageGenreEntryInIndex(FileData* game, IndexedGame& entry);
+	void managePlayerEntryInIndex(FileData* game, IndexedGame& entry);
+	void managePubDevEntryInIndex(FileData* game, IndexedGame& entry);
+	void manageRatingsEntryInIndex(FileData* game, IndexedGame& entry);
+	void manageFavoritesEntryInIndex(FileData* game, IndexedGame& entry);
 
-	void manageIndexEntry(std::map<std::string, int>* index, std::string key, bool remove);
+	void manageIndexEntry(FilterIndexType type, std::string key, IndexedGame& entry);
+	std::map<std::string, int>* mAllIndexKeys[FILTER_TYPES]; // by type
 
 	void clearIndex(std::map<std::string, int> indexMap);
 
@@ -78,5 +128,6 @@ private:
 	std::vector<std::string> favoritesIndexFilteredKeys;
 
 	FileData* mRootFolder;
+	bool mDisplayedCountsDirty;
 
 };
\ No newline at end of file
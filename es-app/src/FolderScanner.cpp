@@ -0,0 +1,208 @@
+#include "FolderScanner.h"
+#include "ThreadPool.h"
+#include "Log.h"
+#include <chrono>
+#include <string.h>
+#include <sys/stat.h>
+#include <boost/filesystem.hpp>
+
+#ifndef WIN32
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+// listing mostly waits on the disk, so there are more of these than cores
+#define SCAN_THREADS 8
+
+FolderScanner::FolderScanner(const std::vector<std::string>& extensions, bool showHidden) :
+	mExtensions(extensions.begin(), extensions.end()), mShowHidden(showHidden), mRecursive(true), mPending(0), mFolderCount(0), mEntryCount(0)
+{
+	mStats.folders = 0;
+	mStats.entries = 0;
+	mStats.seconds = 0;
+}
+
+ThreadPool* FolderScanner::getPool()
+{
+	// its own, the shared pool is sized for CPU bound work
+	static ThreadPool* pool = new ThreadPool(SCAN_THREADS);
+	return pool;
+}
+
+std::unique_ptr<FolderScanner::Folder> FolderScanner::scan(const std::string& path, bool recursive)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	boost::system::error_code ec;
+	if(!fs::is_directory(path, ec))
+		return NULL;
+
+	std::unique_ptr<Folder> root(new Folder());
+	root->path = path;
+	root->time = 0;
+	root->listed = false;
+
+	mRecursive = recursive;
+	mFolderCount = 0;
+	mEntryCount = 0;
+	queue(root.get());
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [this] { return mPending == 0; });
+	}
+
+	mStats.folders = mFolderCount;
+	mStats.entries = mEntryCount;
+	mStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return root;
+}
+
+void FolderScanner::queue(Folder* folder)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mPending++;
+	}
+
+	getPool()->queueWorkItem([this, folder] {
+		list(folder);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		if(--mPending == 0)
+			mDone.notify_all();
+	});
+}
+
+// Names are split the way boost::filesystem's stem() and extension() do it, so ".nes" has no
+// stem and is skipped like the directory_iterator version did.
+void FolderScanner::list(Folder* folder)
+{
+	std::string prefix = folder->path;
+	if(prefix.empty() || prefix[prefix.size() - 1] != '/')
+		prefix += '/';
+
+	std::vector<Folder*> subfolders;
+
+#ifndef WIN32
+	DIR* dir = opendir(folder->path.c_str());
+	if(!dir)
+	{
+		LOG(LogWarning) << "Could not list folder \"" << folder->path << "\"";
+		return;
+	}
+
+	struct stat info;
+	if(fstat(dirfd(dir), &info) == 0)
+		folder->time = info.st_mtime;
+
+	unsigned int entries = 0;
+	while(struct dirent* entry = readdir(dir))
+	{
+		const char* name = entry->d_name;
+		if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+			continue;
+
+		entries++;
+		const char* dot = strrchr(name, '.');
+		if(dot == name)
+			continue; // no stem
+
+		if(dot && mExtensions.find(dot) != mExtensions.end())
+		{
+			// folders can match the extension too, that's how higan's are added as games
+			if(!mShowHidden && name[0] == '.')
+				continue;
+
+			Folder::Entry game;
+			game.name = name;
+			folder->entries.push_back(std::move(game));
+			continue;
+		}
+
+		// only file systems that don't say, and links, need a stat
+		const std::string path = prefix + name;
+		bool isDir = entry->d_type == DT_DIR;
+		bool isLink = entry->d_type == DT_LNK;
+		if(entry->d_type == DT_UNKNOWN)
+		{
+			if(lstat(path.c_str(), &info) != 0)
+				continue;
+			isDir = S_ISDIR(info.st_mode);
+			isLink = S_ISLNK(info.st_mode);
+		}
+
+		if(isLink)
+		{
+			if(stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+				continue;
+
+			// if this symlink resolves to somewhere that's at the beginning of our path, it's gonna recurse
+			char resolved[PATH_MAX];
+			if(realpath(path.c_str(), resolved) && path.find(fs::path(resolved).generic_string()) == 0)
+			{
+				LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << path << "\"";
+				continue;
+			}
+			isDir = true;
+		}
+
+		if(!isDir)
+			continue;
+
+		Folder::Entry sub;
+		sub.name = name;
+		sub.folder.reset(new Folder());
+		sub.folder->path = path;
+		sub.folder->time = 0;
+		sub.folder->listed = false;
+		subfolders.push_back(sub.folder.get());
+		folder->entries.push_back(std::move(sub));
+	}
+	closedir(dir);
+	folder->listed = true;
+#else
+	boost::system::error_code ec;
+	folder->time = fs::last_write_time(folder->path, ec);
+
+	unsigned int entries = 0;
+	fs::directory_iterator end, dir(folder->path, ec);
+	for(; !ec && dir != end; dir.increment(ec))
+	{
+		const fs::path& filePath = (*dir).path();
+		entries++;
+		if(filePath.stem().empty())
+			continue;
+
+		Folder::Entry entry;
+		entry.name = filePath.filename().string();
+		if(mExtensions.find(filePath.extension().string()) == mExtensions.end())
+		{
+			boost::system::error_code typeError;
+			if(!fs::is_directory(filePath, typeError))
+				continue;
+
+			entry.folder.reset(new Folder());
+			entry.folder->path = prefix + entry.name;
+			entry.folder->time = 0;
+			entry.folder->listed = false;
+			subfolders.push_back(entry.folder.get());
+		}
+		folder->entries.push_back(std::move(entry));
+	}
+	folder->listed = !ec;
+#endif
+
+	mFolderCount++;
+	mEntryCount += entries;
+
+	if(!mRecursive)
+		return;
+
+	// queued once the listing is done, they only touch their own Folder
+	for(auto it = subfolders.begin(); it != subfolders.end(); it++)
+		queue(*it);
+}
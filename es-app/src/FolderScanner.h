@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <ctime>
+#include <unordered_set>
+
+class ThreadPool;
+
+// Lists a folder and everything under it, picking out games by extension. Each folder is listed on
+// its own thread as soon as its parent has found it, since on network shares and SD cards the time
+// goes on waiting for the disk. Entry types come from the directory listing itself where the file
+// system gives them, so most entries don't need a stat. Only builds a plain tree of names, turning
+// it into FileData is left to the system, whose arena isn't thread safe.
+class FolderScanner
+{
+public:
+	struct Folder
+	{
+		struct Entry
+		{
+			std::string name;
+			std::unique_ptr<Folder> folder; // NULL for a game
+		};
+
+		std::string path;
+		std::time_t time; // modification time
+		bool listed; // false if it couldn't be listed, entries is empty then
+		std::vector<Entry> entries; // in listing order
+	};
+
+	struct Stats
+	{
+		unsigned int folders;
+		unsigned int entries; // everything listed, games or not
+		double seconds;
+	};
+
+	FolderScanner(const std::vector<std::string>& extensions, bool showHidden);
+
+	// Blocks until everything under path has been listed, or only path itself if not recursive (its
+	// subfolders are there, but empty). NULL if path isn't a folder.
+	std::unique_ptr<Folder> scan(const std::string& path, bool recursive = true);
+	inline const Stats& getStats() const { return mStats; }
+
+private:
+	static ThreadPool* getPool();
+
+	void queue(Folder* folder);
+	void list(Folder* folder);
+
+	std::unordered_set<std::string> mExtensions;
+	bool mShowHidden;
+	bool mRecursive;
+
+	std::mutex mMutex;
+	std::condition_variable mDone;
+	unsigned int mPending; // folders queued or being listed
+
+	std::atomic<unsigned int> mFolderCount;
+	std::atomic<unsigned int> mEntryCount;
+	Stats mStats;
+};
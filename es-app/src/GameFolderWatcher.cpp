@@ -0,0 +1,199 @@
+#include "GameFolderWatcher.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include "Log.h"
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// how long the folders have to be quiet before they're re-listed, in ms
+#define SETTLE_TIME 500
+
+GameFolderWatcher* GameFolderWatcher::sInstance = NULL;
+
+GameFolderWatcher* GameFolderWatcher::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new GameFolderWatcher();
+
+	return sInstance;
+}
+
+GameFolderWatcher::GameFolderWatcher() : mEnabled(false), mFd(-1), mRescanAll(false), mQuietTime(0)
+{
+}
+
+void GameFolderWatcher::watchSystems()
+{
+	stop();
+	mEnabled = Settings::getInstance()->getBool("WatchGameFolders");
+	if(!mEnabled)
+		return;
+
+#ifdef __linux__
+	mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(mFd < 0)
+	{
+		LOG(LogWarning) << "Could not watch the game folders (" << strerror(errno) << "), they'll only be checked after running a game";
+		return;
+	}
+
+	for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
+	{
+		if(!(*it)->isCollection())
+			addWatches(*it);
+	}
+
+	LOG(LogInfo) << "Watching " << mWatches.size() << " game folders for changes";
+#endif
+}
+
+void GameFolderWatcher::stop()
+{
+#ifdef __linux__
+	if(mFd >= 0)
+		close(mFd);
+#endif
+
+	mFd = -1;
+	mEnabled = false;
+	mWatches.clear();
+	mWatchedPaths.clear();
+	mChanged.clear();
+	mRescanAll = false;
+}
+
+void GameFolderWatcher::rescanSoon()
+{
+	if(!mEnabled)
+		return;
+
+	mRescanAll = true;
+	mQuietTime = SETTLE_TIME;
+}
+
+void GameFolderWatcher::addWatches(SystemData* system)
+{
+#ifdef __linux__
+	const std::unordered_map<std::string, std::time_t>& folders = system->getFolderTimes();
+	for(auto it = folders.begin(); it != folders.end(); it++)
+	{
+		auto watched = mWatchedPaths.find(it->first);
+		int wd;
+		if(watched != mWatchedPaths.end())
+		{
+			wd = watched->second;
+		}else{
+			wd = inotify_add_watch(mFd, it->first.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+			if(wd < 0)
+			{
+				// most likely out of watches (fs.inotify.max_user_watches), what isn't watched is
+				// still picked up by the modification time check after a game
+				if(errno == ENOSPC)
+				{
+					LOG(LogWarning) << "Ran out of inotify watches after " << mWatches.size() << " game folders";
+					return;
+				}
+				continue;
+			}
+
+			mWatchedPaths[it->first] = wd;
+			mWatches[wd].path = it->first;
+		}
+
+		std::vector<SystemData*>& systems = mWatches[wd].systems;
+		if(std::find(systems.begin(), systems.end(), system) == systems.end())
+			systems.push_back(system);
+	}
+#endif
+}
+
+void GameFolderWatcher::readEvents()
+{
+#ifdef __linux__
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	while(true)
+	{
+		ssize_t length = read(mFd, buffer, sizeof(buffer));
+		if(length <= 0)
+			break; // EAGAIN, nothing left
+
+		for(char* ptr = buffer; ptr < buffer + length; )
+		{
+			const struct inotify_event* event = (const struct inotify_event*)ptr;
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if(event->mask & IN_Q_OVERFLOW)
+			{
+				// we don't know what was missed, check everything
+				mRescanAll = true;
+				mQuietTime = 0;
+				continue;
+			}
+
+			auto watch = mWatches.find(event->wd);
+			if(watch == mWatches.end())
+				continue;
+
+			mQuietTime = 0;
+			for(auto it = watch->second.systems.begin(); it != watch->second.systems.end(); it++)
+				mChanged[*it].insert(watch->second.path);
+
+			if(event->mask & IN_IGNORED)
+			{
+				// deleted, or unwatched below, a folder that's made again with that name gets a new watch
+				mWatchedPaths.erase(watch->second.path);
+				mWatches.erase(watch);
+			}else if(event->mask & IN_MOVE_SELF)
+			{
+				// it isn't at that path anymore, its parent's listing picks it up wherever it went
+				inotify_rm_watch(mFd, event->wd);
+			}
+		}
+	}
+#endif
+}
+
+void GameFolderWatcher::update(int deltaTime, bool idle)
+{
+	if(mFd >= 0)
+		readEvents();
+
+	if(mChanged.empty() && !mRescanAll)
+		return;
+
+	mQuietTime += deltaTime;
+	if(mQuietTime < SETTLE_TIME || !idle)
+		return;
+
+	if(mRescanAll)
+	{
+		for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
+		{
+			if(!(*it)->isCollection())
+				(*it)->rescanChangedFolders();
+		}
+	}else{
+		for(auto it = mChanged.begin(); it != mChanged.end(); it++)
+			it->first->rescanFolders(std::vector<std::string>(it->second.begin(), it->second.end()));
+	}
+
+	mChanged.clear();
+	mRescanAll = false;
+	mQuietTime = 0;
+
+	// folders that were listed for the first time
+	if(mFd >= 0)
+	{
+		for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
+		{
+			if(!(*it)->isCollection())
+				addWatches(*it);
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class SystemData;
+
+// Keeps the gamelists in step with the game folders while we're running. Every folder a system
+// listed is watched with inotify, and folders that had something added, removed or renamed are
+// re-listed with SystemData::rescanFolders() once they've been quiet for a moment, so copying a
+// folder of games over is one rescan rather than one per file. If events were dropped, and after
+// a game was run, SystemData::rescanChangedFolders() compares folder modification times instead.
+// Changes wait while anything is open over the gamelists, since menus can hold on to games.
+class GameFolderWatcher
+{
+public:
+	static GameFolderWatcher* getInstance();
+
+	void watchSystems(); // (re)starts watching every game system, nothing if WatchGameFolders is off
+	void stop();
+	void rescanSoon(); // check every folder's modification time at the next update()
+
+	// idle is true while nothing is open over the gamelists, changes are only applied then
+	void update(int deltaTime, bool idle);
+
+private:
+	GameFolderWatcher();
+
+	static GameFolderWatcher* sInstance;
+
+	void addWatches(SystemData* system);
+	void readEvents();
+
+	struct Watch
+	{
+		std::string path;
+		std::vector<SystemData*> systems; // more than one can share a folder
+	};
+
+	bool mEnabled;
+	int mFd; // inotify, -1 if we aren't watching
+	std::unordered_map<int, Watch> mWatches; // by watch descriptor
+	std::unordered_map<std::string, int> mWatchedPaths;
+	std::map< SystemData*, std::set<std::string> > mChanged; // folders to re-list, parents first
+	bool mRescanAll;
+	int mQuietTime; // ms since the last change
+};
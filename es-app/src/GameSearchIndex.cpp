@@ -0,0 +1,398 @@
+#include "GameSearchIndex.h"
+#include "FileData.h"
+#include "SystemData.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstring>
+
+GameSearchIndex* GameSearchIndex::sInstance = NULL;
+
+// only the end of an index that has more than this many removed games is worth compacting
+#define MIN_DEAD_TO_COMPACT 1024
+
+// a game's text is cut off after this many bytes
+#define MAX_TEXT_LENGTH 0xFFFF
+
+// Lower case words, each with a space in front of it so " mar" only matches the start of a word.
+// Anything that isn't a letter or digit splits words, bytes of UTF-8 characters are kept as they are.
+static void appendNormalized(const std::string& str, std::string& out)
+{
+	bool inWord = false;
+	for(unsigned int i = 0; i < str.size(); i++)
+	{
+		unsigned char c = str[i];
+		if(c >= 'A' && c <= 'Z')
+		{
+			c = c - 'A' + 'a';
+		}else if(!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9') && c < 0x80)
+		{
+			inWord = false;
+			continue;
+		}
+
+		if(!inWord)
+			out += ' ';
+		out += c;
+		inWord = true;
+	}
+}
+
+static inline uint32_t makeKey(unsigned char a, unsigned char b, unsigned char c)
+{
+	return (a << 16) | (b << 8) | c;
+}
+
+// the keys a game must have to match pattern, a word with a space in front of it
+static void getPatternKeys(const std::string& pattern, std::vector<uint32_t>& keys)
+{
+	if(pattern.size() == 2)
+	{
+		keys.push_back(makeKey(' ', pattern[1], 0));
+		return;
+	}
+
+	for(unsigned int i = 0; i + 2 < pattern.size(); i++)
+		keys.push_back(makeKey(pattern[i], pattern[i + 1], pattern[i + 2]));
+}
+
+// position of pattern in text, -1 if it isn't there
+static int findPattern(const char* text, unsigned int length, const std::string& pattern)
+{
+	const char* found = std::search(text, text + length, pattern.begin(), pattern.end());
+	return found == text + length ? -1 : (int)(found - text);
+}
+
+// leaves the ids that are in both, both have to be ascending
+static void intersect(std::vector<uint32_t>& ids, const std::vector<uint32_t>& postings)
+{
+	auto out = ids.begin();
+	if(ids.size() * 16 < postings.size())
+	{
+		// a few ids against a long list, look each one up
+		auto pos = postings.begin();
+		for(auto it = ids.begin(); it != ids.end(); it++)
+		{
+			pos = std::lower_bound(pos, postings.end(), *it);
+			if(pos == postings.end())
+				break;
+			if(*pos == *it)
+				*out++ = *it;
+		}
+	}else{
+		auto pos = postings.begin();
+		for(auto it = ids.begin(); it != ids.end() && pos != postings.end(); it++)
+		{
+			while(pos != postings.end() && *pos < *it)
+				pos++;
+			if(pos != postings.end() && *pos == *it)
+				*out++ = *it;
+		}
+	}
+
+	ids.erase(out, ids.end());
+}
+
+GameSearchIndex* GameSearchIndex::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new GameSearchIndex();
+
+	return sInstance;
+}
+
+GameSearchIndex::GameSearchIndex() : mDeadCount(0), mNamesDirty(false), mGeneration(0), mCachedGeneration(0)
+{
+}
+
+void GameSearchIndex::addGames(FileData* root)
+{
+	addGames(root->getFilesRecursive(GAME));
+}
+
+void GameSearchIndex::addGames(const std::vector<FileData*>& games)
+{
+	if(games.empty())
+		return;
+
+	// sorted once by the next search instead of once per game
+	mNamesDirty = true;
+
+	for(auto it = games.begin(); it != games.end(); it++)
+		addGame(*it);
+}
+
+void GameSearchIndex::updateGame(FileData* game)
+{
+	if(game->getSearchId() < 0)
+		return;
+
+	// it gets a new id, the old one's keys are left behind until the next compact()
+	removeGame(game);
+	addGame(game);
+}
+
+void GameSearchIndex::removeGame(FileData* game)
+{
+	int id = game->getSearchId();
+	if(id < 0)
+		return;
+
+	// it's left in mByName with its text, so that stays sorted and this stays O(1) when a whole system is deleted
+	mEntries.at(id).game = NULL;
+	game->setSearchId(-1);
+
+	mDeadCount++;
+	mGeneration++;
+}
+
+void GameSearchIndex::addGame(FileData* game)
+{
+	std::string text;
+	appendNormalized(game->metadata.get("name"), text);
+	const size_t nameLength = std::min(text.size(), (size_t)MAX_TEXT_LENGTH);
+	text += '\t';
+	appendNormalized(game->metadata.get("developer"), text);
+	appendNormalized(game->metadata.get("publisher"), text);
+	appendNormalized(game->metadata.get("genre"), text);
+	if(text.size() > MAX_TEXT_LENGTH)
+		text.resize(MAX_TEXT_LENGTH);
+
+	uint32_t id = (uint32_t)mEntries.size();
+	Entry entry;
+	entry.game = game;
+	entry.system = game->getSystem();
+	entry.textStart = (unsigned int)mText.size();
+	entry.nameLength = (unsigned short)nameLength;
+	entry.textLength = (unsigned short)text.size();
+	entry.order = 0;
+	mEntries.push_back(entry);
+	mText.insert(mText.end(), text.begin(), text.end());
+
+	game->setSearchId(id);
+	addKeys(id);
+
+	if(!mNamesDirty)
+	{
+		// put it in its place, everything after it moves down one
+		auto pos = std::upper_bound(mByName.begin(), mByName.end(), id, [this](uint32_t a, uint32_t b) {
+			return compareNames(mEntries[a], mEntries[b]) < 0;
+		});
+		pos = mByName.insert(pos, id);
+		for(auto it = pos; it != mByName.end(); it++)
+			mEntries[*it].order = (unsigned int)(it - mByName.begin());
+	}
+
+	mGeneration++;
+}
+
+void GameSearchIndex::addKeys(unsigned int id)
+{
+	const Entry& entry = mEntries[id];
+	const char* text = &mText[entry.textStart];
+	const unsigned int length = entry.textLength;
+
+	std::vector<uint32_t> keys;
+	for(unsigned int i = 0; i < length; i++)
+	{
+		// one or two letters typed only match the start of a word, longer words are made of three letter keys
+		if(text[i] == ' ' && i + 1 < length)
+			keys.push_back(makeKey(' ', text[i + 1], 0));
+
+		if(i + 2 < length && text[i + 1] != ' ' && text[i + 2] != ' ' && text[i] != '\t' && text[i + 1] != '\t' && text[i + 2] != '\t')
+			keys.push_back(makeKey(text[i], text[i + 1], text[i + 2]));
+	}
+
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+	// ids are handed out in increasing order, so the lists stay sorted
+	for(auto it = keys.begin(); it != keys.end(); it++)
+		mPostings[*it].push_back(id);
+}
+
+void GameSearchIndex::compact()
+{
+	LOG(LogDebug) << "Compacting game search index, " << mDeadCount << " of " << mEntries.size() << " entries were removed";
+
+	std::vector<Entry> entries;
+	std::vector<char> text;
+	entries.reserve(mEntries.size() - mDeadCount);
+	for(auto it = mEntries.begin(); it != mEntries.end(); it++)
+	{
+		if(it->game == NULL)
+			continue;
+
+		it->game->setSearchId((int)entries.size());
+		text.insert(text.end(), mText.begin() + it->textStart, mText.begin() + it->textStart + it->textLength);
+		it->textStart = (unsigned int)(text.size() - it->textLength);
+		entries.push_back(*it);
+	}
+
+	mEntries.swap(entries);
+	mText.swap(text);
+	mDeadCount = 0;
+
+	mPostings.clear();
+	for(unsigned int id = 0; id < mEntries.size(); id++)
+		addKeys(id);
+
+	mNamesDirty = true;
+	mGeneration++;
+}
+
+int GameSearchIndex::compareNames(const Entry& a, const Entry& b) const
+{
+	int cmp = memcmp(&mText[a.textStart], &mText[b.textStart], std::min(a.nameLength, b.nameLength));
+	return cmp != 0 ? cmp : (int)a.nameLength - (int)b.nameLength;
+}
+
+void GameSearchIndex::sortNames()
+{
+	mByName.clear();
+	for(uint32_t id = 0; id < mEntries.size(); id++)
+	{
+		if(mEntries[id].game != NULL)
+			mByName.push_back(id);
+	}
+
+	std::sort(mByName.begin(), mByName.end(), [this](uint32_t a, uint32_t b) {
+		int cmp = compareNames(mEntries[a], mEntries[b]);
+		return cmp != 0 ? cmp < 0 : a < b;
+	});
+
+	for(unsigned int i = 0; i < mByName.size(); i++)
+		mEntries[mByName[i]].order = i;
+
+	mNamesDirty = false;
+}
+
+unsigned int GameSearchIndex::rankMatch(const Entry& entry, const std::vector<std::string>& patterns) const
+{
+	const char* text = &mText[entry.textStart];
+
+	// the name is first, so a word that's in it is found there before the other fields
+	for(auto it = patterns.begin(); it != patterns.end(); it++)
+	{
+		int pos = findPattern(text, entry.textLength, *it);
+		if(pos < 0 || pos >= entry.nameLength)
+			return 2;
+	}
+
+	const std::string& first = patterns.front();
+	return first.size() <= entry.nameLength && memcmp(text, first.data(), first.size()) == 0 ? 0 : 1;
+}
+
+unsigned int GameSearchIndex::search(const std::string& query, unsigned int maxResults, std::vector<FileData*>& results, SystemData* system)
+{
+	results.clear();
+
+	if(mDeadCount > MIN_DEAD_TO_COMPACT && mDeadCount > mEntries.size() / 2)
+		compact();
+	if(mNamesDirty)
+		sortNames();
+
+	std::string normalized;
+	appendNormalized(query, normalized);
+
+	// " sup mar" -> " sup", " mar"
+	std::vector<std::string> patterns;
+	bool exact = true; // one to two letter words are their own key
+	for(size_t start = 0; start < normalized.size(); )
+	{
+		size_t end = normalized.find(' ', start + 1);
+		if(end == std::string::npos)
+			end = normalized.size();
+		patterns.push_back(normalized.substr(start, end - start));
+		exact = exact && patterns.back().size() <= 3;
+		start = end;
+	}
+
+	if(patterns.empty())
+	{
+		mCachedQuery.clear();
+		return 0;
+	}
+
+	std::vector<uint32_t> keys;
+	for(auto it = patterns.begin(); it != patterns.end(); it++)
+		getPatternKeys(*it, keys);
+
+	std::vector<const std::vector<uint32_t>*> postings;
+	const std::vector<uint32_t>* shortest = NULL;
+	for(auto it = keys.begin(); it != keys.end(); it++)
+	{
+		auto found = mPostings.find(*it);
+		if(found == mPostings.end())
+		{
+			// nothing has this key, so nothing can match
+			postings.clear();
+			shortest = NULL;
+			break;
+		}
+
+		postings.push_back(&found->second);
+		if(shortest == NULL || found->second.size() < shortest->size())
+			shortest = &found->second;
+	}
+
+	// typing more only narrows it down, so the last matches are where this one starts
+	std::vector<uint32_t> matches;
+	const bool narrowing = mCachedGeneration == mGeneration && !mCachedQuery.empty() &&
+		normalized.compare(0, mCachedQuery.size(), mCachedQuery) == 0;
+
+	if(shortest != NULL)
+	{
+		matches = narrowing ? mCachedMatches : *shortest;
+		for(auto it = postings.begin(); it != postings.end(); it++)
+		{
+			if(*it != shortest || narrowing)
+				intersect(matches, **it);
+		}
+
+		// the keys can be in a game without the whole word being there
+		auto out = matches.begin();
+		for(auto it = matches.begin(); it != matches.end(); it++)
+		{
+			const Entry& entry = mEntries[*it];
+			if(entry.game == NULL)
+				continue;
+
+			bool found = true;
+			for(auto pattern = patterns.begin(); pattern != patterns.end() && found && !exact; pattern++)
+				found = findPattern(&mText[entry.textStart], entry.textLength, *pattern) >= 0;
+
+			if(found)
+				*out++ = *it;
+		}
+		matches.erase(out, matches.end());
+	}
+
+	mCachedQuery = normalized;
+	mCachedMatches = matches;
+	mCachedGeneration = mGeneration;
+
+	// rank then name order, both in one number
+	unsigned int count = 0;
+	std::vector< std::pair<uint64_t, uint32_t> > ranked;
+	for(auto it = matches.begin(); it != matches.end(); it++)
+	{
+		const Entry& entry = mEntries[*it];
+		if(system != NULL && entry.system != system)
+			continue;
+
+		FileFilterIndex* filter = entry.system->getIndex();
+		if(filter->isFiltered() && !filter->showFile(entry.game))
+			continue;
+
+		count++;
+		if(maxResults > 0)
+			ranked.push_back(std::make_pair(((uint64_t)rankMatch(entry, patterns) << 32) | entry.order, *it));
+	}
+
+	const size_t shown = std::min((size_t)maxResults, ranked.size());
+	std::partial_sort(ranked.begin(), ranked.begin() + shown, ranked.end());
+	for(size_t i = 0; i < shown; i++)
+		results.push_back(mEntries[ranked[i].second].game);
+
+	return count;
+}
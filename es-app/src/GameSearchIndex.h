@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+class FileData;
+class SystemData;
+
+// Finds games by the start of the words in their name, developer, publisher and genre, so
+// "sup mar" finds "Super Mario World". Built from every game system when they're loaded.
+// Each game's words are broken into three letter keys (" su", "sup", "upe"...) and every key
+// has the sorted list of games that have it, so a query only has to intersect a few short
+// lists and then check what's left. Typing more letters only narrows the last query's matches.
+// This is a singleton, games are taken out when they're deleted and re-indexed with updateGame().
+class GameSearchIndex
+{
+public:
+	static GameSearchIndex* getInstance();
+
+	void addGames(FileData* root); // every game under root
+	void addGames(const std::vector<FileData*>& games);
+	void updateGame(FileData* game); // after its metadata changed, does nothing if it isn't indexed
+	void removeGame(FileData* game); // called by ~FileData
+
+	// Puts up to maxResults of the matching games in results, games whose name starts with the
+	// query first, then ones where the name matches, then anything else, each in name order.
+	// Only games shown with their system's current filters are counted. If system isn't NULL,
+	// only its games are. Returns the number of matches.
+	unsigned int search(const std::string& query, unsigned int maxResults, std::vector<FileData*>& results, SystemData* system = NULL);
+
+	inline unsigned int size() const { return (unsigned int)(mEntries.size() - mDeadCount); }
+
+private:
+	GameSearchIndex();
+
+	static GameSearchIndex* sInstance;
+
+	struct Entry
+	{
+		FileData* game; // NULL once it's been removed, its keys and text are only dropped by compact()
+		SystemData* system;
+		unsigned int textStart; // in mText
+		unsigned short nameLength;
+		unsigned short textLength;
+		unsigned int order; // position in name order, see sortNames()
+	};
+
+	void addGame(FileData* game);
+	void addKeys(unsigned int id);
+	void compact();
+	void sortNames();
+	int compareNames(const Entry& a, const Entry& b) const;
+	unsigned int rankMatch(const Entry& entry, const std::vector<std::string>& patterns) const;
+
+	std::vector<Entry> mEntries; // by id, ids are only given out in increasing order
+	std::vector<char> mText; // each entry's normalized name, a tab, then its other fields, one after the other
+	std::unordered_map<uint32_t, std::vector<uint32_t> > mPostings; // key -> ids, ascending
+	std::vector<uint32_t> mByName; // live ids in name order
+	unsigned int mDeadCount;
+	bool mNamesDirty;
+
+	// the last query's verified matches, reused while the next one only adds to it
+	unsigned int mGeneration; // bumped whenever the index changes
+	unsigned int mCachedGeneration;
+	std::string mCachedQuery;
+	std::vector<uint32_t> mCachedMatches;
+};
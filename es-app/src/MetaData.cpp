@@ -2,6 +2,8 @@
 #include "components/TextComponent.h"
 #include "Log.h"
 #include "Util.h"
+#include <stdexcept>
+#include <unordered_map>
 
 namespace fs = boost::filesystem;
 
@@ -55,14 +57,54 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 	return gameMDD;
 }
 
+static std::unordered_map<std::string, int> makeMDDIndex(const std::vector<MetaDataDecl>& mdd)
+{
+	std::unordered_map<std::string, int> index;
+	for(unsigned int i = 0; i < mdd.size(); i++)
+		index[mdd[i].key] = i;
+	return index;
+}
+
 
 
+std::atomic<unsigned int> MetaDataList::sNextVersion(0);
+
 MetaDataList::MetaDataList(MetaDataListType type)
-	: mType(type), mWasChanged(false)
+	: mType(type), mWasChanged(false), mVersion(++sNextVersion)
 {
-	const std::vector<MetaDataDecl>& mdd = getMDD();
-	for(auto iter = mdd.begin(); iter != mdd.end(); iter++)
-		set(iter->key, iter->defaultValue);
+}
+
+MetaDataList::MetaDataList(const MetaDataList& other)
+	: mType(other.mType), mValues(other.mValues), mOtherValues(other.mOtherValues ? new std::map<std::string, std::string>(*other.mOtherValues) : NULL),
+	mWasChanged(other.mWasChanged), mVersion(++sNextVersion)
+{
+}
+
+MetaDataList::MetaDataList(MetaDataList&& other)
+	: mType(other.mType), mValues(std::move(other.mValues)), mOtherValues(std::move(other.mOtherValues)), mWasChanged(other.mWasChanged),
+	mVersion(++sNextVersion)
+{
+}
+
+// versions aren't copied, a list that's assigned to has changed even if it got an older list's values
+MetaDataList& MetaDataList::operator=(const MetaDataList& other)
+{
+	mType = other.mType;
+	mValues = other.mValues;
+	mOtherValues.reset(other.mOtherValues ? new std::map<std::string, std::string>(*other.mOtherValues) : NULL);
+	mWasChanged = other.mWasChanged;
+	mVersion = ++sNextVersion;
+	return *this;
+}
+
+MetaDataList& MetaDataList::operator=(MetaDataList&& other)
+{
+	mType = other.mType;
+	mValues = std::move(other.mValues);
+	mOtherValues = std::move(other.mOtherValues);
+	mWasChanged = other.mWasChanged;
+	mVersion = ++sNextVersion;
+	return *this;
 }
 
 
@@ -84,8 +126,6 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node n
 				value = resolvePath(value, relativeTo, true).generic_string();
 			}
 			mdl.set(iter->key, value);
-		}else{
-			mdl.set(iter->key, iter->defaultValue);
 		}
 	}
 
@@ -96,30 +136,57 @@ void MetaDataList::appendToXML(pugi::xml_node parent, bool ignoreDefaults, const
 {
 	const std::vector<MetaDataDecl>& mdd = getMDD();
 
-	for(auto mddIter = mdd.begin(); mddIter != mdd.end(); mddIter++)
+	for(unsigned int i = 0; i < mdd.size(); i++)
 	{
-		auto mapIter = mMap.find(mddIter->key);
-		if(mapIter != mMap.end())
-		{
-			// we have this value!
-			// if it's just the default (and we ignore defaults), don't write it
-			if(ignoreDefaults && mapIter->second == mddIter->defaultValue)
-				continue;
-			
-			// try and make paths relative if we can
-			std::string value = mapIter->second;
-			if (mddIter->type == MD_PATH)
-				value = makeRelativePath(value, relativeTo, true).generic_string();
-
-			parent.append_child(mapIter->first.c_str()).text().set(value.c_str());
-		}
+		auto valueIter = mValues.find(i);
+		const bool isDefault = (valueIter == mValues.end() || valueIter->second == mdd[i].defaultValue);
+
+		// if it's just the default (and we ignore defaults), don't write it
+		if(ignoreDefaults && isDefault)
+			continue;
+
+		// try and make paths relative if we can
+		std::string value = (valueIter == mValues.end() ? mdd[i].defaultValue : valueIter->second);
+		if (mdd[i].type == MD_PATH)
+			value = makeRelativePath(value, relativeTo, true).generic_string();
+
+		parent.append_child(mdd[i].key.c_str()).text().set(value.c_str());
 	}
 }
 
+int MetaDataList::getIndex(const std::string& key) const
+{
+	// called from the sort comparators, so it's a hash lookup rather than a walk through the MDD
+	static const std::unordered_map<std::string, int> gameIndex = makeMDDIndex(gameMDD);
+	static const std::unordered_map<std::string, int> folderIndex = makeMDDIndex(folderMDD);
+
+	const std::unordered_map<std::string, int>& index = (mType == FOLDER_METADATA ? folderIndex : gameIndex);
+	auto it = index.find(key);
+	return it != index.end() ? it->second : -1;
+}
+
 void MetaDataList::set(const std::string& key, const std::string& value)
 {
-	mMap[key] = value;
+	const int index = getIndex(key);
+	if(index < 0)
+	{
+		if(!mOtherValues)
+			mOtherValues.reset(new std::map<std::string, std::string>());
+		(*mOtherValues)[key] = value;
+		mWasChanged = true;
+		mVersion = ++sNextVersion;
+		return;
+	}
+
+	// an existing value is overwritten even if it's back to the default, references to it stay valid
+	auto valueIter = mValues.find(index);
+	if(valueIter != mValues.end())
+		valueIter->second = value;
+	else if(value != getMDD()[index].defaultValue)
+		mValues[index] = value;
+
 	mWasChanged = true;
+	mVersion = ++sNextVersion;
 }
 
 void MetaDataList::setTime(const std::string& key, const boost::posix_time::ptime& time)
@@ -129,7 +196,20 @@ void MetaDataList::setTime(const std::string& key, const boost::posix_time::ptim
 
 const std::string& MetaDataList::get(const std::string& key) const
 {
-	return mMap.at(key);
+	const int index = getIndex(key);
+	if(index < 0)
+	{
+		if(mOtherValues)
+		{
+			auto otherIter = mOtherValues->find(key);
+			if(otherIter != mOtherValues->end())
+				return otherIter->second;
+		}
+		throw std::out_of_range("Unknown metadata key \"" + key + "\"");
+	}
+
+	auto valueIter = mValues.find(index);
+	return valueIter != mValues.end() ? valueIter->second : getMDD()[index].defaultValue;
 }
 
 int MetaDataList::getInt(const std::string& key) const
@@ -151,8 +231,9 @@ bool MetaDataList::isDefault()
 {
 	const std::vector<MetaDataDecl>& mdd = getMDD();
 
-	for (int i = 1; i < mMap.size(); i++) {
-		if (mMap.at(mdd[i].key) != mdd[i].defaultValue) return false;
+	// the name doesn't count
+	for (auto it = mValues.begin(); it != mValues.end(); it++) {
+		if (it->first != 0 && it->second != mdd[it->first].defaultValue) return false;
 	}
 
 	return true;
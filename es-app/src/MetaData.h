@@ -3,6 +3,8 @@
 #include "pugixml/src/pugixml.hpp"
 #include <string>
 #include <map>
+#include <memory>
+#include <atomic>
 #include "GuiComponent.h"
 #include <boost/date_time.hpp>
 #include <boost/filesystem.hpp>
@@ -48,7 +50,11 @@ public:
 	void appendToXML(pugi::xml_node parent, bool ignoreDefaults, const boost::filesystem::path& relativeTo) const;
 
 	MetaDataList(MetaDataListType type);
-	
+	MetaDataList(const MetaDataList& other);
+	MetaDataList(MetaDataList&& other);
+	MetaDataList& operator=(const MetaDataList& other);
+	MetaDataList& operator=(MetaDataList&& other);
+
 	void set(const std::string& key, const std::string& value);
 	void setTime(const std::string& key, const boost::posix_time::ptime& time); //times are internally stored as ISO strings (e.g. boost::posix_time::to_iso_string(ptime))
 
@@ -62,11 +68,24 @@ public:
 	bool wasChanged() const;
 	void resetChangedFlag();
 
+	// Different every time a value changes (or the list is assigned to), so anything worked out
+	// from the values can tell if it's out of date.
+	inline unsigned int getVersion() const { return mVersion; }
+
 	inline MetaDataListType getType() const { return mType; }
 	inline const std::vector<MetaDataDecl>& getMDD() const { return getMDDByType(getType()); }
 
 private:
 	MetaDataListType mType;
-	std::map<std::string, std::string> mMap;
+	// Only values that aren't the default are kept, by their position in getMDD(). There is one of
+	// these for every game and most of them are never scraped, so the defaults would be most of it.
+	std::map<unsigned char, std::string> mValues;
+	// keys that aren't in getMDD() are kept too but not saved, there's hardly ever any
+	std::unique_ptr< std::map<std::string, std::string> > mOtherValues;
 	bool mWasChanged;
+	unsigned int mVersion;
+
+	static std::atomic<unsigned int> sNextVersion;
+
+	int getIndex(const std::string& key) const; // -1 if key isn't in getMDD(), a table lookup
 };
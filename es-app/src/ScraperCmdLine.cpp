@@ -1,285 +1,420 @@
 #include "ScraperCmdLine.h"
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
 #include <vector>
+#include <list>
+#include <deque>
+#include <set>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <functional>
 #include "SystemData.h"
+#include "FileData.h"
+#include "Gamelist.h"
 #include "Settings.h"
+#include "platform.h"
+#include "scrapers/Scraper.h"
+#include <boost/filesystem.hpp>
 #include <signal.h>
 #include "Log.h"
 
-std::ostream& out = std::cout;
+namespace fs = boost::filesystem;
 
-void handle_interrupt_signal(int p)
-{
-	sleep(50);
+std::ostream& out = std::cout;
 
-	LOG(LogInfo) << "Interrupt received during scrape...";
+// how often progress is printed, in ms
+#define PROGRESS_INTERVAL 5000
+// how often finished games are saved, in ms, so a kill or crash loses at most this much
+#define SAVE_INTERVAL 30000
 
-	SystemData::deleteSystems();
+// set on SIGINT, SIGTERM or SIGHUP, no new games are started and what's finished is saved
+static volatile sig_atomic_t sInterrupted = 0;
 
-	exit(1);
+void handle_interrupt_signal(int p)
+{
+	sInterrupted = 1;
 }
 
-int run_scraper_cmdline()
+struct CmdLineSystem
 {
-	out << "EmulationStation scraper\n";
-	out << "========================\n";
-	out << "\n";
+	CmdLineSystem(SystemData* sys) : system(sys), running(0), changed(false) {}
 
-	signal(SIGINT, handle_interrupt_signal);
+	SystemData* system;
+	std::deque<FileData*> pending;
+	unsigned int running;
+	std::vector<FileData*> done; // finished since the gamelist was last written
+	bool changed;
+};
 
-	//==================================================================================
-	//filter
-	//==================================================================================
-	enum FilterChoice
-	{
-		FILTER_MISSING_IMAGES,
-		FILTER_ALL
-	};
+struct CmdLineJob
+{
+	CmdLineSystem* system;
+	ScraperSearchParams params;
+	std::unique_ptr<ScraperSearchHandle> search;
+	std::unique_ptr<MDResolveHandle> resolve;
+	ScraperSearchResult accepted;
+};
+
+struct CmdLineStats
+{
+	CmdLineStats() : total(0), scraped(0), notFound(0), errors(0), images(0), imageErrors(0) {}
 
-	int filter_choice;
-	do {
-		out << "Select filter for games to be scraped:\n";
-		out << FILTER_MISSING_IMAGES << " - games missing images\n";
-		out << FILTER_ALL << " - all games period, can overwrite existing metadata\n";
+	unsigned int total;
+	unsigned int scraped;
+	unsigned int notFound;
+	unsigned int errors;
+	unsigned int images;
+	unsigned int imageErrors;
 
-		std::cin >> filter_choice;
-		std::cin.ignore(1, '\n'); //skip the unconsumed newline
-	} while(filter_choice < FILTER_MISSING_IMAGES || filter_choice > FILTER_ALL);
+	unsigned int processed() const { return scraped + notFound + errors; }
+};
 
-	out << "\n";
+// Games that were scraped by an earlier run that didn't finish, one path per line. There's one
+// file per set of options, so a run only resumes an interrupted run that was scraping the same games.
+static std::string sProgressPath;
 
-	//==================================================================================
-	//platforms
-	//==================================================================================
+static std::string getProgressPath(const ScraperCmdLineOptions& options)
+{
+	std::vector<std::string> systems = options.systems;
+	std::sort(systems.begin(), systems.end());
 
-	std::vector<SystemData*> systems;
+	std::string key = options.overwrite ? "all" : "missing";
+	for(auto it = systems.begin(); it != systems.end(); it++)
+		key += "," + *it;
 
-	out << "You can scrape only specific platforms, or scrape all of them.\n";
-	out << "Would you like to scrape all platforms? (y/n)\n";
+	std::stringstream ss;
+	ss << std::hex << std::hash<std::string>()(key);
+	return getHomePath() + "/.emulationstation/scrape_progress_" + ss.str() + ".txt";
+}
 
-	std::string system_choice;
-	std::getline(std::cin, system_choice);
-	
-	if(system_choice == "y" || system_choice == "Y")
+static std::set<std::string> loadProgress()
+{
+	std::set<std::string> paths;
+	std::ifstream file(sProgressPath);
+	std::string line;
+	while(std::getline(file, line))
 	{
-		out << "Will scrape all platforms.\n";
-		for(auto i = SystemData::sSystemVector.begin(); i != SystemData::sSystemVector.end(); i++)
-		{
-			out << "   " << (*i)->getName() << " (" << (*i)->getGameCount() << " games)\n";
-			systems.push_back(*i);
-		}
+		if(!line.empty())
+			paths.insert(line);
+	}
 
-	}else{
-		std::string sys_name;
+	return paths;
+}
 
-		out << "Enter the names of the platforms you would like to scrape, one at a time.\n";
-		out << "Type nothing and press enter when you are ready to continue.\n";
+// writes the system's gamelist, then records its finished games so they're skipped if we're restarted
+// (not before, or a game could be skipped without its metadata ever having been saved)
+static void saveSystem(CmdLineSystem& sys)
+{
+	if(sys.changed)
+		updateGamelist(sys.system);
 
-		do {
-			for(auto i = SystemData::sSystemVector.begin(); i != SystemData::sSystemVector.end(); i++)
-			{
-				if(std::find(systems.begin(), systems.end(), (*i)) != systems.end())
-					out << " C ";
-				else
-					out << "   ";
+	if(!sys.done.empty())
+	{
+		std::ofstream file(sProgressPath, std::ios_base::out | std::ios_base::app);
+		for(auto it = sys.done.begin(); it != sys.done.end(); it++)
+			file << (*it)->getPath().generic_string() << "\n";
+	}
 
-				out << "\"" << (*i)->getName() << "\" (" << (*i)->getGameCount() << " games)\n";
-			}
+	sys.done.clear();
+	sys.changed = false;
+}
 
-			std::getline(std::cin, sys_name);
-			
-			if(sys_name.empty())
-				break;
+static void printProgress(const CmdLineStats& stats, double seconds)
+{
+	out << "[" << std::fixed << std::setprecision(1) << std::setw(7) << seconds << "s] "
+		<< stats.processed() << "/" << stats.total << " games ("
+		<< std::setprecision(2) << (seconds > 0 ? stats.processed() / seconds : 0.0) << " games/s) - "
+		<< stats.scraped << " scraped, " << stats.notFound << " not found, " << stats.errors << " errors, "
+		<< stats.images << " images\n";
+	out.flush();
+}
 
-			bool found = false;
-			for(auto i = SystemData::sSystemVector.begin(); i != SystemData::sSystemVector.end(); i++)
-			{
-				if((*i)->getName() == sys_name)
-				{
-					systems.push_back(*i);
-					found = true;
-					break;
-				}
-			}
+int run_scraper_cmdline(const ScraperCmdLineOptions& options)
+{
+	out << "EmulationStation scraper\n";
+	out << "========================\n";
+	out << "\n";
 
-			if(!found)
-				out << "System not found.\n";
+	signal(SIGINT, handle_interrupt_signal);
+	signal(SIGTERM, handle_interrupt_signal);
+#ifdef SIGHUP
+	signal(SIGHUP, handle_interrupt_signal);
+#endif
 
-		} while(true);
-	}
+	int concurrency = Settings::getInstance()->getInt("ScraperConcurrency");
+	if(concurrency < 1)
+		concurrency = 1;
 
 	//==================================================================================
-	//manual mode
+	//platforms and games
 	//==================================================================================
+	for(auto it = options.systems.begin(); it != options.systems.end(); it++)
+	{
+		bool found = false;
+		for(auto sysIt = SystemData::sSystemVector.begin(); sysIt != SystemData::sSystemVector.end(); sysIt++)
+		{
+			if((*sysIt)->getName() == *it)
+				found = true;
+		}
 
-	out << "\n";
-	out << "You can let the scraper try to automatically choose the best result, or\n";
-	out << "you can manually approve each result. This \"manual mode\" is much more accurate.\n";
-	out << "It is highly recommended you use manual mode unless you have a very large collection.\n";
-	out << "Scrape in manual mode? (y/n)\n";
+		if(!found)
+		{
+			std::cerr << "System \"" << *it << "\" not found.\n";
+			return 1;
+		}
+	}
 
-	std::string manual_mode_str;
-	std::getline(std::cin, manual_mode_str);
+	sProgressPath = getProgressPath(options);
+	if(options.restart)
+	{
+		boost::system::error_code ec;
+		fs::remove(sProgressPath, ec);
+	}
 
-	bool manual_mode = false;
+	const std::set<std::string> alreadyDone = loadProgress();
+	if(!alreadyDone.empty())
+		out << "Resuming, " << alreadyDone.size() << " games were scraped by an earlier run.\n";
 
-	if(manual_mode_str == "y" || manual_mode_str == "Y")
+	CmdLineStats stats;
+	std::list<CmdLineSystem> systems;
+	for(auto sysIt = SystemData::sSystemVector.begin(); sysIt != SystemData::sSystemVector.end(); sysIt++)
 	{
-		manual_mode = true;
-		out << "Scraping in manual mode!\n";
-	}else{
-		out << "Scraping in automatic mode!\n";
+		SystemData* system = *sysIt;
+		if(system->isCollection())
+			continue;
+
+		if(!options.systems.empty() && std::find(options.systems.begin(), options.systems.end(), system->getName()) == options.systems.end())
+			continue;
+
+		systems.push_back(CmdLineSystem(system));
+		CmdLineSystem& sys = systems.back();
+
+		std::vector<FileData*> files = system->getRootFolder()->getFilesRecursive(GAME);
+		for(auto gameIt = files.begin(); gameIt != files.end(); gameIt++)
+		{
+			FileData* game = *gameIt;
+			if(alreadyDone.find(game->getPath().generic_string()) != alreadyDone.end())
+				continue;
+
+			// maybe should also check if the image file exists/is a URL
+			if(!options.overwrite && !game->metadata.get("image").empty())
+				continue;
+
+			sys.pending.push_back(game);
+		}
+
+		out << "   " << system->getName() << ": " << sys.pending.size() << " of " << files.size() << " games to scrape\n";
+		stats.total += sys.pending.size();
 	}
 
+	out << "\n";
+	out << "Scraping " << stats.total << " games, " << concurrency << " at a time.\n";
+	out << "Press Ctrl+C to stop, progress is saved and the next run picks up from there.\n";
+	out << "\n";
+
 	//==================================================================================
 	//scraping
 	//==================================================================================
-	out << "\n";
-	out << "Alright, let's do this thing!\n";
-	out << "=============================\n";
 
-	/*
-	std::shared_ptr<Scraper> scraper = Settings::getInstance()->getScraper();
-	for(auto sysIt = systems.begin(); sysIt != systems.end(); sysIt++)
-	{
-		std::vector<FileData*> files = (*sysIt)->getRootFolder()->getFilesRecursive(GAME);
+	// Up to [concurrency] systems are worked on at once, taking turns to start games, so a
+	// system with a slow platform lookup doesn't hold up the rest. All of the requests share
+	// HttpReq's curl multi handle and images are saved/resized on the worker pool.
+	std::list<CmdLineSystem*> active;
+	auto nextSystem = systems.begin();
+	std::list< std::unique_ptr<CmdLineJob> > jobs;
 
-		ScraperSearchParams params;
-		params.system = (*sysIt);
+	const auto startTime = std::chrono::steady_clock::now();
+	auto lastProgress = startTime;
+	auto lastSave = startTime;
 
-		for(auto gameIt = files.begin(); gameIt != files.end(); gameIt++)
+	while(true)
+	{
+		while(!sInterrupted && jobs.size() < (size_t)concurrency)
 		{
-			params.nameOverride = "";
-			params.game = *gameIt;
-
-			//print original search term
-			out << getCleanFileName(params.game->getPath()) << "...\n";
-
-			//need to take into account filter_choice
-			if(filter_choice == FILTER_MISSING_IMAGES)
+			while(active.size() < (size_t)concurrency && nextSystem != systems.end())
 			{
-				if(!params.game->metadata.get("image").empty()) //maybe should also check if the image file exists/is a URL
-				{
-					out << "   Skipping, metadata \"image\" entry is not empty.\n";
-					continue;
-				}
+				if(!nextSystem->pending.empty())
+					active.push_back(&(*nextSystem));
+				nextSystem++;
 			}
 
-			//actually get some results
-			do {
-				std::vector<MetaDataList> mdls = scraper->getResults(params);
+			if(active.empty())
+				break;
 
-				//no results
-				if(mdls.size() == 0)
-				{
-					if(manual_mode)
-					{
-						//in manual mode let the user enter a custom search
-						out << "   NO RESULTS FOUND! Enter a new name to search for, or nothing to skip.\n";
+			CmdLineSystem* sys = active.front();
+			active.pop_front();
 
-						std::getline(std::cin, params.nameOverride);
+			std::unique_ptr<CmdLineJob> job(new CmdLineJob());
+			job->system = sys;
+			job->params.system = sys->system;
+			job->params.game = sys->pending.front();
+			job->search = startScraperSearch(job->params);
+			sys->pending.pop_front();
+			sys->running++;
 
-						if(params.nameOverride.empty())
-						{
-							out << "   Skipping...\n";
-							break;
-						}
+			// back of the line, or out of it once all of its games have been started
+			if(!sys->pending.empty())
+				active.push_back(sys);
 
-						continue;
+			jobs.push_back(std::move(job));
+		}
+
+		if(jobs.empty())
+			break;
+
+		for(auto it = jobs.begin(); it != jobs.end(); )
+		{
+			CmdLineJob* job = it->get();
+			CmdLineSystem* sys = job->system;
+			FileData* game = job->params.game;
+			bool finished = false;
 
+			if(job->search)
+			{
+				AsyncHandleStatus status = job->search->status();
+				if(status == ASYNC_ERROR)
+				{
+					// not marked as done, so it's tried again next run
+					LOG(LogWarning) << "Scraping \"" << game->getPath().string() << "\" failed: " << job->search->getStatusString();
+					stats.errors++;
+					finished = true;
+				}else if(status == ASYNC_DONE)
+				{
+					const std::vector<ScraperSearchResult>& results = job->search->getResults();
+					if(results.empty())
+					{
+						stats.notFound++;
+						sys->done.push_back(game);
+						finished = true;
 					}else{
-						out << "   NO RESULTS FOUND! Skipping...\n";
-						break;
+						// always choose the first result
+						job->accepted = results.front();
+						if(job->accepted.imageUrl.empty())
+						{
+							game->metadata = job->accepted.mdl;
+							sys->changed = true;
+							sys->done.push_back(game);
+							stats.scraped++;
+							finished = true;
+						}else{
+							job->resolve = resolveMetaDataAssets(job->accepted, job->params);
+						}
 					}
+					job->search.reset();
+				}
+			}else if(job->resolve)
+			{
+				AsyncHandleStatus status = job->resolve->status();
+				if(status == ASYNC_DONE)
+				{
+					game->metadata = job->resolve->getResult().mdl;
+					sys->done.push_back(game);
+					stats.images++;
+					finished = true;
+				}else if(status == ASYNC_ERROR)
+				{
+					// keep the rest of the metadata, the image is tried again next run
+					LOG(LogWarning) << "Could not download image for \"" << game->getPath().string() << "\": " << job->resolve->getStatusString();
+					game->metadata = job->accepted.mdl;
+					stats.imageErrors++;
+					finished = true;
 				}
 
-				//some results
-				if(manual_mode)
+				if(finished)
 				{
-					//print list of choices
-					for(unsigned int i = 0; i < mdls.size(); i++)
-					{
-						out << "   " << i << " - " << mdls.at(i).get("name") << "\n";
-					}
+					sys->changed = true;
+					stats.scraped++;
+				}
+			}
 
-					int choice = -1;
-					std::string choice_str;
-					
-					out << "Your choice: ";
+			if(!finished)
+			{
+				it++;
+				continue;
+			}
 
-					std::getline(std::cin, choice_str);
-					std::stringstream choice_buff(choice_str); //convert to int
-					choice_buff >> choice;
+			it = jobs.erase(it);
+			sys->running--;
 
-					if(choice >= 0 && choice < (int)mdls.size())
-					{
-						params.game->metadata = mdls.at(choice);
-						break;
-					}else{
-						out << "Invalid choice.\n";
-						continue;
-					}
+			// a system's gamelist is written when all of its games are done, and every SAVE_INTERVAL until then
+			if(sys->pending.empty() && sys->running == 0)
+			{
+				saveSystem(*sys);
+				out << "   " << sys->system->getName() << " done.\n";
+			}
+		}
 
-				}else{
-					//automatic mode
-					//always choose the first choice
-					out << "   name -> " << mdls.at(0).get("name") << "\n";
-					params.game->metadata = mdls.at(0);
-					break;
-				}
+		if(sInterrupted && !jobs.empty())
+		{
+			// whatever is still in flight is dropped and tried again next run
+			out << "\nInterrupted, dropping " << jobs.size() << " games in progress.\n";
+			for(auto it = jobs.begin(); it != jobs.end(); it++)
+				(*it)->system->running--;
+			jobs.clear();
+		}
 
-			} while(true);
+		const auto now = std::chrono::steady_clock::now();
+		if(std::chrono::duration_cast<std::chrono::milliseconds>(now - lastProgress).count() >= PROGRESS_INTERVAL)
+		{
+			printProgress(stats, std::chrono::duration<double>(now - startTime).count());
+			lastProgress = now;
+		}
 
-			out << "===================\n";
+		if(std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSave).count() >= SAVE_INTERVAL)
+		{
+			for(auto it = systems.begin(); it != systems.end(); it++)
+			{
+				if(it->changed || !it->done.empty())
+					saveSystem(*it);
+			}
+			lastSave = now;
 		}
-	}
 
-	out << "\n\n";
-	out << "Downloading boxart...\n";
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
 
-	for(auto sysIt = systems.begin(); sysIt != systems.end(); sysIt++)
+	// only systems that were cut short by an interrupt still have anything to save
+	for(auto it = systems.begin(); it != systems.end(); it++)
 	{
-		std::vector<FileData*> files = (*sysIt)->getRootFolder()->getFilesRecursive(GAME);
+		if(it->changed || !it->done.empty())
+			saveSystem(*it);
+	}
 
-		for(auto gameIt = files.begin(); gameIt != files.end(); gameIt++)
-		{
-			FileData* game = *gameIt;
-			const std::vector<MetaDataDecl>& mdd = game->metadata.getMDD();
-			for(auto i = mdd.begin(); i != mdd.end(); i++)
-			{
-				std::string key = i->key;
-				std::string url = game->metadata.get(key);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 
-				if(i->type == MD_IMAGE_PATH && HttpReq::isUrl(url))
-				{
-					std::string urlShort = url.substr(0, url.length() > 35 ? 35 : url.length());
-					if(url.length() != urlShort.length()) urlShort += "...";
+	out << "\n";
+	out << "==============================\n";
+	printProgress(stats, seconds);
+	if(stats.imageErrors > 0)
+		out << stats.imageErrors << " images could not be downloaded.\n";
 
-					out << "   " << game->metadata.get("name") << " [from: " << urlShort << "]...\n";
+	const HttpReq::CacheStats& cache = HttpReq::getCacheStats();
+	out << "HTTP cache: " << cache.hits << " hits (" << cache.revalidated << " revalidated), " << cache.misses << " misses, "
+		<< cache.shared << " shared with a request in flight\n";
 
-					ScraperSearchParams p;
-					p.game = game;
-					p.system = *sysIt;
-					game->metadata.set(key, downloadImage(url, getSaveAsPath(p, key, url)));
-					if(game->metadata.get(key).empty())
-					{
-						out << "     FAILED! Skipping.\n";
-						game->metadata.set(key, url); //result URL to what it was if download failed, retry some other time
-					}
-				}
-			}
-		}
+	const HttpReq::NetworkStats net = HttpReq::getNetworkStats();
+	out << "Downloaded " << (net.bytesDownloaded / 1000) << "KB (" << std::setprecision(1)
+		<< (seconds > 0 ? net.bytesDownloaded / 1000 / seconds : 0.0) << "KB/s)\n";
+	for(auto it = net.bytesPerHost.begin(); it != net.bytesPerHost.end(); it++)
+		out << "   " << it->first << ": " << (it->second / 1000) << "KB\n";
+
+	if(sInterrupted)
+	{
+		out << "SCRAPE INTERRUPTED, run again to continue.\n";
+		out << "==============================\n";
+		return 1;
 	}
 
+	// a finished run doesn't need to be resumed, games that failed are tried again by the next one anyway
+	boost::system::error_code ec;
+	fs::remove(sProgressPath, ec);
 
-	out << "\n\n";
-	out << "==============================\n";
 	out << "SCRAPE COMPLETE!\n";
 	out << "==============================\n";
-	*/
-
-	out << "\n\n";
-	out << "ACTUALLY THIS IS STILL TODO\n";
 
 	return 0;
 }
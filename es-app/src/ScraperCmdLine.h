@@ -1,3 +1,19 @@
 #pragma once
 
-int run_scraper_cmdline();
+#include <string>
+#include <vector>
+
+// Set from the --scrape-* command line arguments.
+struct ScraperCmdLineOptions
+{
+	ScraperCmdLineOptions() : overwrite(false), restart(false) {}
+
+	std::vector<std::string> systems; // empty means every system
+	bool overwrite; // also scrape games that already have an image
+	bool restart; // ignore what an interrupted run with the same options got done
+};
+
+// Scrapes without a window and writes each system's gamelist when it's done. Returns the exit code.
+// If interrupted, what was scraped so far is saved and the next run with the same options carries on
+// from there.
+int run_scraper_cmdline(const ScraperCmdLineOptions& options);
@@ -10,20 +10,25 @@
 #include <iostream>
 #include "Settings.h"
 #include "FileSorts.h"
+#include "GameSearchIndex.h"
+#include "ThreadPool.h"
+#include "FolderScanner.h"
+#include "views/ViewController.h"
+#include <algorithm>
 
 std::vector<SystemData*> SystemData::sSystemVector;
 
 namespace fs = boost::filesystem;
 
 SystemData::SystemData(const std::string& name, const std::string& fullName, SystemEnvironmentData* envData, const std::string& themeFolder, bool CollectionSystem) :
-	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true)
+	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true), mPlaceholder(NULL)
 {
 	mFilterIndex = new FileFilterIndex();
 
 	// if it's an actual system, initialize it, if not, just create the data structure
 	if(!CollectionSystem)
 	{
-		mRootFolder = new FileData(FOLDER, mEnvData->mStartPath, mEnvData, this);
+		mRootFolder = new (mArena) FileData(FOLDER, mEnvData->mStartPath, mEnvData, this);
 		mRootFolder->metadata.set("name", mFullName);
 
 		if(!Settings::getInstance()->getBool("ParseGamelistOnly"))
@@ -37,14 +42,17 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 	else
 	{
 		// virtual systems are updated afterwards, we're just creating the data structure
-		mRootFolder = new FileData(FOLDER, "" + name, mEnvData, this);
+		mRootFolder = new (mArena) FileData(FOLDER, "" + name, mEnvData, this);
 	}
+	mFilterIndex->setRootFolder(mRootFolder);
 	setIsGameSystemStatus();
-	loadTheme();
+	loadThemeAsync();
 }
 
 SystemData::~SystemData()
 {
+	waitForTheme();
+
 	//save changed game data back to xml
 	if(!Settings::getInstance()->getBool("IgnoreGamelist") && Settings::getInstance()->getBool("SaveGamelistsOnExit") && !mIsCollectionSystem)
 	{
@@ -52,9 +60,19 @@ SystemData::~SystemData()
 	}
 
 	delete mRootFolder;
+	delete mPlaceholder;
 	delete mFilterIndex;
 }
 
+FileData* SystemData::getPlaceholder()
+{
+	// the arena never takes memory back, so every empty list shares this one
+	if(mPlaceholder == NULL)
+		mPlaceholder = new (mArena) FileData(PLACEHOLDER, "<No Entries Found>", mEnvData, this);
+
+	return mPlaceholder;
+}
+
 void SystemData::setIsGameSystemStatus()
 {
 	// we exclude non-game systems from specific operations (i.e. the "RetroPie" system, at least)
@@ -63,21 +81,6 @@ void SystemData::setIsGameSystemStatus()
 	mIsGameSystem = (mName != "retropie");
 }
 
-#ifndef WIN32
-// test to see if a file is hidden in *nix (dot-prefixed)
-// could be expanded to check for Windows hidden attribute
-bool isHidden(const fs::path &filePath)
-{
-	fs::path::string_type fileName = filePath.filename().string();
-	if(fileName[0] == '.')
-	{
-		return true;
-	}
-
-	return false;
-}
-#endif
-
 void SystemData::populateFolder(FileData* folder)
 {
 	const fs::path& folderPath = folder->getPath();
@@ -100,51 +103,282 @@ void SystemData::populateFolder(FileData* folder)
 		}
 	}
 
-	fs::path filePath;
-	std::string extension;
-	bool isGame;
-	bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
-	for(fs::directory_iterator end, dir(folderPath); dir != end; ++dir)
+	// listed in parallel, then turned into FileData here since the arena isn't thread safe
+	FolderScanner scanner(mEnvData->mSearchExtensions, Settings::getInstance()->getBool("ShowHiddenFiles"));
+	std::unique_ptr<FolderScanner::Folder> scanned = scanner.scan(folderStr);
+	if(!scanned)
+		return;
+
+	addScannedFolder(folder, *scanned);
+
+	const FolderScanner::Stats& stats = scanner.getStats();
+	const LogLevel level = (folder == mRootFolder ? LogInfo : LogDebug);
+	LOG(level) << mName << ": listed " << stats.folders << " folders and " << stats.entries << " entries in "
+		<< (int)(stats.seconds * 1000) << "ms (" << (int)(stats.folders / std::max(stats.seconds, 0.001)) << " folders/s, "
+		<< (int)(stats.entries / std::max(stats.seconds, 0.001)) << " entries/s)";
+}
+
+void SystemData::addScannedFolder(FileData* folder, const FolderScanner::Folder& scanned)
+{
+	mFolderTimes[scanned.path] = scanned.time;
+
+	std::string prefix = scanned.path;
+	if(prefix.empty() || prefix[prefix.size() - 1] != '/')
+		prefix += '/';
+
+	for(auto it = scanned.entries.begin(); it != scanned.entries.end(); it++)
+	{
+		if(!it->folder)
+		{
+			folder->addChild(new (mArena) FileData(GAME, prefix + it->name, mEnvData, this));
+			continue;
+		}
+
+		FileData* newFolder = new (mArena) FileData(FOLDER, it->folder->path, mEnvData, this);
+		addScannedFolder(newFolder, *it->folder);
+
+		//ignore folders that do not contain games
+		if(newFolder->getChildren().empty())
+			delete newFolder;
+		else
+			folder->addChild(newFolder);
+	}
+}
+
+FileData* SystemData::findFolder(const std::string& path) const
+{
+	std::string start = mRootFolder->getPath().generic_string();
+	if(!start.empty() && start.back() == '/')
+		start.pop_back();
+
+	if(path.compare(0, start.size(), start) != 0 || (path.size() > start.size() && path[start.size()] != '/'))
+		return NULL;
+
+	// down one name at a time, until a name isn't there or isn't a folder
+	FileData* folder = mRootFolder;
+	size_t pos = start.size();
+	while(pos < path.size())
+	{
+		size_t next = path.find('/', pos + 1);
+		if(next == std::string::npos)
+			next = path.size();
+
+		const std::string name = path.substr(pos + 1, next - pos - 1);
+		pos = next;
+		if(name.empty())
+			continue;
+
+		const std::unordered_map<std::string, FileData*>& children = folder->getChildrenByFilename();
+		auto child = children.find(name);
+		if(child == children.end() || child->second->getType() != FOLDER)
+			break;
+
+		folder = child->second;
+	}
+
+	return folder;
+}
+
+// The sort the gamelist was last given, so new files go where it would have put them. A game
+// that changed since doesn't matter, addChildSorted() sorts again if anything is out of place.
+const FileData::SortType& SystemData::getCurrentSort() const
+{
+	for(auto it = FileSorts::SortTypes.begin(); it != FileSorts::SortTypes.end(); it++)
 	{
-		filePath = (*dir).path();
+		if(mRootFolder->wasLastSortedBy(*it))
+			return *it;
+	}
 
-		if(filePath.stem().empty())
+	return FileSorts::SortTypes.at(0);
+}
+
+void SystemData::syncFolder(FileData* folder, std::vector<FileData*>& newGames, std::unordered_set<FileData*>& removed)
+{
+	// only this folder is listed, new subfolders are scanned in full below
+	const std::string folderStr = folder->getPath().generic_string();
+	FolderScanner scanner(mEnvData->mSearchExtensions, Settings::getInstance()->getBool("ShowHiddenFiles"));
+	std::unique_ptr<FolderScanner::Folder> scanned = scanner.scan(folderStr, false);
+	if(!scanned)
+		return; // its parent's listing takes it out
+
+	if(!scanned->listed)
+		return; // FolderScanner has logged it, nothing's taken out because of it
+
+	mFolderTimes[folderStr] = scanned->time;
+
+	std::string prefix = folderStr;
+	if(prefix.empty() || prefix[prefix.size() - 1] != '/')
+		prefix += '/';
+
+	const std::unordered_map<std::string, FileData*>& children = folder->getChildrenByFilename();
+	std::unordered_set<std::string> listed;
+	std::vector<FileData*> added;
+	for(auto it = scanned->entries.begin(); it != scanned->entries.end(); it++)
+	{
+		listed.insert(it->name);
+		if(children.find(it->name) != children.end())
 			continue;
 
-		//this is a little complicated because we allow a list of extensions to be defined (delimited with a space)
-		//we first get the extension of the file itself:
-		extension = filePath.extension().string();
+		if(!it->folder)
+		{
+			added.push_back(new (mArena) FileData(GAME, prefix + it->name, mEnvData, this));
+			continue;
+		}
+
+		FileData* newFolder = new (mArena) FileData(FOLDER, it->folder->path, mEnvData, this);
+		populateFolder(newFolder);
+
+		//ignore folders that do not contain games
+		if(newFolder->getChildren().empty())
+			delete newFolder;
+		else
+			added.push_back(newFolder);
+	}
+
+	// gamelist entries with other extensions aren't listed, they're only gone if they don't exist
+	boost::system::error_code ec;
+	for(auto it = children.begin(); it != children.end(); it++)
+	{
+		if(listed.find(it->first) == listed.end() && !fs::exists(it->second->getPath(), ec))
+			removed.insert(it->second);
+	}
+
+	const FileData::SortType& sort = getCurrentSort();
+	for(auto it = added.begin(); it != added.end(); it++)
+	{
+		folder->addChildSorted(*it, sort);
+		if((*it)->getType() == GAME)
+		{
+			newGames.push_back(*it);
+		}else{
+			std::vector<FileData*> games = (*it)->getFilesRecursive(GAME);
+			newGames.insert(newGames.end(), games.begin(), games.end());
+		}
+	}
+}
+
+void SystemData::rescanFolders(const std::vector<std::string>& paths)
+{
+	if(Settings::getInstance()->getBool("ParseGamelistOnly"))
+		return;
+
+	// parents first, so a folder that's added or removed is only dealt with once
+	std::vector<std::string> sorted(paths);
+	std::sort(sorted.begin(), sorted.end());
+
+	std::vector<FileData*> newGames;
+	std::unordered_set<FileData*> removed;
+	std::unordered_set<FileData*> synced;
+	for(auto it = sorted.begin(); it != sorted.end(); it++)
+	{
+		FileData* folder = findFolder(*it);
+		if(folder && synced.insert(folder).second)
+			syncFolder(folder, newGames, removed);
+	}
 
-		//fyi, folders *can* also match the extension and be added as games - this is mostly just to support higan
-		//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
+	// folders left with nothing in them go too, populateFolder() wouldn't have added them
+	std::vector<FileData*> check(removed.begin(), removed.end());
+	while(!check.empty())
+	{
+		FileData* parent = check.back()->getParent();
+		check.pop_back();
+		if(!parent || parent == mRootFolder || removed.find(parent) != removed.end())
+			continue;
 
-		isGame = false;
-		if(std::find(mEnvData->mSearchExtensions.begin(), mEnvData->mSearchExtensions.end(), extension) != mEnvData->mSearchExtensions.end())
+		const std::vector<FileData*>& children = parent->getChildren();
+		if(std::all_of(children.begin(), children.end(), [&removed](FileData* child) { return removed.find(child) != removed.end(); }))
 		{
-#ifndef WIN32
-			// skip hidden files
-			if(!showHidden && isHidden(filePath))
-				continue;
-#endif
-
-			FileData* newGame = new FileData(GAME, filePath.generic_string(), mEnvData, this);
-			folder->addChild(newGame);
-			isGame = true;
+			removed.insert(parent);
+			check.push_back(parent);
 		}
+	}
+
+	if(newGames.empty() && removed.empty())
+		return;
+
+	// deleting a folder deletes what's in it, so only the top most are deleted
+	std::vector<FileData*> topMost;
+	std::vector<FileData*> removedGames;
+	for(auto it = removed.begin(); it != removed.end(); it++)
+	{
+		FileData* file = *it;
+		if(removed.find(file->getParent()) != removed.end())
+			continue;
 
-		//add directories that also do not match an extension as folders
-		if(!isGame && fs::is_directory(filePath))
+		topMost.push_back(file);
+		if(file->getType() == GAME)
 		{
-			FileData* newFolder = new FileData(FOLDER, filePath.generic_string(), mEnvData, this);
-			populateFolder(newFolder);
+			removedGames.push_back(file);
+		}else{
+			std::vector<FileData*> games = file->getFilesRecursive(GAME);
+			removedGames.insert(removedGames.end(), games.begin(), games.end());
+		}
+	}
+
+	for(auto it = topMost.begin(); it != topMost.end(); it++)
+	{
+		if((*it)->getType() != FOLDER)
+			continue;
+
+		// a folder that's gone from disk takes everything listed under it with it
+		const std::string path = (*it)->getPath().generic_string();
+		boost::system::error_code ec;
+		if(fs::exists(path, ec))
+			continue;
 
-			//ignore folders that do not contain games
-			if(newFolder->getChildrenByFilename().size() == 0)
-				delete newFolder;
+		for(auto time = mFolderTimes.begin(); time != mFolderTimes.end(); )
+		{
+			if(time->first.compare(0, path.size(), path) == 0 && (time->first.size() == path.size() || time->first[path.size()] == '/'))
+				time = mFolderTimes.erase(time);
 			else
-				folder->addChild(newFolder);
+				time++;
+		}
+	}
+
+	// nothing can point at them once they're deleted
+	if(!removed.empty())
+	{
+		CollectionSystemManager::get()->deleteCollectionFiles(removedGames);
+		ViewController::get()->onFilesRemoving(this, removed);
+		for(auto it = topMost.begin(); it != topMost.end(); it++)
+			delete *it;
+	}
+
+	for(auto it = newGames.begin(); it != newGames.end(); it++)
+		mFilterIndex->addToIndex(*it);
+	if(isGameSystem())
+		GameSearchIndex::getInstance()->addGames(newGames);
+	CollectionSystemManager::get()->addToAutoCollections(newGames);
+
+	ViewController::get()->onFileChanged(mRootFolder, newGames.empty() ? FILE_REMOVED : FILE_ADDED);
+
+	LOG(LogInfo) << mName << ": " << newGames.size() << " games added, " << removedGames.size() << " removed";
+}
+
+void SystemData::rescanChangedFolders()
+{
+	std::vector<std::string> changed;
+	boost::system::error_code ec;
+	for(auto it = mFolderTimes.begin(); it != mFolderTimes.end(); )
+	{
+		const std::time_t time = fs::last_write_time(it->first, ec);
+		if(!ec && time == it->second)
+		{
+			it++;
+			continue;
 		}
+
+		changed.push_back(it->first);
+
+		// one that's gone is only looked at once, its parent changed too
+		if(ec)
+			it = mFolderTimes.erase(it);
+		else
+			it++;
 	}
+
+	if(!changed.empty())
+		rescanFolders(changed);
 }
 
 std::vector<std::string> readList(const std::string& str, const char* delims = " \t\r\n,")
@@ -266,12 +500,16 @@ bool SystemData::loadConfig()
 		envData->mPlatformIds = platformIds;
 
 		SystemData* newSys = new SystemData(name, fullname, envData, themeFolder);
-		if(newSys->getRootFolder()->getChildrenByFilename().size() == 0)
+		if(newSys->getRootFolder()->getChildren().empty())
 		{
 			LOG(LogWarning) << "System \"" << name << "\" has no games! Ignoring it.";
 			delete newSys;
 		}else{
 			sSystemVector.push_back(newSys);
+
+			// collections aren't indexed either, their entries are the same games
+			if(newSys->isGameSystem())
+				GameSearchIndex::getInstance()->addGames(newSys->getRootFolder());
 		}
 	}
 	CollectionSystemManager::get()->loadCollectionSystems();
@@ -327,9 +565,17 @@ void SystemData::writeExampleConfig(const std::string& path)
 
 void SystemData::deleteSystems()
 {
+	// collection entries use their game's metadata and path, so collections have to go first
+	for(unsigned int i = 0; i < sSystemVector.size(); i++)
+	{
+		if(sSystemVector.at(i)->isCollection())
+			delete sSystemVector.at(i);
+	}
+
 	for(unsigned int i = 0; i < sSystemVector.size(); i++)
 	{
-		delete sSystemVector.at(i);
+		if(!sSystemVector.at(i)->isCollection())
+			delete sSystemVector.at(i);
 	}
 	sSystemVector.clear();
 }
@@ -391,7 +637,7 @@ bool SystemData::hasGamelist() const
 
 unsigned int SystemData::getGameCount() const
 {
-	return mRootFolder->getFilesRecursive(GAME).size();
+	return mRootFolder->getGameCount();
 }
 
 SystemData* SystemData::getRandomSystem()
@@ -424,20 +670,32 @@ SystemData* SystemData::getRandomSystem()
 
 FileData* SystemData::getRandomGame()
 {
-	std::vector<FileData*> list = mRootFolder->getFilesRecursive(GAME, true);
-	unsigned int total = list.size();
+	unsigned int total = getDisplayedGameCount();
+	if(total == 0)
+		return NULL;
+
 	// get random number in range
 	int target = std::round(((double)std::rand() / (double)RAND_MAX) * (total - 1));
-	return list.at(target);
+	return mRootFolder->getDisplayedGame(target);
 }
 
 unsigned int SystemData::getDisplayedGameCount() const
 {
-	return mRootFolder->getFilesRecursive(GAME, true).size();
+	mFilterIndex->updateDisplayedCounts();
+	return mRootFolder->getDisplayedGameCount();
 }
 
 void SystemData::loadTheme()
 {
+	loadThemeAsync();
+	waitForTheme();
+}
+
+void SystemData::loadThemeAsync()
+{
+	// an earlier load may still be writing to the current theme
+	waitForTheme();
+
 	mTheme = std::make_shared<ThemeData>();
 
 	std::string path = getThemePath();
@@ -445,18 +703,35 @@ void SystemData::loadTheme()
 	if(!fs::exists(path)) // no theme available for this platform
 		return;
 
-	try
-	{
-		// build map with system variables for theme to use,
-		std::map<std::string, std::string> sysData;
-		sysData.insert(std::pair<std::string, std::string>("system.name", getName()));
-		sysData.insert(std::pair<std::string, std::string>("system.theme", getThemeFolder()));
-		sysData.insert(std::pair<std::string, std::string>("system.fullName", getFullName()));
-		
-		mTheme->loadFile(sysData, path);
-	} catch(ThemeException& e)
+	// build map with system variables for theme to use,
+	std::map<std::string, std::string> sysData;
+	sysData.insert(std::pair<std::string, std::string>("system.name", getName()));
+	sysData.insert(std::pair<std::string, std::string>("system.theme", getThemeFolder()));
+	sysData.insert(std::pair<std::string, std::string>("system.fullName", getFullName()));
+
+	// the worker only touches the new ThemeData, nothing else in this system
+	std::shared_ptr<ThemeData> theme = mTheme;
+	mThemeLoad = ThreadPool::getInstance()->queueWorkItem([theme, sysData, path]
 	{
-		LOG(LogError) << e.what();
-		mTheme = std::make_shared<ThemeData>(); // reset to empty
-	}
+		try
+		{
+			theme->loadFile(sysData, path);
+		} catch(ThemeException& e)
+		{
+			LOG(LogError) << e.what();
+			*theme = ThemeData(); // reset to empty
+		} catch(std::exception& e)
+		{
+			// nobody calls get() on the future, so it would go unnoticed
+			LOG(LogError) << "Error loading theme \"" << path << "\": " << e.what();
+			*theme = ThemeData();
+		}
+	}).share();
+}
+
+void SystemData::waitForTheme() const
+{
+	// wait() rather than get(), it can be called any number of times and from any thread
+	if(mThemeLoad.valid())
+		mThemeLoad.wait();
 }
@@ -2,12 +2,17 @@
 
 #include <vector>
 #include <string>
+#include <future>
+#include <ctime>
+#include <unordered_map>
+#include <unordered_set>
 #include "FileData.h"
 #include "Window.h"
 #include "MetaData.h"
 #include "PlatformId.h"
 #include "ThemeData.h"
 #include "FileFilterIndex.h"
+#include "FolderScanner.h"
 #include "CollectionSystemManager.h"
 
 struct SystemEnvironmentData
@@ -34,7 +39,7 @@ public:
 	inline const std::vector<PlatformIds::PlatformId>& getPlatformIds() const { return mEnvData->mPlatformIds; }
 	inline bool hasPlatformId(PlatformIds::PlatformId id) { if (!mEnvData) return false; return std::find(mEnvData->mPlatformIds.begin(), mEnvData->mPlatformIds.end(), id) != mEnvData->mPlatformIds.end(); }
 
-	inline const std::shared_ptr<ThemeData>& getTheme() const { return mTheme; }
+	inline const std::shared_ptr<ThemeData>& getTheme() const { waitForTheme(); return mTheme; }
 
 	std::string getGamelistPath(bool forWrite) const;
 	bool hasGamelist() const;
@@ -75,8 +80,22 @@ public:
 
 	// Load or re-load theme.
 	void loadTheme();
+	// Same as loadTheme() but the XML is parsed on the worker pool. getTheme() waits for it to finish
+	void loadThemeAsync();
 
 	FileFilterIndex* getIndex() { return mFilterIndex; };
+	inline FileDataArena& getArena() { return mArena; }
+	FileData* getPlaceholder(); // the "no entries" entry shown in an empty gamelist, made once
+
+	// Every folder that was listed, games in it or not, with its modification time when it was.
+	inline const std::unordered_map<std::string, std::time_t>& getFolderTimes() const { return mFolderTimes; }
+
+	// Re-lists the given folders and applies what's been added or removed to the tree, the indexes,
+	// the collections and the gamelist view, leaving everything else as it is. A path that isn't
+	// in the tree re-lists the closest folder above it that is.
+	void rescanFolders(const std::vector<std::string>& paths);
+	// Re-lists the folders whose modification time changed, one stat per folder.
+	void rescanChangedFolders();
 
 private:
 	bool mIsCollectionSystem;
@@ -86,11 +105,20 @@ private:
 	SystemEnvironmentData* mEnvData;
 	std::string mThemeFolder;
 	std::shared_ptr<ThemeData> mTheme;
+	std::shared_future<void> mThemeLoad; // waited on from wherever the theme is first needed
 
+	void waitForTheme() const;
 	void populateFolder(FileData* folder);
+	void addScannedFolder(FileData* folder, const FolderScanner::Folder& scanned);
+	FileData* findFolder(const std::string& path) const;
+	void syncFolder(FileData* folder, std::vector<FileData*>& newGames, std::unordered_set<FileData*>& removed);
+	const FileData::SortType& getCurrentSort() const;
 	void setIsGameSystemStatus();
 
 	FileFilterIndex* mFilterIndex;
 
+	FileDataArena mArena; // everything in mRootFolder lives here, so it has to outlive it
 	FileData* mRootFolder;
+	FileData* mPlaceholder; // NULL until it's asked for
+	std::unordered_map<std::string, std::time_t> mFolderTimes;
 };
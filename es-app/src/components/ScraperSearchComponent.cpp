@@ -26,6 +26,7 @@ ScraperSearchComponent::ScraperSearchComponent(Window* window, SearchType type)
 	addChild(&mGrid);
 
 	mBlockAccept = false;
+	mResolveAssets = true;
 
 	using namespace Eigen;
 
@@ -209,17 +210,33 @@ void ScraperSearchComponent::updateViewStyle()
 }
 
 void ScraperSearchComponent::search(const ScraperSearchParams& params)
+{
+	showBusy();
+
+	mLastSearch = params;
+	mSearchHandle = startScraperSearch(params);
+}
+
+void ScraperSearchComponent::showResults(const ScraperSearchParams& params, const std::vector<ScraperSearchResult>& results)
+{
+	mSearchHandle.reset();
+	mThumbnailReq.reset();
+	mMDResolveHandle.reset();
+
+	mLastSearch = params;
+	onSearchDone(results);
+}
+
+void ScraperSearchComponent::showBusy()
 {
 	mBlockAccept = true;
 
 	mResultList->clear();
 	mScraperResults.clear();
+	mSearchHandle.reset();
 	mThumbnailReq.reset();
 	mMDResolveHandle.reset();
 	updateInfoPane();
-
-	mLastSearch = params;
-	mSearchHandle = startScraperSearch(params);
 }
 
 void ScraperSearchComponent::stop()
@@ -374,7 +391,7 @@ void ScraperSearchComponent::returnResult(ScraperSearchResult result)
 	mBlockAccept = true;
 
 	// resolve metadata image before returning
-	if(!result.imageUrl.empty())
+	if(mResolveAssets && !result.imageUrl.empty())
 	{
 		mMDResolveHandle = resolveMetaDataAssets(result, mLastSearch);
 		return;
@@ -28,11 +28,17 @@ public:
 	ScraperSearchComponent(Window* window, SearchType searchType = NEVER_AUTO_ACCEPT);
 
 	void search(const ScraperSearchParams& params);
+	// Show results that were searched for elsewhere (e.g. prefetched by GuiScraperMulti) as if search() had just finished
+	void showResults(const ScraperSearchParams& params, const std::vector<ScraperSearchResult>& results);
+	// Clear the current results and show the busy animation until the next search() or showResults()
+	void showBusy();
 	void openInputScreen(ScraperSearchParams& from);
 	void stop();
 	inline SearchType getSearchType() const { return mSearchType; }
 
-	// Metadata assets will be resolved before calling the accept callback (e.g. result.mdl's "image" is automatically downloaded and properly set).
+	// Metadata assets will be resolved before calling the accept callback (e.g. result.mdl's "image" is automatically downloaded and properly set),
+	// unless setResolveAssets(false) is used, in which case the caller has to call resolveMetaDataAssets() itself.
+	inline void setResolveAssets(bool resolve) { mResolveAssets = resolve; }
 	inline void setAcceptCallback(const std::function<void(const ScraperSearchResult&)>& acceptCallback) { mAcceptCallback = acceptCallback; }
 	inline void setSkipCallback(const std::function<void()>& skipCallback) { mSkipCallback = skipCallback; };
 	inline void setCancelCallback(const std::function<void()>& cancelCallback) { mCancelCallback = cancelCallback; }
@@ -94,6 +100,7 @@ private:
 	std::function<void()> mSkipCallback;
 	std::function<void()> mCancelCallback;
 	bool mBlockAccept;
+	bool mResolveAssets;
 
 	std::unique_ptr<ScraperSearchHandle> mSearchHandle;
 	std::unique_ptr<MDResolveHandle> mMDResolveHandle;
@@ -65,6 +65,8 @@ public:
 			it->data.textCache.reset();
 	}
 
+	inline const std::shared_ptr<Font>& getFont() const { return mFont; }
+
 	inline void setUppercase(bool uppercase) 
 	{
 		mUppercase = true;
@@ -133,6 +133,9 @@ void GuiFastSelect::updateGameListSort()
 	const FileData::SortType& sort = FileSorts::SortTypes.at(mSortId);
 
 	FileData* root = mGameList->getCursor()->getSystem()->getRootFolder();
+	if(root->isTreeSortedBy(sort))
+		return;
+
 	root->sort(sort); // will also recursively sort children
 
 	// notify that the root folder was sorted
@@ -141,23 +144,15 @@ void GuiFastSelect::updateGameListSort()
 
 void GuiFastSelect::updateGameListCursor()
 {
-	const std::vector<FileData*>& list = mGameList->getCursor()->getParent()->getChildren();
+	FileData* parent = mGameList->getCursor()->getParent();
 
 	// only skip by letter when the sort mode is alphabetical
 	const FileData::SortType& sort = FileSorts::SortTypes.at(mSortId);
 	if(sort.comparisonFunction != &FileSorts::compareName)
 		return;
 
-	// find the first entry in the list that either exactly matches our target letter or is beyond our target letter
-	for(auto it = list.cbegin(); it != list.cend(); it++)
-	{
-		char check = (*it)->getName().empty() ? 'A' : (*it)->getName()[0];
-
-		// if there's an exact match or we've passed it, set the cursor to this one
-		if(check == LETTERS[mLetterId] || (sort.ascending && check > LETTERS[mLetterId]) || (!sort.ascending && check < LETTERS[mLetterId]))
-		{
-			mGameList->setCursor(*it);
-			break;
-		}
-	}
+	// the first entry in the list that either exactly matches our target letter or is beyond our target letter
+	int index = parent->getFirstChildIndexForLetter(LETTERS[mLetterId]);
+	if(index >= 0)
+		mGameList->setCursor(parent->getChildren().at(index));
 }
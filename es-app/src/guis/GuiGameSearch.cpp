@@ -0,0 +1,99 @@
+#include "guis/GuiGameSearch.h"
+#include "guis/GuiTextEditPopupKeyboard.h"
+#include "views/ViewController.h"
+#include "components/TextComponent.h"
+#include "GameSearchIndex.h"
+#include "SystemData.h"
+#include "Renderer.h"
+
+// how many of the matches are listed
+#define MAX_SEARCH_RESULTS 50
+
+GuiGameSearch::GuiGameSearch(Window* window, SystemData* system) : GuiComponent(window),
+	mMenu(window, "SEARCH GAMES"), mSystem(system)
+{
+	addChild(&mMenu);
+	search("");
+}
+
+void GuiGameSearch::openKeyboard()
+{
+	GuiTextEditPopupKeyboard* keyboard = new GuiTextEditPopupKeyboard(mWindow, "SEARCH GAMES", mQuery,
+		std::bind(&GuiGameSearch::search, this, std::placeholders::_1), false, "SEARCH");
+
+	// only the count while typing, the list is made once when it's closed
+	keyboard->setTextChangedCallback([this, keyboard](const std::string& query) {
+		std::vector<FileData*> best;
+		unsigned int count = GameSearchIndex::getInstance()->search(query, 0, best, mSystem);
+		if(query.empty())
+			keyboard->setTitle("SEARCH GAMES");
+		else if(count == 0)
+			keyboard->setTitle("NO GAMES FOUND");
+		else
+			keyboard->setTitle(std::to_string(count) + (count == 1 ? " GAME FOUND" : " GAMES FOUND"));
+	});
+
+	mWindow->pushGui(keyboard);
+}
+
+void GuiGameSearch::search(const std::string& query)
+{
+	mQuery = query;
+	unsigned int count = GameSearchIndex::getInstance()->search(query, MAX_SEARCH_RESULTS, mResults, mSystem);
+
+	mMenu.clearRows();
+
+	ComponentListRow row;
+	row.addElement(std::make_shared<TextComponent>(mWindow, "SEARCH FOR", Font::get(FONT_SIZE_MEDIUM), 0x777777FF), true);
+	row.addElement(std::make_shared<TextComponent>(mWindow, strToUpper(mQuery), Font::get(FONT_SIZE_MEDIUM), 0x777777FF, ALIGN_RIGHT), false);
+	row.addElement(makeArrow(mWindow), false);
+	row.makeAcceptInputHandler(std::bind(&GuiGameSearch::openKeyboard, this));
+	mMenu.addRow(row);
+
+	for(auto it = mResults.begin(); it != mResults.end(); it++)
+	{
+		FileData* game = *it;
+		row.elements.clear();
+		row.addElement(std::make_shared<TextComponent>(mWindow, game->getName(), Font::get(FONT_SIZE_MEDIUM), 0x777777FF), true);
+		row.addElement(std::make_shared<TextComponent>(mWindow, strToUpper(game->getSystemName()), Font::get(FONT_SIZE_SMALL), 0x999999FF, ALIGN_RIGHT), false);
+		row.makeAcceptInputHandler([this, game] { jumpTo(game); });
+		mMenu.addRow(row, it == mResults.begin());
+	}
+
+	if(mQuery.empty())
+		mMenu.setFooter("");
+	else if(count > mResults.size())
+		mMenu.setFooter(std::to_string(count) + " GAMES FOUND, SHOWING THE FIRST " + std::to_string(mResults.size()));
+	else
+		mMenu.setFooter(std::to_string(count) + (count == 1 ? " GAME FOUND" : " GAMES FOUND"));
+
+	setSize((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+	mMenu.setPosition((mSize.x() - mMenu.getSize().x()) / 2, (mSize.y() - mMenu.getSize().y()) / 2);
+}
+
+void GuiGameSearch::jumpTo(FileData* game)
+{
+	SystemData* system = game->getSystem();
+	delete this;
+
+	ViewController::get()->goToGameList(system);
+	ViewController::get()->getGameListView(system)->setCursor(game);
+}
+
+bool GuiGameSearch::input(InputConfig* config, Input input)
+{
+	if(config->isMappedTo("b", input) && input.value)
+	{
+		delete this;
+		return true;
+	}
+
+	return mMenu.input(config, input);
+}
+
+std::vector<HelpPrompt> GuiGameSearch::getHelpPrompts()
+{
+	auto prompts = mMenu.getHelpPrompts();
+	prompts.push_back(HelpPrompt("b", "close"));
+	return prompts;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "GuiComponent.h"
+#include "components/MenuComponent.h"
+
+class FileData;
+class SystemData;
+
+// Finds games with GameSearchIndex. The number of matches is shown in the keyboard as it's typed,
+// the best ones are listed once it's closed and picking one jumps to it in its gamelist.
+class GuiGameSearch : public GuiComponent
+{
+public:
+	GuiGameSearch(Window* window, SystemData* system); // NULL searches every system
+
+	void openKeyboard();
+
+	bool input(InputConfig* config, Input input) override;
+	std::vector<HelpPrompt> getHelpPrompts() override;
+
+private:
+	void search(const std::string& query);
+	void jumpTo(FileData* game);
+
+	MenuComponent mMenu;
+	SystemData* mSystem;
+	std::string mQuery;
+	std::vector<FileData*> mResults;
+};
@@ -1,5 +1,6 @@
 #include "GuiGamelistOptions.h"
 #include "GuiMetaDataEd.h"
+#include "GuiGameSearch.h"
 #include "views/gamelist/IGameListView.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
@@ -45,6 +46,28 @@ GuiGamelistOptions::GuiGamelistOptions(Window* window, SystemData* system) : Gui
 			mMenu.addRow(row);
 		}
 
+		// jump to a point in the list, for lists too long to scroll through
+		row.elements.clear();
+		mJumpToPercentList = std::make_shared<PercentList>(mWindow, "JUMP TO", false);
+		for(int percent = 0; percent <= 100; percent += 10)
+			mJumpToPercentList->add(std::to_string(percent) + "%", percent, percent == 0);
+
+		row.addElement(std::make_shared<TextComponent>(mWindow, "JUMP TO", Font::get(FONT_SIZE_MEDIUM), 0x777777FF), true);
+		row.addElement(mJumpToPercentList, false);
+		row.input_handler = [&](InputConfig* config, Input input) {
+			if(config->isMappedTo("a", input) && input.value)
+			{
+				jumpToPercent();
+				return true;
+			}
+			else if(mJumpToPercentList->input(config, input))
+			{
+				return true;
+			}
+			return false;
+		};
+		mMenu.addRow(row);
+
 		// sort list by
 		mListSort = std::make_shared<SortList>(mWindow, "SORT GAMES BY", false);
 		for(unsigned int i = 0; i < FileSorts::SortTypes.size(); i++)
@@ -62,6 +85,13 @@ GuiGamelistOptions::GuiGamelistOptions(Window* window, SystemData* system) : Gui
 		mMenu.addRow(row);
 	}
 
+	// search every game, or every system's from a collection
+	row.elements.clear();
+	row.addElement(std::make_shared<TextComponent>(mWindow, "SEARCH GAMES", Font::get(FONT_SIZE_MEDIUM), 0x777777FF), true);
+	row.addElement(makeArrow(mWindow), false);
+	row.makeAcceptInputHandler(std::bind(&GuiGamelistOptions::openGameSearch, this));
+	mMenu.addRow(row);
+
 	// show filtered menu
 	row.elements.clear();
 	row.addElement(std::make_shared<TextComponent>(mWindow, "FILTER GAMELIST", Font::get(FONT_SIZE_MEDIUM), 0x777777FF), true);
@@ -79,10 +109,13 @@ GuiGamelistOptions::~GuiGamelistOptions()
 	// apply sort
 	if (!fromPlaceholder) {
 		FileData* root = getGamelist()->getCursor()->getSystem()->getRootFolder();
-		root->sort(*mListSort->getSelected()); // will also recursively sort children
+		if (!root->isTreeSortedBy(*mListSort->getSelected()))
+		{
+			root->sort(*mListSort->getSelected()); // will also recursively sort children
 
-		// notify that the root folder was sorted
-		getGamelist()->onFileChanged(root, FILE_SORTED);
+			// notify that the root folder was sorted
+			getGamelist()->onFileChanged(root, FILE_SORTED);
+		}
 	}
 	if (mFiltersChanged)
 	{
@@ -107,6 +140,17 @@ void GuiGamelistOptions::openGamelistFilter()
 	mWindow->pushGui(ggf);
 }
 
+void GuiGamelistOptions::openGameSearch()
+{
+	SystemData* system = mSystem->isCollection() ? NULL : mSystem;
+	Window* window = mWindow;
+	delete this;
+
+	GuiGameSearch* search = new GuiGameSearch(window, system);
+	window->pushGui(search);
+	search->openKeyboard();
+}
+
 void GuiGamelistOptions::openMetaDataEd()
 {
 	// open metadata editor
@@ -139,32 +183,22 @@ void GuiGamelistOptions::jumpToLetter()
 	char letter = mJumpToLetterList->getSelected();
 	IGameListView* gamelist = getGamelist();
 
-	// this is a really shitty way to get a list of files
-	const std::vector<FileData*>& files = gamelist->getCursor()->getParent()->getChildren();
-
-	long min = 0;
-	long max = files.size() - 1;
-	long mid = 0;
-
-	while(max >= min)
-	{
-		mid = ((max - min) / 2) + min;
-
-		// game somehow has no first character to check
-		if(files.at(mid)->getName().empty())
-			continue;
+	FileData* parent = gamelist->getCursor()->getParent();
+	int index = parent->getFirstChildIndexForLetter(letter);
+	if(index >= 0)
+		gamelist->setCursor(parent->getChildren().at(index));
 
-		char checkLetter = toupper(files.at(mid)->getName()[0]);
+	delete this;
+}
 
-		if(checkLetter < letter)
-			min = mid + 1;
-		else if(checkLetter > letter || (mid > 0 && (letter == toupper(files.at(mid - 1)->getName()[0]))))
-			max = mid - 1;
-		else
-			break; //exact match found
-	}
+void GuiGamelistOptions::jumpToPercent()
+{
+	int percent = mJumpToPercentList->getSelected();
+	IGameListView* gamelist = getGamelist();
 
-	gamelist->setCursor(files.at(mid));
+	const std::vector<FileData*>& files = gamelist->getCursor()->getParent()->getChildrenListToDisplay();
+	if(!files.empty())
+		gamelist->setCursor(files.at((files.size() - 1) * percent / 100));
 
 	delete this;
 }
@@ -18,14 +18,19 @@ public:
 
 private:
 	void openGamelistFilter();
+	void openGameSearch();
 	void openMetaDataEd();
 	void jumpToLetter();
+	void jumpToPercent();
 
 	MenuComponent mMenu;
 
 	typedef OptionListComponent<char> LetterList;
 	std::shared_ptr<LetterList> mJumpToLetterList;
 
+	typedef OptionListComponent<int> PercentList;
+	std::shared_ptr<PercentList> mJumpToPercentList;
+
 	typedef OptionListComponent<const FileData::SortType*> SortList;
 	std::shared_ptr<SortList> mListSort;
 
@@ -5,6 +5,7 @@
 #include "Log.h"
 #include "Settings.h"
 #include "PowerSaver.h"
+#include "GameFolderWatcher.h"
 #include "guis/GuiMsgBox.h"
 #include "guis/GuiSettings.h"
 #include "guis/GuiScreensaverOptions.h"
@@ -310,6 +311,17 @@ GuiMenu::GuiMenu(Window* window) : GuiComponent(window), mMenu(window, "MAIN MEN
 			s->addWithLabel("PARSE GAMESLISTS ONLY", parse_gamelists);
 			s->addSaveFunc([parse_gamelists] { Settings::getInstance()->setBool("ParseGamelistOnly", parse_gamelists->getState()); });
 
+			auto watch_folders = std::make_shared<SwitchComponent>(mWindow);
+			watch_folders->setState(Settings::getInstance()->getBool("WatchGameFolders"));
+			s->addWithLabel("WATCH GAME FOLDERS", watch_folders);
+			s->addSaveFunc([watch_folders] {
+				if(Settings::getInstance()->getBool("WatchGameFolders") != watch_folders->getState())
+				{
+					Settings::getInstance()->setBool("WatchGameFolders", watch_folders->getState());
+					GameFolderWatcher::getInstance()->watchSystems();
+				}
+			});
+
 #ifndef WIN32
 			// hidden files
 			auto hidden_files = std::make_shared<SwitchComponent>(mWindow);
@@ -3,6 +3,7 @@
 #include "Log.h"
 #include "components/AsyncReqComponent.h"
 #include "Settings.h"
+#include "GameSearchIndex.h"
 #include "views/ViewController.h"
 #include "guis/GuiGameScraper.h"
 #include "guis/GuiMsgBox.h"
@@ -186,9 +187,11 @@ void GuiMetaDataEd::save()
 			continue;
 		mMetaData->set(mMetaDataDecl.at(i).key, mEditors.at(i)->getValue());
 	}
+	mScraperParams.game->onMetadataChanged();
 
 	// enter game in index
 	mScraperParams.system->getIndex()->addToIndex(mScraperParams.game);
+	GameSearchIndex::getInstance()->updateGame(mScraperParams.game);
 
 	if(mSavedCallback)
 		mSavedCallback();
@@ -4,6 +4,8 @@
 #include "views/ViewController.h"
 #include "Gamelist.h"
 #include "PowerSaver.h"
+#include "Settings.h"
+#include "GameSearchIndex.h"
 
 #include "components/TextComponent.h"
 #include "components/ButtonComponent.h"
@@ -13,6 +15,9 @@
 
 using namespace Eigen;
 
+// how often scraped metadata is written back to the gamelists while scraping, in ms
+#define GAMELIST_SAVE_INTERVAL 30000
+
 GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchParams>& searches, bool approveResults) : 
 	GuiComponent(window), mBackground(window, ":/frame.png"), mGrid(window, Vector2i(1, 5)), 
 	mSearchQueue(searches)
@@ -29,6 +34,12 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 	mCurrentGame = 0;
 	mTotalSuccessful = 0;
 	mTotalSkipped = 0;
+	mTimeSinceSave = 0;
+	mFinished = false;
+
+	mConcurrency = Settings::getInstance()->getInt("ScraperConcurrency");
+	if(mConcurrency < 1)
+		mConcurrency = 1;
 
 	// set up grid
 	mTitle = std::make_shared<TextComponent>(mWindow, "SCRAPING IN PROGRESS", Font::get(FONT_SIZE_LARGE), 0x555555FF, ALIGN_CENTER);
@@ -42,6 +53,7 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 
 	mSearchComp = std::make_shared<ScraperSearchComponent>(mWindow, 
 		approveResults ? ScraperSearchComponent::ALWAYS_ACCEPT_MATCHING_CRC : ScraperSearchComponent::ALWAYS_ACCEPT_FIRST_RESULT);
+	mSearchComp->setResolveAssets(false); // downloaded here so that several can run at once
 	mSearchComp->setAcceptCallback(std::bind(&GuiScraperMulti::acceptResult, this, std::placeholders::_1));
 	mSearchComp->setSkipCallback(std::bind(&GuiScraperMulti::skip, this));
 	mSearchComp->setCancelCallback(std::bind(&GuiScraperMulti::finish, this));
@@ -52,7 +64,8 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 	if(approveResults)
 	{
 		buttons.push_back(std::make_shared<ButtonComponent>(mWindow, "INPUT", "search", [&] { 
-			mSearchComp->openInputScreen(mSearchQueue.front()); 
+			if(mShown)
+				mSearchComp->openInputScreen(mShown->params);
 			mGrid.resetCursor(); 
 		}));
 
@@ -70,7 +83,8 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 	setSize(Renderer::getScreenWidth() * 0.95f, Renderer::getScreenHeight() * 0.849f);
 	setPosition((Renderer::getScreenWidth() - mSize.x()) / 2, (Renderer::getScreenHeight() - mSize.y()) / 2);
 
-	doNextSearch();
+	mSearchComp->showBusy();
+	startSearches();
 }
 
 GuiScraperMulti::~GuiScraperMulti()
@@ -91,50 +105,189 @@ void GuiScraperMulti::onSizeChanged()
 	mGrid.setSize(mSize);
 }
 
-void GuiScraperMulti::doNextSearch()
+void GuiScraperMulti::update(int deltaTime)
 {
-	if(mSearchQueue.empty())
+	GuiComponent::update(deltaTime);
+
+	if(mFinished)
+		return;
+
+	updateSearches();
+	updateResolves();
+	startSearches();
+	showNextResult();
+
+	mTimeSinceSave += deltaTime;
+	if(mTimeSinceSave >= GAMELIST_SAVE_INTERVAL)
+		saveGamelists();
+
+	if(mSearchQueue.empty() && mSearching.empty() && !mShown && mResolving.empty())
 	{
 		PowerSaver::setState(true);
 		finish();
-		return;
 	}
+}
+
+void GuiScraperMulti::startSearches()
+{
+	// all of the searches share HttpReq's curl multi handle, so they run side by side
+	while(!mSearchQueue.empty() && mSearching.size() < mConcurrency)
+	{
+		std::unique_ptr<ScrapeJob> job(new ScrapeJob());
+		job->params = mSearchQueue.front();
+		job->search = startScraperSearch(job->params);
+		job->searchStatus = ASYNC_IN_PROGRESS;
+		mSearchQueue.pop();
+
+		mSearching.push_back(std::move(job));
+	}
+}
+
+void GuiScraperMulti::updateSearches()
+{
+	for(auto it = mSearching.begin(); it != mSearching.end(); it++)
+	{
+		ScrapeJob* job = it->get();
+		if(!job->search)
+			continue;
+
+		job->searchStatus = job->search->status();
+		if(job->searchStatus == ASYNC_IN_PROGRESS)
+			continue;
+
+		if(job->searchStatus == ASYNC_DONE)
+			job->results = job->search->getResults();
+		else
+			LOG(LogWarning) << "Background search for \"" << job->params.game->getPath().filename().string() << "\" failed: " << job->search->getStatusString();
+
+		job->search.reset();
+	}
+}
+
+void GuiScraperMulti::showNextResult()
+{
+	// results are shown in queue order, and not while too many downloads are still running
+	if(mShown || mSearching.empty() || mResolving.size() >= mConcurrency)
+		return;
+
+	if(mSearching.front()->searchStatus == ASYNC_IN_PROGRESS)
+		return;
+
+	mShown = std::move(mSearching.front());
+	mSearching.pop_front();
 
 	// update title
 	std::stringstream ss;
-	mSystem->setText(strToUpper(mSearchQueue.front().system->getFullName()));
+	mSystem->setText(strToUpper(mShown->params.system->getFullName()));
 
 	// update subtitle
 	ss.str(""); // clear
-	ss << "GAME " << (mCurrentGame + 1) << " OF " << mTotalGames << " - " << strToUpper(mSearchQueue.front().game->getPath().filename().string());
+	ss << "GAME " << (mCurrentGame + 1) << " OF " << mTotalGames << " - " << strToUpper(mShown->params.game->getPath().filename().string());
 	mSubtitle->setText(ss.str());
 
-	mSearchComp->search(mSearchQueue.front());
+	// in auto accept mode this calls acceptResult() or skip() straight away
+	if(mShown->searchStatus == ASYNC_DONE)
+		mSearchComp->showResults(mShown->params, mShown->results);
+	else
+		mSearchComp->search(mShown->params); // search again in the foreground so any error gets the usual retry/skip prompt
 }
 
 void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
 {
-	ScraperSearchParams& search = mSearchQueue.front();
-
-	search.game->metadata = result.mdl;
-	updateGamelist(search.system);
+	if(!mShown)
+		return;
 
-	mSearchQueue.pop();
+	std::unique_ptr<ScrapeJob> job = std::move(mShown);
 	mCurrentGame++;
-	mTotalSuccessful++;
-	doNextSearch();
+	mSearchComp->showBusy();
+
+	if(result.imageUrl.empty())
+	{
+		applyResult(*job, result);
+		return;
+	}
+
+	job->accepted = result;
+	job->resolve = resolveMetaDataAssets(result, job->params);
+	mResolving.push_back(std::move(job));
 }
 
 void GuiScraperMulti::skip()
 {
-	mSearchQueue.pop();
+	if(!mShown)
+		return;
+
+	mShown.reset();
 	mCurrentGame++;
 	mTotalSkipped++;
-	doNextSearch();
+	mSearchComp->showBusy();
+}
+
+void GuiScraperMulti::updateResolves()
+{
+	for(auto it = mResolving.begin(); it != mResolving.end(); )
+	{
+		ScrapeJob* job = it->get();
+		AsyncHandleStatus status = job->resolve->status();
+		if(status == ASYNC_IN_PROGRESS)
+		{
+			it++;
+			continue;
+		}
+
+		if(status == ASYNC_DONE)
+		{
+			applyResult(*job, job->resolve->getResult());
+		}else{
+			// keep the rest of the metadata rather than holding up the whole batch
+			LOG(LogWarning) << "Could not download media for \"" << job->params.game->getPath().filename().string() << "\": " << job->resolve->getStatusString();
+			applyResult(*job, job->accepted);
+		}
+
+		it = mResolving.erase(it);
+	}
+}
+
+void GuiScraperMulti::applyResult(ScrapeJob& job, const ScraperSearchResult& result)
+{
+	job.params.game->metadata = result.mdl;
+	job.params.game->onMetadataChanged();
+	GameSearchIndex::getInstance()->updateGame(job.params.game);
+	mDirtySystems.insert(job.params.system);
+	mTotalSuccessful++;
+}
+
+void GuiScraperMulti::saveGamelists()
+{
+	// every save rewrites the system's whole gamelist.xml, so they're batched up
+	for(auto it = mDirtySystems.begin(); it != mDirtySystems.end(); it++)
+		updateGamelist(*it);
+
+	mDirtySystems.clear();
+	mTimeSinceSave = 0;
 }
 
 void GuiScraperMulti::finish()
 {
+	if(mFinished)
+		return;
+	mFinished = true;
+
+	// keep whatever has finished downloading, anything still in flight is dropped
+	updateResolves();
+	if(!mResolving.empty())
+		LOG(LogInfo) << "Scraping stopped with " << mResolving.size() << " downloads in progress, those games were not updated";
+	mResolving.clear();
+	mSearching.clear();
+	mShown.reset();
+	mSearchComp->stop();
+
+	saveGamelists();
+
+	const HttpReq::CacheStats& cache = HttpReq::getCacheStats();
+	LOG(LogInfo) << "Scraper HTTP cache: " << cache.hits << " hits (" << cache.revalidated << " revalidated), " << cache.misses << " misses, "
+		<< cache.shared << " shared";
+
 	std::stringstream ss;
 	if(mTotalSuccessful == 0)
 	{
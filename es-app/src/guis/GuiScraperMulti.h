@@ -6,6 +6,9 @@
 #include "scrapers/Scraper.h"
 
 #include <queue>
+#include <list>
+#include <set>
+#include <memory>
 
 class ScraperSearchComponent;
 class TextComponent;
@@ -17,20 +20,50 @@ public:
 	virtual ~GuiScraperMulti();
 
 	void onSizeChanged() override;
+	void update(int deltaTime) override;
 	std::vector<HelpPrompt> getHelpPrompts() override;
 
 private:
+	// One game on its way through the pipeline. It is searched for in the background, shown
+	// to the user (or accepted automatically) in queue order, then its media is downloaded
+	// in the background while the next games are handled.
+	struct ScrapeJob
+	{
+		ScraperSearchParams params;
+		std::unique_ptr<ScraperSearchHandle> search;
+		AsyncHandleStatus searchStatus;
+		std::vector<ScraperSearchResult> results;
+
+		ScraperSearchResult accepted;
+		std::unique_ptr<MDResolveHandle> resolve;
+	};
+
 	void acceptResult(const ScraperSearchResult& result);
 	void skip();
-	void doNextSearch();
-	
+
+	void startSearches();
+	void updateSearches();
+	void showNextResult();
+	void updateResolves();
+	void applyResult(ScrapeJob& job, const ScraperSearchResult& result);
+	void saveGamelists();
+
 	void finish();
 
 	unsigned int mTotalGames;
 	unsigned int mCurrentGame;
 	unsigned int mTotalSuccessful;
 	unsigned int mTotalSkipped;
-	std::queue<ScraperSearchParams> mSearchQueue;
+	std::queue<ScraperSearchParams> mSearchQueue;	// not started yet
+
+	unsigned int mConcurrency;						// searches and downloads allowed in flight
+	std::list< std::unique_ptr<ScrapeJob> > mSearching;	// searching or ready to show, in queue order
+	std::unique_ptr<ScrapeJob> mShown;				// waiting on mSearchComp
+	std::list< std::unique_ptr<ScrapeJob> > mResolving;	// accepted, downloading media
+
+	std::set<SystemData*> mDirtySystems;			// scraped since their gamelist was last saved
+	int mTimeSinceSave;
+	bool mFinished;
 
 	NinePatchComponent mBackground;
 	ComponentGrid mGrid;
@@ -20,6 +20,9 @@
 #include "PowerSaver.h"
 #include "Settings.h"
 #include "ScraperCmdLine.h"
+#include "GameFolderWatcher.h"
+#include "HttpReq.h"
+#include "ThreadPool.h"
 #include <sstream>
 #include <boost/locale.hpp>
 
@@ -30,6 +33,7 @@
 namespace fs = boost::filesystem;
 
 bool scrape_cmdline = false;
+ScraperCmdLineOptions scrape_options;
 
 bool parseArgs(int argc, char* argv[], unsigned int* width, unsigned int* height)
 {
@@ -82,6 +86,48 @@ bool parseArgs(int argc, char* argv[], unsigned int* width, unsigned int* height
 		}else if(strcmp(argv[i], "--scrape") == 0)
 		{
 			scrape_cmdline = true;
+		}else if(strcmp(argv[i], "--scrape-systems") == 0)
+		{
+			if(i >= argc - 1)
+			{
+				std::cerr << "Invalid system list supplied.";
+				return false;
+			}
+
+			std::stringstream ss(argv[i + 1]);
+			std::string name;
+			while(std::getline(ss, name, ','))
+			{
+				if(!name.empty())
+					scrape_options.systems.push_back(name);
+			}
+			i++; // skip the system list
+		}else if(strcmp(argv[i], "--scrape-all") == 0)
+		{
+			scrape_options.overwrite = true;
+		}else if(strcmp(argv[i], "--scrape-restart") == 0)
+		{
+			scrape_options.restart = true;
+		}else if(strcmp(argv[i], "--scrape-concurrency") == 0)
+		{
+			if(i >= argc - 1)
+			{
+				std::cerr << "Invalid concurrency supplied.";
+				return false;
+			}
+
+			Settings::getInstance()->setInt("ScraperConcurrency", atoi(argv[i + 1]));
+			i++; // skip the concurrency value
+		}else if(strcmp(argv[i], "--scraper-url") == 0)
+		{
+			if(i >= argc - 1)
+			{
+				std::cerr << "Invalid scraper URL supplied.";
+				return false;
+			}
+
+			Settings::getInstance()->setString("ScraperUrl", argv[i + 1]);
+			i++; // skip the URL
 		}else if(strcmp(argv[i], "--max-vram") == 0)
 		{
 			int maxVRAM = atoi(argv[i + 1]);
@@ -108,7 +154,12 @@ bool parseArgs(int argc, char* argv[], unsigned int* width, unsigned int* height
 				"--no-exit			don't show the exit option in the menu\n"
 				"--no-splash			don't show the splash screen\n"
 				"--debug				more logging, show console on Windows\n"
-				"--scrape			scrape using command line interface\n"
+				"--scrape			scrape without a window, then quit\n"
+				"--scrape-systems [a,b,...]	only scrape these systems (default is all of them)\n"
+				"--scrape-all			also scrape games that already have an image\n"
+				"--scrape-restart		start over instead of resuming an interrupted scrape\n"
+				"--scrape-concurrency [n]	number of games to scrape at once\n"
+				"--scraper-url [url]		base URL of the scraper API, e.g. a local test server\n"
 				"--windowed			not fullscreen, should be used with --resolution\n"
 				"--vsync [1/on or 0/off]		turn vsync on or off (default is on)\n"
 				"--max-vram [size]		Max VRAM to use in Mb before swapping. 0 for unlimited\n"
@@ -266,6 +317,13 @@ int main(int argc, char* argv[])
 			return 1;
 		}
 
+		// there's no window to show it in when scraping
+		if(scrape_cmdline)
+		{
+			std::cerr << errorMsg << "\n";
+			return 1;
+		}
+
 		// we can't handle es_systems.cfg file problems inside ES itself, so display the error message then quit
 		window.pushGui(new GuiMsgBox(&window,
 			errorMsg,
@@ -279,7 +337,10 @@ int main(int argc, char* argv[])
 	//run the command line scraper then quit
 	if(scrape_cmdline)
 	{
-		return run_scraper_cmdline();
+		int result = run_scraper_cmdline(scrape_options);
+		HttpReq::shutdown();
+		ThreadPool::shutdown();
+		return result;
 	}
 
 	//dont generate joystick events while we're loading (hopefully fixes "automatically started emulator" bug)
@@ -289,6 +350,9 @@ int main(int argc, char* argv[])
 	// this makes for no delays when accessing content, but a longer startup time
 	ViewController::get()->preload();
 
+	if(errorMsg == NULL)
+		GameFolderWatcher::getInstance()->watchSystems();
+
 	//choose which GUI to open depending on if an input configuration already exists
 	if(errorMsg == NULL)
 	{
@@ -362,6 +426,7 @@ int main(int argc, char* argv[])
 		if((deltaTime > PowerSaver::getTimeout() && PowerSaver::getTimeout() > 0) || deltaTime < 0)
 			deltaTime = 1000;
 
+		GameFolderWatcher::getInstance()->update(deltaTime, window.peekGui() == ViewController::get() && !screensaver.isScreenSaverActive());
 		window.update(deltaTime);
 		window.render();
 		Renderer::swapBuffers();
@@ -373,7 +438,10 @@ int main(int argc, char* argv[])
 		delete window.peekGui();
 	window.deinit();
 
+	GameFolderWatcher::getInstance()->stop();
+	ThreadPool::shutdown(); // theme loads and glyph rendering may still be going
 	SystemData::deleteSystems();
+	HttpReq::shutdown();
 
 	LOG(LogInfo) << "EmulationStation cleanly shutting down.";
 
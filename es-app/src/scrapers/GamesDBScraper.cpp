@@ -74,7 +74,7 @@ const std::map<PlatformId, const char*> gamesdb_platformid_map = boost::assign::
 void thegamesdb_generate_scraper_requests(const ScraperSearchParams& params, std::queue< std::unique_ptr<ScraperRequest> >& requests, 
 	std::vector<ScraperSearchResult>& results)
 {
-	std::string path = "thegamesdb.net/api/GetGame.php?";
+	std::string path = Settings::getInstance()->getString("ScraperUrl") + "GetGame.php?";
 	bool usingGameID = false;
 
 	std::string cleanName = params.nameOverride;
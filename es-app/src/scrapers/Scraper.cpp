@@ -1,7 +1,9 @@
 #include "scrapers/Scraper.h"
 #include "Log.h"
 #include "Settings.h"
+#include "ThreadPool.h"
 #include <FreeImage.h>
+#include <fstream>
 #include <boost/filesystem.hpp>
 #include <boost/assign.hpp>
 
@@ -123,9 +125,16 @@ MDResolveHandle::MDResolveHandle(const ScraperSearchResult& result, const Scrape
 	if(!result.imageUrl.empty())
 	{
 		std::string imgPath = getSaveAsPath(search, "image", result.imageUrl);
-		mFuncs.push_back(ResolvePair(downloadImageAsync(result.imageUrl, imgPath), [this, imgPath]
+
+		std::string thumbPath;
+		if(Settings::getInstance()->getInt("ScraperThumbnailWidth") != 0 || Settings::getInstance()->getInt("ScraperThumbnailHeight") != 0)
+			thumbPath = getSaveAsPath(search, "thumbnail", result.imageUrl);
+
+		mFuncs.push_back(ResolvePair(downloadImageAsync(result.imageUrl, imgPath, thumbPath), [this, imgPath, thumbPath]
 		{
 			mResult.mdl.set("image", imgPath);
+			if(!thumbPath.empty())
+				mResult.mdl.set("thumbnail", thumbPath);
 			mResult.imageUrl = "";
 		}));
 	}
@@ -156,19 +165,45 @@ void MDResolveHandle::update()
 		setStatus(ASYNC_DONE);
 }
 
-std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url, const std::string& saveAs)
+std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url, const std::string& saveAs, const std::string& thumbnailSaveAs)
 {
-	return std::unique_ptr<ImageDownloadHandle>(new ImageDownloadHandle(url, saveAs, 
-		Settings::getInstance()->getInt("ScraperResizeWidth"), Settings::getInstance()->getInt("ScraperResizeHeight")));
+	std::vector<ImageSaveTarget> targets;
+
+	ImageSaveTarget image = { saveAs, Settings::getInstance()->getInt("ScraperResizeWidth"), Settings::getInstance()->getInt("ScraperResizeHeight") };
+	targets.push_back(image);
+
+	if(!thumbnailSaveAs.empty())
+	{
+		ImageSaveTarget thumbnail = { thumbnailSaveAs, Settings::getInstance()->getInt("ScraperThumbnailWidth"), Settings::getInstance()->getInt("ScraperThumbnailHeight") };
+		targets.push_back(thumbnail);
+	}
+
+	return std::unique_ptr<ImageDownloadHandle>(new ImageDownloadHandle(url, targets));
 }
 
-ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight) : 
-	mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight), mReq(new HttpReq(url))
+ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::vector<ImageSaveTarget>& targets) : 
+	mReq(new HttpReq(url)), mTargets(targets)
 {
 }
 
 void ImageDownloadHandle::update()
 {
+	if(mStatus != ASYNC_IN_PROGRESS)
+		return;
+
+	if(mSave.valid())
+	{
+		if(mSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		mSave.get();
+		if(!mSaveError->empty())
+			setError(*mSaveError);
+		else
+			setStatus(ASYNC_DONE);
+		return;
+	}
+
 	if(mReq->status() == HttpReq::REQ_IN_PROGRESS)
 		return;
 
@@ -180,89 +215,121 @@ void ImageDownloadHandle::update()
 		return;
 	}
 
-	// download is done, save it to disk
-	std::ofstream stream(mSavePath, std::ios_base::out | std::ios_base::binary);
-	if(stream.bad())
-	{
-		setError("Failed to open image path to write. Permission error? Disk full?");
-		return;
-	}
+	// download is done, decode, resize and save it on the worker pool so several images can be processed at once.
+	// Cached images are saved again too, the resize settings may have changed since.
+	std::shared_ptr<std::string> content = std::make_shared<std::string>(mReq->getContent());
+	const std::vector<ImageSaveTarget> targets = mTargets;
+	std::shared_ptr<std::string> error = std::make_shared<std::string>();
+	mSaveError = error;
+	mReq.reset();
 
-	const std::string& content = mReq->getContent();
-	stream.write(content.data(), content.length());
-	stream.close();
-	if(stream.bad())
+	mSave = ThreadPool::getInstance()->queueWorkItem([content, targets, error]
 	{
-		setError("Failed to save image. Disk full?");
-		return;
-	}
+		saveImageFromMemory(*content, targets, *error);
+	});
+}
+
+// returns NULL if it couldn't be resized, [image] is left alone either way
+static FIBITMAP* rescaleImage(FIBITMAP* image, int maxWidth, int maxHeight)
+{
+	float width = (float)FreeImage_GetWidth(image);
+	float height = (float)FreeImage_GetHeight(image);
 
-	// resize it
-	if(!resizeImage(mSavePath, mMaxWidth, mMaxHeight))
+	if(maxWidth == 0)
 	{
-		setError("Error saving resized image. Out of memory? Disk full?");
-		return;
+		maxWidth = (int)((maxHeight / height) * width);
+	}else if(maxHeight == 0)
+	{
+		maxHeight = (int)((maxWidth / width) * height);
 	}
 
-	setStatus(ASYNC_DONE);
+	return FreeImage_Rescale(image, maxWidth, maxHeight, FILTER_BILINEAR);
 }
 
-//you can pass 0 for width or height to keep aspect ratio
-bool resizeImage(const std::string& path, int maxWidth, int maxHeight)
+static bool writeImageData(const std::string& data, const std::string& path, std::string& error)
 {
-	// nothing to do
-	if(maxWidth == 0 && maxHeight == 0)
-		return true;
-
-	FREE_IMAGE_FORMAT format = FIF_UNKNOWN;
-	FIBITMAP* image = NULL;
-	
-	//detect the filetype
-	format = FreeImage_GetFileType(path.c_str(), 0);
-	if(format == FIF_UNKNOWN)
-		format = FreeImage_GetFIFFromFilename(path.c_str());
-	if(format == FIF_UNKNOWN)
+	std::ofstream stream(path, std::ios_base::out | std::ios_base::binary);
+	if(stream.bad())
 	{
-		LOG(LogError) << "Error - could not detect filetype for image \"" << path << "\"!";
+		error = "Failed to open image path to write. Permission error? Disk full?";
 		return false;
 	}
 
-	//make sure we can read this filetype first, then load it
-	if(FreeImage_FIFSupportsReading(format))
+	stream.write(data.data(), data.length());
+	stream.close();
+	if(stream.bad())
 	{
-		image = FreeImage_Load(format, path.c_str());
-	}else{
-		LOG(LogError) << "Error - file format reading not supported for image \"" << path << "\"!";
+		error = "Failed to save image. Disk full?";
 		return false;
 	}
 
-	float width = (float)FreeImage_GetWidth(image);
-	float height = (float)FreeImage_GetHeight(image);
+	return true;
+}
 
-	if(maxWidth == 0)
-	{
-		maxWidth = (int)((maxHeight / height) * width);
-	}else if(maxHeight == 0)
+bool saveImageFromMemory(const std::string& data, const std::vector<ImageSaveTarget>& targets, std::string& error)
+{
+	FIMEMORY* memory = NULL;
+	FIBITMAP* image = NULL;
+	FREE_IMAGE_FORMAT format = FIF_UNKNOWN;
+	bool success = true;
+
+	for(auto it = targets.begin(); it != targets.end() && success; it++)
 	{
-		maxHeight = (int)((maxWidth / width) * height);
-	}
+		// nothing to resize, the downloaded file is written as it is
+		if(it->maxWidth == 0 && it->maxHeight == 0)
+		{
+			success = writeImageData(data, it->path, error);
+			continue;
+		}
+
+		// only decoded once, however many sizes are written
+		if(image == NULL)
+		{
+			memory = FreeImage_OpenMemory((BYTE*)data.data(), (DWORD)data.size());
+
+			//detect the filetype
+			format = FreeImage_GetFileTypeFromMemory(memory, 0);
+			if(format == FIF_UNKNOWN)
+				format = FreeImage_GetFIFFromFilename(it->path.c_str());
+			if(format == FIF_UNKNOWN || !FreeImage_FIFSupportsReading(format))
+			{
+				LOG(LogError) << "Error - could not detect filetype for image \"" << it->path << "\"!";
+				error = "Unknown image format.";
+				success = false;
+				break;
+			}
+
+			image = FreeImage_LoadFromMemory(format, memory);
+			if(image == NULL)
+			{
+				error = "Could not decode image.";
+				success = false;
+				break;
+			}
+		}
+
+		FIBITMAP* imageRescaled = rescaleImage(image, it->maxWidth, it->maxHeight);
+		if(imageRescaled == NULL)
+		{
+			LOG(LogError) << "Could not resize image! (not enough memory? invalid bitdepth?)";
+			error = "Error resizing image. Out of memory?";
+			success = false;
+			break;
+		}
 
-	FIBITMAP* imageRescaled = FreeImage_Rescale(image, maxWidth, maxHeight, FILTER_BILINEAR);
-	FreeImage_Unload(image);
+		success = FreeImage_Save(format, imageRescaled, it->path.c_str()) != 0;
+		FreeImage_Unload(imageRescaled);
 
-	if(imageRescaled == NULL)
-	{
-		LOG(LogError) << "Could not resize image! (not enough memory? invalid bitdepth?)";
-		return false;
+		if(!success)
+			error = "Error saving resized image. Disk full?";
 	}
 
-	bool saved = FreeImage_Save(format, imageRescaled, path.c_str());
-	FreeImage_Unload(imageRescaled);
-
-	if(!saved)
-		LOG(LogError) << "Failed to save resized image!";
+	if(image)
+		FreeImage_Unload(image);
+	if(memory)
+		FreeImage_CloseMemory(memory);
 
-	return saved;
+	return success;
 }
 
 std::string getSaveAsPath(const ScraperSearchParams& params, const std::string& suffix, const std::string& url)
@@ -7,6 +7,8 @@
 #include <vector>
 #include <functional>
 #include <queue>
+#include <future>
+#include <memory>
 
 #define MAX_SCRAPER_RESULTS 7
 
@@ -126,18 +128,28 @@ private:
 	std::vector<ResolvePair> mFuncs;
 };
 
+// Somewhere to write a downloaded image, resized to maxWidth x maxHeight (0 for either keeps the aspect ratio, 0 for both keeps the original).
+struct ImageSaveTarget
+{
+	std::string path;
+	int maxWidth;
+	int maxHeight;
+};
+
 class ImageDownloadHandle : public AsyncHandle
 {
 public:
-	ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight);
+	ImageDownloadHandle(const std::string& url, const std::vector<ImageSaveTarget>& targets);
 
 	void update() override;
 
 private:
 	std::unique_ptr<HttpReq> mReq;
-	std::string mSavePath;
-	int mMaxWidth;
-	int mMaxHeight;
+	std::vector<ImageSaveTarget> mTargets;
+
+	// decoding, resizing and saving runs on the worker pool, mSaveError is set there if it fails
+	std::future<void> mSave;
+	std::shared_ptr<std::string> mSaveError;
 };
 
 //About the same as "~/.emulationstation/downloaded_images/[system_name]/[game_name].[url's extension]".
@@ -145,12 +157,12 @@ private:
 std::string getSaveAsPath(const ScraperSearchParams& params, const std::string& suffix, const std::string& url);
 
 //Will resize according to Settings::getInt("ScraperResizeWidth") and Settings::getInt("ScraperResizeHeight").
-std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url, const std::string& saveAs);
+//If thumbnailSaveAs isn't empty, a thumbnail sized by "ScraperThumbnailWidth"/"ScraperThumbnailHeight" is written there too.
+std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url, const std::string& saveAs, const std::string& thumbnailSaveAs = "");
 
 // Resolves all metadata assets that need to be downloaded.
 std::unique_ptr<MDResolveHandle> resolveMetaDataAssets(const ScraperSearchResult& result, const ScraperSearchParams& search);
 
-//You can pass 0 for maxWidth or maxHeight to automatically keep the aspect ratio.
-//Will overwrite the image at [path] with the new resized one.
-//Returns true if successful, false otherwise.
-bool resizeImage(const std::string& path, int maxWidth, int maxHeight);
+//Decodes an image from memory once and writes each target, resized if it needs to be.
+//Returns true if successful, otherwise false with a message in [error].
+bool saveImageFromMemory(const std::string& data, const std::vector<ImageSaveTarget>& targets, std::string& error);
@@ -28,8 +28,24 @@ SystemView::SystemView(Window* window) : IList<SystemViewData, SystemData*>(wind
 
 void SystemView::populate()
 {
+	const unsigned int startTime = SDL_GetTicks();
+
 	mEntries.clear();
 
+	// Decode every logo on the worker pool up front. The ImageComponents below then find them
+	// already loaded and only the GL upload is left for the main thread
+	std::vector<std::string> logoPaths;
+	for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
+	{
+		if(!(*it)->getSystemEnabled())
+			continue;
+
+		const ThemeData::ThemeElement* logoElem = (*it)->getTheme()->getElement("system", "logo", "image");
+		if(logoElem && logoElem->has("path"))
+			logoPaths.push_back(logoElem->get<std::string>("path"));
+	}
+	std::vector< std::shared_ptr<TextureResource> > logoTextures = TextureResource::preload(logoPaths);
+
 	for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
 	{
 		// skips system if it's not enabled
@@ -103,6 +119,8 @@ void SystemView::populate()
 
 		this->add(e);
 	}
+
+	LOG(LogInfo) << "System carousel ready in " << (SDL_GetTicks() - startTime) << "ms (" << mEntries.size() << " systems, " << logoPaths.size() << " logos)";
 }
 
 void SystemView::goToSystem(SystemData* system, bool animate)
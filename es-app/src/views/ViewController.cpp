@@ -13,7 +13,10 @@
 #include "animations/LaunchAnimation.h"
 #include "animations/MoveCameraAnimation.h"
 #include "animations/LambdaAnimation.h"
+#include "resources/Font.h"
+#include "resources/SVGCache.h"
 #include <SDL.h>
+#include <set>
 
 ViewController* ViewController::sInstance = NULL;
 
@@ -144,8 +147,7 @@ void ViewController::goToRandomGame()
 			else
 			{
 				goToGameList(*it);
-				std::vector<FileData*> list = (*it)->getRootFolder()->getFilesRecursive(GAME, true);
-				getGameListView(*it)->setCursor(list.at(target));
+				getGameListView(*it)->setCursor((*it)->getRootFolder()->getDisplayedGame(target));
 				return;
 			}
 		}
@@ -213,6 +215,13 @@ void ViewController::onFileChanged(FileData* file, FileChangeType change)
 		it->second->onFileChanged(file, change);
 }
 
+void ViewController::onFilesRemoving(SystemData* system, const std::unordered_set<FileData*>& removed)
+{
+	auto it = mGameListViews.find(system);
+	if(it != mGameListViews.end())
+		it->second->onFilesRemoving(removed);
+}
+
 void ViewController::launch(FileData* game, Eigen::Vector3f center)
 {
 	if(game->getType() != GAME)
@@ -420,6 +429,33 @@ void ViewController::render(const Eigen::Affine3f& parentTrans)
 
 void ViewController::preload()
 {
+	// rasterize every character the game names need in the background, so scrolling
+	// through a list of Japanese titles the first time doesn't stop to render each one
+	std::set<UnicodeChar> chars;
+	for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
+	{
+		if((*it)->isCollection())
+			continue;
+
+		std::vector<FileData*> files = (*it)->getRootFolder()->getFilesRecursive(GAME | FOLDER);
+		for(auto fileIt = files.begin(); fileIt != files.end(); fileIt++)
+		{
+			const std::string& name = (*fileIt)->getName();
+			size_t i = 0;
+			while(i < name.length())
+			{
+				// ASCII is always loaded
+				const size_t start = i;
+				const UnicodeChar c = Font::readUnicodeChar(name, i);
+				if(i == start)
+					break; // not utf8
+				if(c >= 128)
+					chars.insert(c);
+			}
+		}
+	}
+	Font::setWarmGlyphs(chars);
+
 	for(auto it = SystemData::sSystemVector.begin(); it != SystemData::sSystemVector.end(); it++)
 	{
 		getGameListView(*it);
@@ -466,11 +502,16 @@ void ViewController::reloadAll()
 	}
 	mGameListViews.clear();
 
+	// the theme's SVGs and fonts may have been edited
+	SVGCache::clear();
+	Font::clearFaceCache();
+
+	// parse all of the themes at once, getGameListView() waits for each one as it needs it
+	for(auto it = cursorMap.begin(); it != cursorMap.end(); it++)
+		it->first->loadThemeAsync();
+
 	for(auto it = cursorMap.begin(); it != cursorMap.end(); it++)
-	{
-		it->first->loadTheme();
 		getGameListView(it->first)->setCursor(it->second);
-	}
 
 	mSystemListView.reset();
 	getSystemListView();
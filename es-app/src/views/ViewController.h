@@ -33,6 +33,7 @@ public:
 	void goToRandomGame();
 
 	void onFileChanged(FileData* file, FileChangeType change);
+	void onFilesRemoving(SystemData* system, const std::unordered_set<FileData*>& removed);
 
 	// Plays a nice launch effect and launches the game at the end of it.
 	// Once the game terminates, plays a return effect.
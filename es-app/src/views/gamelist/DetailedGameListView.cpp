@@ -21,7 +21,11 @@ DetailedGameListView::DetailedGameListView(Window* window, FileData* root) :
 	mList.setPosition(mSize.x() * (0.50f + padding), mList.getPosition().y());
 	mList.setSize(mSize.x() * (0.50f - padding), mList.getSize().y());
 	mList.setAlignment(TextListComponent<FileData*>::ALIGN_LEFT);
-	mList.setCursorChangedCallback([&](const CursorState& state) { updateInfoPanel(); });
+	mList.setCursorChangedCallback([&](const CursorState& state) {
+		// start loading the images around where the cursor is heading before they're needed
+		mList.prefetchTextures(mImagePrefetcher, [](FileData* const& file) { return file->metadata.get("image"); });
+		updateInfoPanel();
+	});
 
 	// image
 	mImage.setOrigin(0.5f, 0.5f);
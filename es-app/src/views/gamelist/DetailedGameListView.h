@@ -23,6 +23,7 @@ private:
 	void initMDValues();
 
 	ImageComponent mImage;
+	TexturePrefetcher mImagePrefetcher;
 
 	TextComponent mLblRating, mLblReleaseDate, mLblDeveloper, mLblPublisher, mLblGenre, mLblPlayers, mLblLastPlayed, mLblPlayCount;
 
@@ -40,7 +40,7 @@ void GridGameListView::populateList(const std::vector<FileData*>& files)
 	mGrid.clear();
 	for(auto it = files.begin(); it != files.end(); it++)
 	{
-		mGrid.add((*it)->getName(), (*it)->getThumbnailPath(), *it);
+		mGrid.add((*it)->getName(), (*it)->getThumbnailPath(), *it, false);
 	}
 }
 
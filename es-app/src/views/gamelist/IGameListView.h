@@ -2,6 +2,7 @@
 
 #include "FileData.h"
 #include "Renderer.h"
+#include <unordered_set>
 
 class Window;
 class GuiComponent;
@@ -21,6 +22,10 @@ public:
 	// NOTE: FILE_SORTED is only reported for the topmost FileData, where the sort started.
 	//       Since sorts are recursive, that FileData's children probably changed too.
 	virtual void onFileChanged(FileData* file, FileChangeType change) = 0;
+
+	// Called before files are deleted from the tree, folders with everything in them, so the cursor
+	// can be moved off them. onFileChanged() follows once they're gone.
+	virtual void onFilesRemoving(const std::unordered_set<FileData*>& removed) = 0;
 	
 	// Called whenever the theme changes.
 	virtual void onThemeChanged(const std::shared_ptr<ThemeData>& theme) = 0;
@@ -76,6 +76,53 @@ void ISimpleGameListView::onFileChanged(FileData* file, FileChangeType change)
 	}
 }
 
+void ISimpleGameListView::onFilesRemoving(const std::unordered_set<FileData*>& removed)
+{
+	FileData* cursor = getCursor();
+	if(cursor->isPlaceHolder())
+		return;
+
+	// the top most of the cursor and the folders it's in that's going
+	FileData* gone = NULL;
+	for(FileData* file = cursor; file && file != mRoot; file = file->getParent())
+	{
+		if(removed.find(file) != removed.end())
+			gone = file;
+	}
+
+	if(!gone)
+		return;
+
+	// the next one in that folder that's staying, then the one before, then the folder itself
+	FileData* parent = gone->getParent();
+	const std::vector<FileData*>& siblings = parent->getChildrenListToDisplay();
+	auto pos = std::find(siblings.begin(), siblings.end(), gone);
+	FileData* next = NULL;
+	for(auto it = pos; it != siblings.end() && !next; it++)
+	{
+		if(removed.find(*it) == removed.end())
+			next = *it;
+	}
+	for(auto it = pos; it != siblings.begin() && !next; )
+	{
+		it--;
+		if(removed.find(*it) == removed.end())
+			next = *it;
+	}
+
+	if(next)
+	{
+		setCursor(next);
+	}else if(parent != mRoot)
+	{
+		setCursor(parent);
+	}else{
+		// everything's going, show the placeholder
+		mCursorStack = std::stack<FileData*>();
+		populateList(std::vector<FileData*>());
+	}
+}
+
 bool ISimpleGameListView::input(InputConfig* config, Input input)
 {
 	if(input.value != 0)
@@ -130,7 +177,9 @@ bool ISimpleGameListView::input(InputConfig* config, Input input)
 		}else if (config->isMappedTo("x", input))
 		{
 			// go to random system game
-			setCursor(mRoot->getSystem()->getRandomGame());
+			FileData* randomGame = mRoot->getSystem()->getRandomGame();
+			if(randomGame)
+				setCursor(randomGame);
 			//ViewController::get()->goToRandomGame();
 			return true;
 		}else if (config->isMappedTo("y", input))
@@ -1,11 +1,227 @@
 #include <iostream>
+#include <fstream>
+#include <ctime>
+#include <functional>
+#include <algorithm>
 #include "HttpReq.h"
 #include "Log.h"
+#include "platform.h"
+#include "Settings.h"
 #include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+
+// how many idle curl handles are kept around for reuse
+#define HTTP_HANDLE_POOL_SIZE 8
+
+// longest the network thread sleeps in curl_multi_wait before checking for new or cancelled requests
+#if LIBCURL_VERSION_NUM >= 0x074400 // curl_multi_wakeup()
+#define HTTP_WAIT_TIMEOUT 1000
+#else
+#define HTTP_WAIT_TIMEOUT 50
+#endif
 
 CURLM* HttpReq::s_multi_handle = curl_multi_init();
 
-std::map<CURL*, HttpReq*> HttpReq::s_requests;
+std::mutex HttpReq::s_mutex;
+std::condition_variable HttpReq::s_work_available;
+std::thread* HttpReq::s_thread = NULL;
+bool HttpReq::s_exiting = false;
+std::list< std::shared_ptr<HttpReq::Transfer> > HttpReq::s_pending;
+std::map< std::string, std::weak_ptr<HttpReq::Transfer> > HttpReq::s_inflight;
+std::map< CURL*, std::shared_ptr<HttpReq::Transfer> > HttpReq::s_requests;
+std::vector<CURL*> HttpReq::s_handle_pool;
+HttpReq::CacheStats HttpReq::s_cache_stats = { 0, 0, 0, 0 };
+HttpReq::NetworkStats HttpReq::s_network_stats = { 0, 0 };
+std::atomic<unsigned long long> HttpReq::s_bytes_downloaded(0);
+
+struct HttpReq::Transfer
+{
+	Transfer(const std::string& u) : url(u), handle(NULL), requestHeaders(NULL), status(REQ_IN_PROGRESS), maxAge(0), noStore(false), users(1), cancelled(false) {}
+	~Transfer();
+
+	std::string url;
+	CURL* handle;
+	curl_slist* requestHeaders;
+
+	// set last by the network thread, content and errorMsg don't change once it's done
+	std::atomic<int> status;
+	std::string content;
+	std::string errorMsg;
+
+	// response headers that decide how it's cached
+	std::string etag;
+	std::string lastModified;
+	long maxAge;
+	bool noStore;
+
+	// HttpReqs waiting on this, once it drops to 0 the transfer is cancelled
+	unsigned int users;
+	bool cancelled;
+};
+
+HttpReq::Transfer::~Transfer()
+{
+	// the network thread has already given the handle back by the time the last reference goes
+	if(requestHeaders)
+		curl_slist_free_all(requestHeaders);
+}
+
+static std::string getHost(const std::string& url)
+{
+	size_t start = url.find("://");
+	start = (start == std::string::npos) ? 0 : start + 3;
+
+	size_t end = url.find_first_of(":/?", start);
+	return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// Each cached response is one file named after a hash of its URL. It starts with four lines
+// (URL, ETag, Last-Modified and the time it expires at) and the body follows. A file's modification
+// time is when it was last used, once the cache is over HttpCacheSize the oldest ones are deleted.
+// Only the network thread touches the cache.
+struct HttpCacheEntry
+{
+	std::string etag;
+	std::string lastModified;
+	time_t expires;
+};
+
+// what's left after a sweep, as a fraction of HttpCacheSize, so it isn't swept again straight away
+#define HTTP_CACHE_SWEEP_TARGET 0.8
+
+// bytes in the cache folder, -1 until the first write has listed it
+static long long sHttpCacheBytes = -1;
+
+static std::string getHttpCacheDir()
+{
+	return getHomePath() + "/.emulationstation/http_cache";
+}
+
+static std::string getHttpCachePath(const std::string& url)
+{
+	std::stringstream ss;
+	ss << getHttpCacheDir() << "/" << std::hex << std::hash<std::string>()(url);
+	return ss.str();
+}
+
+// marks the entry as recently used
+static void touchHttpCache(const std::string& url)
+{
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time(getHttpCachePath(url), time(NULL), ec);
+}
+
+// deletes the least recently used entries until the cache fits in HttpCacheSize again
+static void sweepHttpCache(bool force)
+{
+	const long long limit = (long long)Settings::getInstance()->getInt("HttpCacheSize") * 1024 * 1024;
+	if(!force && sHttpCacheBytes >= 0 && sHttpCacheBytes <= limit)
+		return;
+
+	struct CacheFile
+	{
+		boost::filesystem::path path;
+		time_t used;
+		uintmax_t size;
+	};
+
+	std::vector<CacheFile> files;
+	sHttpCacheBytes = 0;
+
+	boost::system::error_code ec;
+	for(boost::filesystem::directory_iterator end, dir(getHttpCacheDir(), ec); !ec && dir != end; dir.increment(ec))
+	{
+		boost::system::error_code fileError;
+		CacheFile file = { dir->path(), boost::filesystem::last_write_time(dir->path(), fileError), boost::filesystem::file_size(dir->path(), fileError) };
+		if(fileError)
+			continue;
+
+		files.push_back(file);
+		sHttpCacheBytes += file.size;
+	}
+
+	if(sHttpCacheBytes <= limit)
+		return;
+
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.used < b.used; });
+
+	const long long target = (long long)(limit * HTTP_CACHE_SWEEP_TARGET);
+	unsigned int removed = 0;
+	for(auto it = files.begin(); it != files.end() && sHttpCacheBytes > target; it++)
+	{
+		boost::system::error_code removeError;
+		if(boost::filesystem::remove(it->path, removeError))
+		{
+			sHttpCacheBytes -= it->size;
+			removed++;
+		}
+	}
+
+	LOG(LogInfo) << "HTTP cache was over " << (limit / 1024 / 1024) << "MB, removed " << removed << " least recently used entries";
+}
+
+// the body is only read if [body] isn't NULL
+static bool readHttpCache(const std::string& url, HttpCacheEntry& entry, std::string* body)
+{
+	std::ifstream file(getHttpCachePath(url), std::ios_base::in | std::ios_base::binary);
+	if(!file)
+		return false;
+
+	// the URL is checked in case of a hash collision
+	std::string cachedUrl, expires;
+	if(!std::getline(file, cachedUrl) || cachedUrl != url)
+		return false;
+
+	if(!std::getline(file, entry.etag) || !std::getline(file, entry.lastModified) || !std::getline(file, expires))
+		return false;
+
+	entry.expires = (time_t)atoll(expires.c_str());
+
+	if(body)
+	{
+		std::stringstream ss;
+		ss << file.rdbuf();
+		*body = ss.str();
+	}
+
+	return true;
+}
+
+static void writeHttpCache(const std::string& url, const HttpCacheEntry& entry, const std::string& body)
+{
+	const std::string path = getHttpCachePath(url);
+	const std::string tmpPath = path + ".tmp";
+
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(boost::filesystem::path(path).parent_path(), ec);
+
+	// written to the side and renamed so a reader never sees half an entry
+	{
+		std::ofstream file(tmpPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		file << url << "\n" << entry.etag << "\n" << entry.lastModified << "\n" << (long long)entry.expires << "\n";
+		file.write(body.data(), body.length());
+		if(!file)
+		{
+			LOG(LogWarning) << "Could not write HTTP cache entry for " << url;
+			return;
+		}
+	}
+
+	// what it replaces, if anything, is still counted until the next sweep lists the folder again
+	boost::filesystem::rename(tmpPath, path, ec);
+	if(ec)
+	{
+		LOG(LogWarning) << "Could not write HTTP cache entry for " << url << ": " << ec.message();
+		return;
+	}
+
+	if(sHttpCacheBytes < 0)
+		sweepHttpCache(true);
+	else
+		sHttpCacheBytes += body.length();
+
+	sweepHttpCache(false);
+}
 
 std::string HttpReq::urlEncode(const std::string &s)
 {
@@ -37,83 +253,158 @@ bool HttpReq::isUrl(const std::string& str)
 }
 
 HttpReq::HttpReq(const std::string& url)
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL)
 {
-	mHandle = curl_easy_init();
+	std::unique_lock<std::mutex> lock(s_mutex);
 
-	if(mHandle == NULL)
+	// somebody is already fetching this, share their transfer
+	auto inflight = s_inflight.find(url);
+	if(inflight != s_inflight.end())
 	{
-		mStatus = REQ_IO_ERROR;
-		onError("curl_easy_init failed");
-		return;
+		mTransfer = inflight->second.lock();
+		if(mTransfer && !mTransfer->cancelled)
+		{
+			mTransfer->users++;
+			s_cache_stats.shared++;
+			return;
+		}
 	}
 
-	//set the url
-	CURLcode err = curl_easy_setopt(mHandle, CURLOPT_URL, url.c_str());
-	if(err != CURLE_OK)
+	mTransfer = std::make_shared<Transfer>(url);
+	if(s_exiting)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		mTransfer->errorMsg = "Shutting down";
+		mTransfer->status = REQ_IO_ERROR;
 		return;
 	}
 
-	//tell curl how to write the data
-	err = curl_easy_setopt(mHandle, CURLOPT_WRITEFUNCTION, &HttpReq::write_content);
-	if(err != CURLE_OK)
-	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
-		return;
-	}
+	s_inflight[url] = mTransfer;
+	s_pending.push_back(mTransfer);
 
-	//give curl a pointer to this HttpReq so we know where to write the data *to* in our write function
-	err = curl_easy_setopt(mHandle, CURLOPT_WRITEDATA, this);
-	if(err != CURLE_OK)
+	if(s_thread == NULL)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
-		return;
+		// limits the connections open to any one server, the rest wait in curl's queue
+		curl_multi_setopt(s_multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS, (long)Settings::getInstance()->getInt("HttpMaxHostConnections"));
+		s_thread = new std::thread(&HttpReq::networkThread);
 	}
 
-	//add the handle to our multi
-	CURLMcode merr = curl_multi_add_handle(s_multi_handle, mHandle);
-	if(merr != CURLM_OK)
+	lock.unlock();
+	wakeNetworkThread();
+}
+
+HttpReq::~HttpReq()
+{
+	std::unique_lock<std::mutex> lock(s_mutex);
+
+	// nobody wants the result any more, let the network thread drop it
+	mTransfer->users--;
+	if(mTransfer->users == 0 && mTransfer->status == REQ_IN_PROGRESS)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_multi_strerror(merr));
-		return;
+		mTransfer->cancelled = true;
+		lock.unlock();
+		wakeNetworkThread();
 	}
+}
 
-	s_requests[mHandle] = this;
+void HttpReq::wakeNetworkThread()
+{
+	s_work_available.notify_one();
+#if LIBCURL_VERSION_NUM >= 0x074400
+	curl_multi_wakeup(s_multi_handle);
+#endif
 }
 
-HttpReq::~HttpReq()
+void HttpReq::shutdown()
 {
-	if(mHandle)
 	{
-		s_requests.erase(mHandle);
+		std::unique_lock<std::mutex> lock(s_mutex);
+		if(s_exiting)
+			return;
+		s_exiting = true;
+	}
 
-		CURLMcode merr = curl_multi_remove_handle(s_multi_handle, mHandle);
+	// the network thread has to be gone before the statics it waits on are destroyed
+	if(s_thread)
+	{
+		s_work_available.notify_all();
+#if LIBCURL_VERSION_NUM >= 0x074400
+		curl_multi_wakeup(s_multi_handle);
+#endif
+		s_thread->join();
+		delete s_thread;
+		s_thread = NULL;
+	}
 
-		if(merr != CURLM_OK)
-			LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
+	// nothing else touches these now
+	for(auto it = s_requests.begin(); it != s_requests.end(); it++)
+	{
+		curl_multi_remove_handle(s_multi_handle, it->first);
+		curl_easy_cleanup(it->first);
+		it->second->handle = NULL;
+		it->second->errorMsg = "Shutting down";
+		it->second->status = REQ_IO_ERROR;
+	}
+	s_requests.clear();
 
-		curl_easy_cleanup(mHandle);
+	for(auto it = s_pending.begin(); it != s_pending.end(); it++)
+	{
+		(*it)->errorMsg = "Shutting down";
+		(*it)->status = REQ_IO_ERROR;
 	}
+	s_pending.clear();
+	s_inflight.clear();
+
+	for(auto it = s_handle_pool.begin(); it != s_handle_pool.end(); it++)
+		curl_easy_cleanup(*it);
+	s_handle_pool.clear();
+
+	curl_multi_cleanup(s_multi_handle);
+	s_multi_handle = NULL;
 }
 
-HttpReq::Status HttpReq::status()
+void HttpReq::networkThread()
 {
-	if(mStatus == REQ_IN_PROGRESS)
+	std::unique_lock<std::mutex> lock(s_mutex);
+	while(!s_exiting)
 	{
+		// drop transfers nobody is waiting on any more
+		for(auto it = s_requests.begin(); it != s_requests.end(); )
+		{
+			if(!it->second->cancelled)
+			{
+				it++;
+				continue;
+			}
+
+			auto inflight = s_inflight.find(it->second->url);
+			if(inflight != s_inflight.end() && inflight->second.lock() == it->second)
+				s_inflight.erase(inflight);
+
+			curl_multi_remove_handle(s_multi_handle, it->first);
+			releaseHandle(it->first);
+			it->second->handle = NULL;
+			it = s_requests.erase(it);
+		}
+
+		s_network_stats.activeTransfers = s_requests.size();
+
+		if(s_requests.empty() && s_pending.empty())
+		{
+			s_work_available.wait(lock, [] { return !s_pending.empty() || s_exiting; });
+			continue;
+		}
+
+		std::list< std::shared_ptr<Transfer> > pending;
+		pending.swap(s_pending);
+		lock.unlock();
+
+		// the cache lookup reads from disk, so new requests are set up here rather than by the constructor
+		for(auto it = pending.begin(); it != pending.end(); it++)
+			startTransfer(*it);
+
 		int handle_count;
 		CURLMcode merr = curl_multi_perform(s_multi_handle, &handle_count);
 		if(merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
-		{
-			mStatus = REQ_IO_ERROR;
-			onError(curl_multi_strerror(merr));
-			return mStatus;
-		}
+			LOG(LogError) << "curl_multi_perform failed: " << curl_multi_strerror(merr);
 
 		int msgs_left;
 		CURLMsg* msg;
@@ -121,51 +412,313 @@ HttpReq::Status HttpReq::status()
 		{
 			if(msg->msg == CURLMSG_DONE)
 			{
-				HttpReq* req = s_requests[msg->easy_handle];
-				
-				if(req == NULL)
+				auto it = s_requests.find(msg->easy_handle);
+				if(it == s_requests.end())
 				{
 					LOG(LogError) << "Cannot find easy handle!";
 					continue;
 				}
 
-				if(msg->data.result == CURLE_OK)
-				{
-					req->mStatus = REQ_SUCCESS;
-				}else{
-					req->mStatus = REQ_IO_ERROR;
-					req->onError(curl_easy_strerror(msg->data.result));
-				}
+				std::shared_ptr<Transfer> transfer = it->second;
+				s_requests.erase(it);
+				finishTransfer(transfer, msg->data.result);
 			}
 		}
+
+		if(!s_requests.empty())
+			curl_multi_wait(s_multi_handle, NULL, 0, HTTP_WAIT_TIMEOUT, NULL);
+
+		lock.lock();
+	}
+}
+
+void HttpReq::startTransfer(const std::shared_ptr<Transfer>& transfer)
+{
+	const std::string& url = transfer->url;
+
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		if(transfer->cancelled)
+		{
+			auto inflight = s_inflight.find(url);
+			if(inflight != s_inflight.end() && inflight->second.lock() == transfer)
+				s_inflight.erase(inflight);
+			return;
+		}
+	}
+
+	HttpCacheEntry entry;
+	bool cached = readHttpCache(url, entry, NULL);
+	if(cached && entry.expires > time(NULL) && readHttpCache(url, entry, &transfer->content))
+	{
+		// still fresh, no need to ask the server
+		touchHttpCache(url);
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_cache_stats.hits++;
+		}
+		completeTransfer(transfer, REQ_SUCCESS);
+		return;
 	}
 
-	return mStatus;
+	CURL* handle = acquireHandle();
+	if(handle == NULL)
+	{
+		completeTransfer(transfer, REQ_IO_ERROR, "curl_easy_init failed");
+		return;
+	}
+
+	transfer->handle = handle;
+
+	//set the url
+	CURLcode err = curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+	if(err != CURLE_OK)
+	{
+		completeTransfer(transfer, REQ_IO_ERROR, curl_easy_strerror(err));
+		return;
+	}
+
+	//tell curl how to write the data
+	err = curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &HttpReq::write_content);
+	if(err != CURLE_OK)
+	{
+		completeTransfer(transfer, REQ_IO_ERROR, curl_easy_strerror(err));
+		return;
+	}
+
+	//give curl a pointer to the transfer so we know where to write the data *to* in our write function
+	err = curl_easy_setopt(handle, CURLOPT_WRITEDATA, transfer.get());
+	if(err != CURLE_OK)
+	{
+		completeTransfer(transfer, REQ_IO_ERROR, curl_easy_strerror(err));
+		return;
+	}
+
+	//the response headers say how long it can be cached for
+	err = curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, &HttpReq::write_header);
+	if(err == CURLE_OK)
+		err = curl_easy_setopt(handle, CURLOPT_HEADERDATA, transfer.get());
+	if(err != CURLE_OK)
+	{
+		completeTransfer(transfer, REQ_IO_ERROR, curl_easy_strerror(err));
+		return;
+	}
+
+	//keep idle connections open for the next request to the same host
+	curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+
+	//if we have an older copy, only download it again if it changed
+	if(cached)
+	{
+		if(!entry.etag.empty())
+			transfer->requestHeaders = curl_slist_append(transfer->requestHeaders, ("If-None-Match: " + entry.etag).c_str());
+		if(!entry.lastModified.empty())
+			transfer->requestHeaders = curl_slist_append(transfer->requestHeaders, ("If-Modified-Since: " + entry.lastModified).c_str());
+
+		if(transfer->requestHeaders)
+			curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer->requestHeaders);
+	}
+
+	//add the handle to our multi
+	CURLMcode merr = curl_multi_add_handle(s_multi_handle, handle);
+	if(merr != CURLM_OK)
+	{
+		completeTransfer(transfer, REQ_IO_ERROR, curl_multi_strerror(merr));
+		return;
+	}
+
+	s_requests[handle] = transfer;
 }
 
-std::string HttpReq::getContent() const
+CURL* HttpReq::acquireHandle()
+{
+	if(s_handle_pool.empty())
+		return curl_easy_init();
+
+	CURL* handle = s_handle_pool.back();
+	s_handle_pool.pop_back();
+	return handle;
+}
+
+void HttpReq::releaseHandle(CURL* handle)
+{
+	// reset keeps the handle's connections and DNS cache
+	if(s_handle_pool.size() < HTTP_HANDLE_POOL_SIZE)
+	{
+		curl_easy_reset(handle);
+		s_handle_pool.push_back(handle);
+	}else{
+		curl_easy_cleanup(handle);
+	}
+}
+
+HttpReq::Status HttpReq::status()
 {
-	assert(mStatus == REQ_SUCCESS);
-	return mContent.str();
+	return (Status)mTransfer->status.load();
 }
 
-void HttpReq::onError(const char* msg)
+void HttpReq::finishTransfer(const std::shared_ptr<Transfer>& transfer, CURLcode result)
 {
-	mErrorMsg = msg;
+	long code = 0;
+	curl_easy_getinfo(transfer->handle, CURLINFO_RESPONSE_CODE, &code);
+
+	// done with the handle, give it back so the next request can reuse its connection
+	curl_multi_remove_handle(s_multi_handle, transfer->handle);
+	releaseHandle(transfer->handle);
+	transfer->handle = NULL;
+
+	if(result != CURLE_OK)
+	{
+		completeTransfer(transfer, REQ_IO_ERROR, curl_easy_strerror(result));
+		return;
+	}
+
+	HttpCacheEntry entry;
+	entry.etag = transfer->etag;
+	entry.lastModified = transfer->lastModified;
+	entry.expires = transfer->maxAge > 0 ? time(NULL) + transfer->maxAge : 0;
+
+	if(code == 304)
+	{
+		HttpCacheEntry cached;
+		if(!readHttpCache(transfer->url, cached, &transfer->content))
+		{
+			completeTransfer(transfer, REQ_INVALID_RESPONSE, "Server said not modified but there's no cached copy");
+			return;
+		}
+
+		// a 304 may leave out the validators, keep the old ones
+		if(entry.etag.empty())
+			entry.etag = cached.etag;
+		if(entry.lastModified.empty())
+			entry.lastModified = cached.lastModified;
+		if(entry.expires != 0)
+			writeHttpCache(transfer->url, entry, transfer->content);
+		else
+			touchHttpCache(transfer->url);
+
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_cache_stats.hits++;
+			s_cache_stats.revalidated++;
+		}
+		completeTransfer(transfer, REQ_SUCCESS);
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_cache_stats.misses++;
+		s_network_stats.bytesPerHost[getHost(transfer->url)] += transfer->content.size();
+	}
+
+	// code is 0 for non-HTTP URLs
+	if(code != 0 && (code < 200 || code >= 300))
+	{
+		std::stringstream ss;
+		ss << "HTTP status " << code;
+		completeTransfer(transfer, REQ_BAD_STATUS_CODE, ss.str());
+		return;
+	}
+
+	// without a validator or max-age it would just be downloaded again anyway
+	if(code != 0 && !transfer->noStore && (!entry.etag.empty() || !entry.lastModified.empty() || entry.expires != 0))
+		writeHttpCache(transfer->url, entry, transfer->content);
+
+	completeTransfer(transfer, REQ_SUCCESS);
+}
+
+void HttpReq::completeTransfer(const std::shared_ptr<Transfer>& transfer, Status status, const std::string& errorMsg)
+{
+	transfer->errorMsg = errorMsg;
+
+	std::unique_lock<std::mutex> lock(s_mutex);
+
+	// finished transfers aren't shared, a new request for the URL gets a fresh copy
+	auto it = s_inflight.find(transfer->url);
+	if(it != s_inflight.end() && it->second.lock() == transfer)
+		s_inflight.erase(it);
+
+	transfer->status = status;
+}
+
+std::string HttpReq::getContent() const
+{
+	assert(mTransfer->status == REQ_SUCCESS);
+	return mTransfer->content;
 }
 
 std::string HttpReq::getErrorMsg()
 {
-	return mErrorMsg;
+	return mTransfer->errorMsg;
+}
+
+HttpReq::CacheStats HttpReq::getCacheStats()
+{
+	std::unique_lock<std::mutex> lock(s_mutex);
+	return s_cache_stats;
+}
+
+HttpReq::NetworkStats HttpReq::getNetworkStats()
+{
+	std::unique_lock<std::mutex> lock(s_mutex);
+	NetworkStats stats = s_network_stats;
+	stats.bytesDownloaded = s_bytes_downloaded;
+	return stats;
 }
 
 //used as a curl callback
 //size = size of an element, nmemb = number of elements
 //return value is number of elements successfully read
-size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_ptr)
+size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* transfer_ptr)
+{
+	std::string& content = ((Transfer*)transfer_ptr)->content;
+	content.append((char*)buff, size * nmemb);
+	s_bytes_downloaded += size * nmemb;
+
+	return nmemb;
+}
+
+//used as a curl callback, called once per header line
+size_t HttpReq::write_header(char* buff, size_t size, size_t nmemb, void* transfer_ptr)
 {
-	std::stringstream& ss = ((HttpReq*)req_ptr)->mContent;
-	ss.write((char*)buff, size * nmemb);
+	Transfer* transfer = (Transfer*)transfer_ptr;
+	std::string line(buff, size * nmemb);
+	boost::algorithm::trim_right(line);
+
+	// a new status line (e.g. after "100 Continue") starts a new set of headers
+	if(line.compare(0, 5, "HTTP/") == 0)
+	{
+		transfer->etag.clear();
+		transfer->lastModified.clear();
+		transfer->maxAge = 0;
+		transfer->noStore = false;
+		return nmemb;
+	}
+
+	size_t colon = line.find(':');
+	if(colon == std::string::npos)
+		return nmemb;
+
+	const std::string name = boost::algorithm::to_lower_copy(line.substr(0, colon));
+	const std::string value = boost::algorithm::trim_copy(line.substr(colon + 1));
+
+	if(name == "etag")
+	{
+		transfer->etag = value;
+	}else if(name == "last-modified")
+	{
+		transfer->lastModified = value;
+	}else if(name == "cache-control")
+	{
+		const std::string lower = boost::algorithm::to_lower_copy(value);
+		if(lower.find("no-store") != std::string::npos)
+			transfer->noStore = true;
+
+		size_t maxAge = lower.find("max-age=");
+		if(maxAge != std::string::npos && lower.find("no-cache") == std::string::npos)
+			transfer->maxAge = atol(lower.c_str() + maxAge + 8);
+	}
 
 	return nmemb;
 }
@@ -3,6 +3,13 @@
 #include <curl/curl.h>
 #include <sstream>
 #include <map>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 
 /* Usage:
  * HttpReq myRequest("www.google.com", "/index.html");
@@ -19,6 +26,14 @@
  *
  * std::string content = myRequest.getContent();
  * //process contents...
+ *
+ * Responses are cached on disk in ~/.emulationstation/http_cache and revalidated with the server
+ * (ETag/Last-Modified) before being used again, or used straight away while Cache-Control max-age allows.
+ * The cache is kept under HttpCacheSize MB by deleting the least recently used responses.
+ * Requests for a URL that is already being fetched share the one transfer.
+ *
+ * Transfers run on a network thread, so they keep going between frames and while the power saver
+ * has the main loop asleep. status() only reads the result, which is final once it isn't REQ_IN_PROGRESS.
 */
 
 class HttpReq
@@ -38,7 +53,7 @@ public:
 		REQ_INVALID_RESPONSE	//the HTTP response was invalid
 	};
 
-	Status status(); //process any received data and return the status afterwards
+	Status status(); //returns the status, the transfer itself runs on the network thread
 
 	std::string getErrorMsg();
 
@@ -47,22 +62,72 @@ public:
 	static std::string urlEncode(const std::string &s);
 	static bool isUrl(const std::string& s);
 
+	struct CacheStats
+	{
+		unsigned int hits;			// served from the cache, including revalidated entries
+		unsigned int revalidated;	// hits that needed a round trip to the server (304 Not Modified)
+		unsigned int misses;		// downloaded
+		unsigned int shared;		// requests that joined a transfer already in flight
+	};
+
+	static CacheStats getCacheStats();
+
+	struct NetworkStats
+	{
+		unsigned int activeTransfers;
+		unsigned long long bytesDownloaded;	// response bodies, updated as they arrive
+		std::map<std::string, unsigned long long> bytesPerHost; // counted when a transfer finishes
+	};
+
+	static NetworkStats getNetworkStats();
+
+	// Stops the network thread and frees curl's handles, call before exiting. Transfers still
+	// in progress fail, and requests made afterwards fail straight away.
+	static void shutdown();
+
 private:
-	static size_t write_content(void* buff, size_t size, size_t nmemb, void* req_ptr);
+	// one fetch of a URL, shared by every HttpReq for it
+	struct Transfer;
+
+	static size_t write_content(void* buff, size_t size, size_t nmemb, void* transfer_ptr);
+	static size_t write_header(char* buff, size_t size, size_t nmemb, void* transfer_ptr);
 	//static int update_progress(void* req_ptr, double dlTotal, double dlNow, double ulTotal, double ulNow);
 
+	// everything below here, apart from wakeNetworkThread(), runs on the network thread
+	static void networkThread();
+	static void wakeNetworkThread();
+
+	static void startTransfer(const std::shared_ptr<Transfer>& transfer);
+	static void finishTransfer(const std::shared_ptr<Transfer>& transfer, CURLcode result);
+	static void completeTransfer(const std::shared_ptr<Transfer>& transfer, Status status, const std::string& errorMsg = "");
+
+	static CURL* acquireHandle();
+	static void releaseHandle(CURL* handle);
+
+	// guards the transfer queue, s_inflight, the stats and each transfer's user count
+	static std::mutex s_mutex;
+	static std::condition_variable s_work_available;
+	static std::thread* s_thread;
+	static bool s_exiting; // set by shutdown(), the network thread finishes up and returns
+
+	// created by HttpReq constructors, waiting for the network thread to pick them up
+	static std::list< std::shared_ptr<Transfer> > s_pending;
+
+	// transfers that haven't finished yet, by URL
+	static std::map< std::string, std::weak_ptr<Transfer> > s_inflight;
+
 	//god dammit libcurl why can't you have some way to check the status of an individual handle
 	//why do I have to handle ALL messages at once
-	static std::map<CURL*, HttpReq*> s_requests;
+	static std::map< CURL*, std::shared_ptr<Transfer> > s_requests;
 
-	static CURLM* s_multi_handle;
+	// finished easy handles are kept around so their connections get reused
+	static std::vector<CURL*> s_handle_pool;
 
-	void onError(const char* msg);
+	static CacheStats s_cache_stats;
+	static NetworkStats s_network_stats;
+	static std::atomic<unsigned long long> s_bytes_downloaded;
 
-	CURL* mHandle;
-
-	Status mStatus;
+	static CURLM* s_multi_handle;
 
-	std::stringstream mContent;
-	std::string mErrorMsg;
+	std::shared_ptr<Transfer> mTransfer;
 };
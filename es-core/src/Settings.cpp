@@ -17,7 +17,8 @@ std::vector<const char*> settings_dont_save = boost::assign::list_of
 	("Windowed")
 	("VSync")
 	("HideConsole")
-	("IgnoreGamelist");
+	("IgnoreGamelist")
+	("ScraperUrl");
 
 Settings::Settings()
 {
@@ -62,6 +63,8 @@ void Settings::setDefaults()
 	mBoolMap["QuickSystemSelect"] = true;
 	mBoolMap["MoveCarousel"] = true;
 	mBoolMap["SaveGamelistsOnExit"] = true;
+	mBoolMap["WatchGameFolders"] = true; // pick up games that are added or removed while we're running
+	mBoolMap["FontDistanceField"] = false; // every size of a font shares one set of glyph textures
 
 	mBoolMap["Debug"] = false;
 	mBoolMap["DebugGrid"] = false;
@@ -70,11 +73,17 @@ void Settings::setDefaults()
 	mIntMap["ScreenSaverTime"] = 5*60*1000; // 5 minutes
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
+	mIntMap["ScraperThumbnailWidth"] = 0; // both 0 means no thumbnail is written
+	mIntMap["ScraperThumbnailHeight"] = 0;
+	mIntMap["ScraperConcurrency"] = 4; // games searched for / downloaded at once by the multi scraper
+	mIntMap["HttpMaxHostConnections"] = 4;
+	mIntMap["HttpCacheSize"] = 256; // MB, the least recently used responses are dropped past this
 
 	mStringMap["TransitionStyle"] = "fade";
 	mStringMap["ThemeSet"] = "";
 	mStringMap["ScreenSaverBehavior"] = "dim";
 	mStringMap["Scraper"] = "TheGamesDB";
+	mStringMap["ScraperUrl"] = "thegamesdb.net/api/"; // can be pointed at a local server for testing
 	mStringMap["GamelistViewStyle"] = "automatic";
 
 	mBoolMap["ScreenSaverControls"] = true;
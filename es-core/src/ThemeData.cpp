@@ -171,14 +171,19 @@ std::string resolvePath(const char* in, const fs::path& relative)
 	return path.generic_string();
 }
 
-std::map<std::string, std::string> mVariables;
-
-std::string &format_variables(const boost::xpressive::smatch &what)
+// Replaces ${name} with the variable's value. The variables belong to the theme being
+// parsed so that several themes can be loaded at once
+struct VariableFormatter
 {
-	return mVariables[what[1].str()];
-}
+	std::map<std::string, std::string>& variables;
+
+	std::string& operator()(const boost::xpressive::smatch& what) const
+	{
+		return variables[what[1].str()];
+	}
+};
 
-std::string resolvePlaceholders(const char* in)
+std::string resolvePlaceholders(const char* in, std::map<std::string, std::string>& variables)
 {
 	if(!in || in[0] == '\0')
 		return std::string(in);
@@ -188,7 +193,8 @@ std::string resolvePlaceholders(const char* in)
 	using namespace boost::xpressive;
 	sregex rex = "${" >> (s1 = +('.' | _w)) >> '}';
     
-	std::string output = regex_replace(inStr, rex, format_variables);
+	VariableFormatter formatter = { variables };
+	std::string output = regex_replace(inStr, rex, formatter);
 
 	return output;
 }
@@ -389,7 +395,7 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 		if(typeIt == typeMap.end())
 			throw error << "Unknown property type \"" << node.name() << "\" (for element of type " << root.name() << ").";
 
-		std::string str = resolvePlaceholders(node.text().as_string());
+		std::string str = resolvePlaceholders(node.text().as_string(), mVariables);
 
 		switch(typeIt->second)
 		{
@@ -0,0 +1,85 @@
+#include "ThreadPool.h"
+
+ThreadPool* ThreadPool::sInstance = NULL;
+
+ThreadPool::ThreadPool(unsigned int threadCount) : mBusy(0), mExit(false)
+{
+	if(threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if(threadCount == 0)
+		threadCount = 2;
+
+	for(unsigned int i = 0; i < threadCount; i++)
+		mThreads.push_back(std::thread(&ThreadPool::threadProc, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+	mWorkAvailable.notify_all();
+
+	for(auto it = mThreads.begin(); it != mThreads.end(); it++)
+		it->join();
+}
+
+ThreadPool* ThreadPool::getInstance()
+{
+	if(!sInstance)
+		sInstance = new ThreadPool();
+
+	return sInstance;
+}
+
+void ThreadPool::shutdown()
+{
+	delete sInstance;
+	sInstance = NULL;
+}
+
+std::future<void> ThreadPool::queueWorkItem(std::function<void()> work)
+{
+	std::packaged_task<void()> task(work);
+	std::future<void> result = task.get_future();
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mQueue.push_back(std::move(task));
+	}
+	mWorkAvailable.notify_one();
+
+	return result;
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWorkDone.wait(lock, [this] { return mQueue.empty() && mBusy == 0; });
+}
+
+void ThreadPool::threadProc()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while(true)
+	{
+		mWorkAvailable.wait(lock, [this] { return mExit || !mQueue.empty(); });
+
+		// Drain the queue before exiting so nobody is left waiting on a future
+		if(mQueue.empty())
+			break;
+
+		std::packaged_task<void()> task = std::move(mQueue.front());
+		mQueue.pop_front();
+		mBusy++;
+
+		lock.unlock();
+		task();
+		lock.lock();
+
+		mBusy--;
+		if(mQueue.empty() && mBusy == 0)
+			mWorkDone.notify_all();
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+// A fixed set of worker threads that run queued work items in the order they were queued.
+//
+// Used for CPU bound jobs that can be spread over all cores, like parsing every system's
+// theme or decoding the carousel logos. Nothing run here may touch OpenGL; GL uploads
+// stay on the main thread.
+class ThreadPool
+{
+public:
+	// threadCount 0 means one thread per core
+	ThreadPool(unsigned int threadCount = 0);
+	// Finishes everything that's still queued before returning
+	~ThreadPool();
+
+	// Shared pool for anything that doesn't need its own
+	static ThreadPool* getInstance();
+	// Runs what's left in the shared pool and stops its threads, before main() returns so
+	// nothing is still running while statics are destroyed
+	static void shutdown();
+
+	// Queue work to run on one of the worker threads. The returned future is ready once it has run
+	std::future<void> queueWorkItem(std::function<void()> work);
+
+	// Block until every queued work item has run
+	void wait();
+
+	inline unsigned int getThreadCount() const { return (unsigned int)mThreads.size(); }
+
+private:
+	void threadProc();
+
+	static ThreadPool* sInstance;
+
+	std::vector<std::thread> mThreads;
+	std::list< std::packaged_task<void()> > mQueue;
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+	unsigned int mBusy;
+	bool mExit;
+};
@@ -8,8 +8,9 @@
 #include <iomanip>
 #include "components/HelpComponent.h"
 #include "components/ImageComponent.h"
+#include "HttpReq.h"
 
-Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
+Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10), mLastNetBytes(0),
 	mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL)
 {
 	mHelp = new HelpComponent(this);
@@ -205,6 +206,28 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				  " Tex Max: " << textureTotalUsageMb;
+
+			// texture loader, queued/loaded/cancelled/promoted for each priority
+			TextureLoaderStats loader = TextureResource::getLoaderStats();
+			const char* priorityNames[TEXTURE_PRIORITY_COUNT] = { "Visible", "Near", "Spec" };
+			ss << "\nTex Queue:";
+			for(int i = 0; i < TEXTURE_PRIORITY_COUNT; i++)
+			{
+				ss << " " << priorityNames[i] << " " << loader.queued[i] << "/" << loader.loaded[i] << "/" <<
+					  loader.cancelled[i] << "/" << loader.promoted[i];
+			}
+
+			// network, transfers running and download rate since the last update
+			HttpReq::NetworkStats net = HttpReq::getNetworkStats();
+			ss << "\nNet: " << net.activeTransfers << " active, " << std::setprecision(1) <<
+				  ((net.bytesDownloaded - mLastNetBytes) / (float)mFrameTimeElapsed) << "KB/s, " << (net.bytesDownloaded / 1000) << "KB total";
+			mLastNetBytes = net.bytesDownloaded;
+
+			// text layouts reused by buildTextCache
+			Font::LayoutCacheStats text = Font::getLayoutCacheStats();
+			const unsigned int lookups = text.hits + text.misses;
+			ss << "\nText Cache: " << std::setprecision(1) << (lookups ? 100.0f * text.hits / lookups : 0.0f) << "% hits, " <<
+				  text.entries << " layouts, " << (text.bytes / 1000) << "KB";
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
 		}
 
@@ -228,6 +251,9 @@ void Window::render()
 
 	mRenderedHelpPrompts = false;
 
+	// glyphs rasterized in the background since the last frame
+	Font::uploadPendingGlyphs();
+
 	// draw only bottom and top of GuiStack (if they are different)
 	if(mGuiStack.size())
 	{
@@ -87,6 +87,7 @@ private:
 	int mFrameTimeElapsed;
 	int mFrameCountElapsed;
 	int mAverageDeltaTime;
+	unsigned long long mLastNetBytes; // for the download rate in the framerate overlay
 
 	std::unique_ptr<TextCache> mFrameDataText;
 
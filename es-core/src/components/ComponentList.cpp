@@ -33,6 +33,12 @@ void ComponentList::addRow(const ComponentListRow& row, bool setCursorHere)
 	}
 }
 
+void ComponentList::clear(bool clearall)
+{
+	clearChildren();
+	IList<ComponentListRow, void*>::clear(clearall);
+}
+
 void ComponentList::onSizeChanged()
 {
 	for(auto it = mEntries.begin(); it != mEntries.end(); it++)
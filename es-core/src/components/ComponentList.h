@@ -49,6 +49,7 @@ public:
 	ComponentList(Window* window);
 
 	void addRow(const ComponentListRow& row, bool setCursorHere = false);
+	void clear(bool clearall = false) override; // removes every row
 
 	void textInput(const char* text) override;
 	bool input(InputConfig* config, Input input) override;
@@ -297,6 +297,8 @@ void GridTileComponent::setTheme(const std::shared_ptr<ThemeData>& theme) {
 
 void GridTileComponent::hide() {
 	bShow = false;
+	// Nothing to show, so don't keep the loader busy on our behalf
+	mImage->cancelLoad();
 }
 
 void GridTileComponent::show() {
@@ -7,6 +7,7 @@
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
 #include "resources/Font.h"
+#include "resources/TexturePrefetcher.h"
 #include "Renderer.h"
 
 enum CursorState
@@ -49,6 +50,9 @@ const ScrollTier SLOW_SCROLL_TIERS[] = {
 };
 const ScrollTierList LIST_SCROLL_STYLE_SLOW = { 2, SLOW_SCROLL_TIERS };
 
+// how far ahead (in ms) getPredictedCursor() looks when the list is scrolling
+const int CURSOR_PREDICTION_TIME = 500;
+
 template <typename EntryData, typename UserData>
 class IList : public GuiComponent
 {
@@ -81,9 +85,6 @@ protected:
 
 	std::vector<Entry> mEntries;
 
-	int mTotalLoadedTextures = 0;
-	std::list<int>mLoadedTextureList;
-
 	std::shared_ptr<TextureResource> mMissingBoxartTexture;
 	
 public:
@@ -167,36 +168,51 @@ public:
 		return mCursor;
 	}
 
-	// Will load an object's texture from it's stored texture string.  
-	// Can be safely called many times without reloading texture.
-	void loadTexture(int index) {
-		if (!mEntries[index].isTextureLoaded) {
-			std::string imagePath = mEntries[index].strdata;
-			if (mEntries[index].object->getType() == 2) TextureResource::get(":/folder.png");
-			else {
-				mEntries[index].data.texture = ResourceManager::getInstance()->fileExists(imagePath) ?
-					TextureResource::get(imagePath) : mMissingBoxartTexture;
-			}
-			mEntries[index].isTextureLoaded = true;
-			mLoadedTextureList.push_back(index);
+	// Where the cursor is expected to be once the current scroll has run for
+	// another CURSOR_PREDICTION_TIME ms. Returns the cursor itself when not scrolling.
+	int getPredictedCursor() const
+	{
+		if(mScrollVelocity == 0 || size() < 2)
+			return mCursor;
+
+		const int delay = mTierList.tiers[mScrollTier].scrollDelay;
+		int steps = (CURSOR_PREDICTION_TIME + mScrollCursorAccumulator) / (delay > 0 ? delay : 1);
+		if(steps < 1)
+			steps = 1;
 
-			// Increment LoadedTexture Count
-			mTotalLoadedTextures++;
+		int cursor = mCursor + mScrollVelocity * steps;
+		const int absAmt = mScrollVelocity < 0 ? -mScrollVelocity : mScrollVelocity;
+
+		// same end-of-list rules as scroll()
+		if((mLoopType == LIST_PAUSE_AT_END && (mScrollTier > 0 || absAmt > 1)) ||
+			mLoopType == LIST_NEVER_LOOP)
+		{
+			if(cursor < 0)
+				cursor = 0;
+			else if(cursor >= size())
+				cursor = size() - 1;
+		}else{
+			cursor %= size();
+			if(cursor < 0)
+				cursor += size();
 		}
+
+		return cursor;
 	}
 
-	// Sets this image back to default texture.
-	void clearImage(int index) {
-		if (mEntries[index].isTextureLoaded) {
-			if (mEntries[index].object->getType() == 2) return;
-			else mEntries[index].data.texture = TextureResource::get(":/frame.png");
-			mEntries[index].isTextureLoaded = false;
+	// True while scrolling in the last (fastest) scroll tier
+	bool isFastestScrollTier() const
+	{
+		return (mScrollVelocity != 0 && mScrollTier >= mTierList.count - 1);
+	}
 
-			// Subtract Loaded Texture Count
-			mTotalLoadedTextures--;
-		}
+	// Queue the textures around where the cursor will land. Nothing is loaded in the fastest
+	// scroll tier - the cursor passes through entries far quicker than they can be decoded.
+	void prefetchTextures(TexturePrefetcher& prefetcher, const std::function<std::string(const UserData&)>& pathForObject)
+	{
+		prefetchEntries(prefetcher, [&](const Entry& entry) { return pathForObject(entry.object); });
 	}
-	
+
 	// entry management
 	void add(const Entry& e)
 	{
@@ -225,6 +241,18 @@ public:
 	inline int size() const { return mEntries.size(); }
 
 protected:
+	void prefetchEntries(TexturePrefetcher& prefetcher, const std::function<std::string(const Entry&)>& pathForEntry)
+	{
+		if(isFastestScrollTier())
+		{
+			prefetcher.cancel();
+			return;
+		}
+
+		prefetcher.prefetch(getPredictedCursor(), size(), mLoopType == LIST_ALWAYS_LOOP,
+			[&](int index) { return pathForEntry(mEntries.at(index)); });
+	}
+
 	void remove(typename std::vector<Entry>::iterator& it)
 	{
 		if(mCursor > 0 && it - mEntries.begin() <= mCursor)
@@ -101,6 +101,8 @@ void ImageComponent::onSizeChanged()
 
 void ImageComponent::setImage(std::string path, bool tile)
 {
+	cancelLoad();
+
 	if(path.empty() || !ResourceManager::getInstance()->fileExists(path))
 		mTexture.reset();
 	else
@@ -111,6 +113,7 @@ void ImageComponent::setImage(std::string path, bool tile)
 
 void ImageComponent::setImage(const char* path, size_t length, bool tile)
 {
+	cancelLoad();
 	mTexture.reset();
 
 	mTexture = TextureResource::get("", tile);
@@ -121,6 +124,9 @@ void ImageComponent::setImage(const char* path, size_t length, bool tile)
 
 void ImageComponent::setImage(const std::shared_ptr<TextureResource>& texture)
 {
+	if(texture != mTexture)
+		cancelLoad();
+
 	mTexture = texture;
 	resize();
 }
@@ -247,7 +253,14 @@ void ImageComponent::render(const Eigen::Affine3f& parentTrans)
 			// The bind() function returns false if the texture is not currently loaded. A blank
 			// texture is bound in this case but we want to handle a fade so it doesn't just 'jump' in
 			// when it finally loads
-			fadeIn(mTexture->bind());
+			bool bound = mTexture->bind();
+			// bind() queues unloaded textures; keep a handle on the request so it can be
+			// withdrawn if we move on to another image before it's done
+			if(bound)
+				mLoadHandle.reset();
+			else if(!mLoadHandle)
+				mLoadHandle = mTexture->requestLoad(TEXTURE_PRIORITY_VISIBLE);
+			fadeIn(bound);
 
 			glEnable(GL_TEXTURE_2D);
 			glEnable(GL_BLEND);
@@ -278,6 +291,15 @@ void ImageComponent::render(const Eigen::Affine3f& parentTrans)
 	GuiComponent::renderChildren(trans);
 }
 
+void ImageComponent::cancelLoad()
+{
+	if(mLoadHandle)
+	{
+		mLoadHandle->cancel();
+		mLoadHandle.reset();
+	}
+}
+
 void ImageComponent::fadeIn(bool textureLoaded)
 {
 	if (!mForceLoad)
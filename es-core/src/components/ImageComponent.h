@@ -56,6 +56,9 @@ public:
 
 	bool hasImage();
 
+	// Withdraw any pending request to load the current texture (e.g. when it's hidden)
+	void cancelLoad();
+
 	void render(const Eigen::Affine3f& parentTrans) override;
 
 	virtual void applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties) override;
@@ -86,6 +89,7 @@ private:
 	unsigned int mColorShift;
 
 	std::shared_ptr<TextureResource> mTexture;
+	std::shared_ptr<TextureLoadHandle> mLoadHandle;
 	unsigned char			 mFadeOpacity;
 	bool					 mFading;
 	bool				     mForceLoad;
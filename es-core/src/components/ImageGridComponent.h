@@ -16,20 +16,6 @@ struct ImageGridData
 	std::shared_ptr<TextureResource> texture;
 };
 
-// Keeps track of which direction the user is moving.  ( for dynamic loading )
-enum UserDirection 
-{
-	MOVING_UP,
-	MOVING_DOWN
-};
-
-// A range around the cursor's index used for loading in textures
-struct CursorRange {
-	int min = 0;
-	int max = 12;
-	int length = 0;
-};
-
 template<typename T>
 class ImageGridComponent : public IList<ImageGridData, T>
 {
@@ -46,9 +32,8 @@ protected:
 	using IList<ImageGridData, T>::Entry;
 	using IList<ImageGridData, T>::mWindow;
 	using IList<ImageGridData, T>::mScrollTier;
-	using IList<ImageGridData, T>::mTotalLoadedTextures;
-	using IList<ImageGridData, T>::mLoadedTextureList;
 	using IList<ImageGridData, T>::mMissingBoxartTexture;
+	using IList<ImageGridData, T>::prefetchEntries;
 
 public:
 	using IList<ImageGridData, T>::size;
@@ -81,12 +66,6 @@ public:
 
 	void setAlignmentCenter();
 
-	void reloadTextures();
-	void dynamicImageLoader();
-	void clearImageAt(int index);
-	void updateLoadRange();
-	void unloadTextures(bool unloadAll = false);
-
 private:
 	Eigen::Vector2f getSquareSize(std::shared_ptr<TextureResource> tex = nullptr) const
 	{
@@ -138,6 +117,9 @@ private:
 	
 	void buildImages();
 	void updateImages();
+	void updatePrefetch();
+	int getFirstVisibleIndex();
+	bool hasNewTextures();
 
 	virtual void onCursorChanged(const CursorState& state);
 
@@ -148,19 +130,8 @@ private:
 	Eigen::Vector2f mMargin;
 	Eigen::Vector2i mDesiredGridSize;
 
-	const int MAX_TEXTURES = 80;			// The maximum amount of images that can be loaded at once
-	const int CURSOR_RANGE = 34;			// How many images will be loaded around the cursor [ Cursor will be center of range ]
-
-	CursorRange mCursorRange;	
-	int mCurrentLoad = 0;					// The current loaded in texture
-	bool bLoading = false;					// Loading in textures in the cursor range.
-	bool bUnloaded = false;					// No longer loading and just finished unloading old textures.
-
-	int mCursorUpdateDelay = 0;				// Holds how many frames have passed [ for waiting to update load range ]
+	TexturePrefetcher mPrefetcher;			// Loads boxart around where the cursor is heading
 
-	int mPrevIndex = 0;
-	int mPrevScrollTier = 0;
-	int mCurrentDirection = MOVING_DOWN;	// Which direction the user is moving (Orientation based on grid, not index)
 	int mAlignment = ALIGN_LEFT;
 	
 	std::vector< std::shared_ptr<GridTileComponent> > mTiles;
@@ -188,15 +159,8 @@ ImageGridComponent<T>::~ImageGridComponent() {
 
 template<typename T>
 void ImageGridComponent<T>::clear(bool clearall) {
-	unloadTextures(clearall);
+	mPrefetcher.cancel();
 	mEntriesDirty = true;
-	mCurrentDirection = MOVING_DOWN;
-
-	mPrevIndex = 0;
-	mCursorUpdateDelay = 0;
-	bLoading = false;
-	bUnloaded = false;
-	mCurrentLoad = 0;
 
 	IList<ImageGridData, T>::clear();
 	mTiles.clear();
@@ -231,10 +195,19 @@ void ImageGridComponent<T>::add(const std::string& name, const std::string& imag
 	entry.name = name;
 	entry.object = obj;
 	entry.strdata = imagePath;
-	if (obj->getType() == 2) entry.data.texture = TextureResource::get(":/folder.png");
+	if (obj->getType() == 2) {
+		entry.data.texture = TextureResource::get(":/folder.png");
+		entry.isTextureLoaded = true;
+	}
+	else if (!ResourceManager::getInstance()->fileExists(imagePath)) {
+		entry.data.texture = mMissingBoxartTexture;
+		entry.isTextureLoaded = true;
+	}
 	else {
-		if (loadTextureNow) entry.data.texture = ResourceManager::getInstance()->fileExists(imagePath) ? TextureResource::get(imagePath) : TextureResource::get(":/blank_game.png");
+		// Textures that aren't loaded now are picked up by the prefetcher as the cursor approaches them
+		if (loadTextureNow) entry.data.texture = TextureResource::get(imagePath);
 		else entry.data.texture = TextureResource::get(":/frame.png");
+		entry.isTextureLoaded = loadTextureNow;
 	}
 
 	static_cast<IList< ImageGridData, T >*>(this)->add(entry);
@@ -247,151 +220,15 @@ FileData* ImageGridComponent<T>::getSelectedObject() {
 }
 
 template<typename T>
-void ImageGridComponent<T>::unloadTextures(bool unloadAll) {
-	// Phase 1: Go through and unload textures based on list of indexes
-	if (mLoadedTextureList.size() > 0) {
-		for (auto i = mLoadedTextureList.begin(); i != mLoadedTextureList.end(); i++) {
-			// Ignore textures currently in range of cursor
-			if (!unloadAll)
-				if ((*i) > mCursorRange.min && (*i) < mCursorRange.max) continue;
-			if ((*i) > mEntries.size()) continue;
-			clearImageAt((*i));
-			i = mLoadedTextureList.erase(i);
-		}
-	}
-
-	// Phase 2: If there are still too many textures.  Just remove all
-	if (mLoadedTextureList.size() > MAX_TEXTURES || unloadAll) {
-		// If there are too many textures loaded, the user is likely out of
-		// Cursor range, so just delete every image.
-		for (int i = 1; i < getEntryCount() - 1; i++)
-			clearImageAt(i);
-		mLoadedTextureList.clear();
-	}
-
-	if (unloadAll) mTiles.clear();
-
-	bLoading = true;		// Reload images now.
-	bUnloaded = false;
-}
-
-template<typename T>
-void ImageGridComponent<T>::reloadTextures() {
-	if (mEntries.size() > 0) {
-		bLoading = true;
-		mCurrentLoad = mCursorRange.min;
-	}
-}
-
-template<typename T>
-void ImageGridComponent<T>::dynamicImageLoader() {
-	if (mLoadedTextureList.size() > MAX_TEXTURES) unloadTextures();
-
-	// if cursor is getting close to the ends of range; update
-	if (getCursorIndex() > mCursorRange.max - 5 && getCursorIndex() < mCursorRange.min + 5) updateLoadRange();
-
-	// Update range if user is out of range and no loading/unloading is being performed.
-	if (bLoading == false && bUnloaded && getCursorIndex() > mCursorRange.max || getCursorIndex() < mCursorRange.min)
-		updateLoadRange();
-
-	// Load in Texture per cycle.
-	if (bLoading && mScrollTier < 1) {
-		// Make sure index is in range.
-		if (mCurrentLoad < getEntryCount() && mCurrentLoad > 0) {
-			if (mLoadedTextureList.size() > MAX_TEXTURES) unloadTextures();
-			static_cast<IList <ImageGridData, T >*>(this)->loadTexture(mCurrentLoad);
-		}
-
-		// update images as they load in.
-		updateImages();
-
-		if (mCurrentLoad < mCursorRange.max) mCurrentLoad++;
-		else bLoading = false;
-	}
-	else
-	{
-		if (bUnloaded) return;
-
-		// Unload images that are out of range in the opposite direction the user is going
-		switch (mCurrentDirection) {
-		case MOVING_DOWN:
-			if (mCursorRange.min > 0) {
-				for (auto i = mLoadedTextureList.begin(); i != mLoadedTextureList.end(); i++) {
-					if ((*i) >= mCursorRange.min) break;
-					clearImageAt((*i));
-					i = mLoadedTextureList.erase(i);
-				}
-			}
-			break;
-
-		case MOVING_UP:
-			if (mCursorRange.max < getEntryCount()) {
-				for (auto i = mLoadedTextureList.begin(); i != mLoadedTextureList.end(); i++) {
-					if ((*i) <= mCursorRange.max) break;
-					clearImageAt((*i));
-					i = mLoadedTextureList.erase(i);
-				}
-			}
-			break;
-		}
-
-		bUnloaded = true;
-	}
-
-	// update and load after user exits out of fast scroll
-	if (mPrevScrollTier > 0 && mScrollTier == 0) {
-		bLoading = false;
-		updateLoadRange();
-	}
-
-	mPrevScrollTier = mScrollTier;
-}
-
-template<typename T>
-void ImageGridComponent<T>::updateLoadRange() {
-	// Only update range if not loading and not within last built range
-	if (bLoading) return;
-
-	int cursorRange = CURSOR_RANGE;
-
-	// Create a range based on cursor position
-	int cursor = getCursorIndex();
-
-	// return if index hasn't changed and range is setup
-	if (cursor == mPrevIndex && mCursorRange.length > 0) return;
-
-	// Get minimum [ will stay at 0 until user moves past 12. ]
-	int rmin = cursor - int(cursorRange / 2);
-	if (rmin < 0) rmin += rmin * -1;
-
-	// get max [ will try to be just the viewable area based on mod size ]
-	int rmax = 0;
-	if (rmin < cursorRange / 2)
-		rmax = cursor + int(cursorRange);
-	else rmax = cursor + int(cursorRange / 2);
-	if (rmax > getEntryCount()) rmax = getEntryCount() - 1;
-
-	// if there is only one game, set range 0-0
-	if (getEntryCount() == 1) rmax = 0;
-
-	mCursorRange.min = rmin;
-	mCursorRange.max = rmax;
-	mCursorRange.length = rmax - rmin;
-
-	mCurrentLoad = mCursorRange.min;
-	bLoading = true;
-
-	// Determin user's direction
-	if (mPrevIndex > cursor) mCurrentDirection = MOVING_UP;
-	else mCurrentDirection = MOVING_DOWN;
-	bUnloaded = false;
-	mPrevIndex = cursor;
+void ImageGridComponent<T>::updatePrefetch() {
+	// Keep a couple of screens worth of tiles around the cursor's landing point
+	Eigen::Vector2i gridSize = getGridSize();
+	mPrefetcher.setRadius(std::max(gridSize.x() * gridSize.y(), 1));
 
-}
-
-template<typename T>
-void ImageGridComponent<T>::clearImageAt(int index) {
-	static_cast<IList <ImageGridData, T >*>(this)->clearImage(index);
+	// Folders and games without boxart already have their final texture
+	prefetchEntries(mPrefetcher, [](const typename IList<ImageGridData, T>::Entry& entry) -> std::string {
+		return entry.isTextureLoaded ? "" : entry.strdata;
+	});
 }
 
 template<typename T>
@@ -429,6 +266,10 @@ void ImageGridComponent<T>::update(int deltaTime)
 {
 	listUpdate(deltaTime);
 
+	// Swap in textures as the loader thread finishes them
+	if (mPrefetcher.isPending() && hasNewTextures())
+		updateImages();
+
 	for (auto t = mTiles.begin(); t != mTiles.end(); t++) {
 		(*t)->update(deltaTime);
 	}
@@ -456,6 +297,7 @@ void ImageGridComponent<T>::render(const Eigen::Affine3f& parentTrans)
 	if(mEntriesDirty)
 	{
 		buildImages();
+		updatePrefetch();
 		updateImages();
 		mEntriesDirty = false;
 	}
@@ -531,8 +373,8 @@ void ImageGridComponent<T>::applyThemeToChildren(const std::shared_ptr<ThemeData
 template<typename T>
 void ImageGridComponent<T>::onCursorChanged(const CursorState& state)
 {
+	updatePrefetch();
 	updateImages();
-	updateLoadRange();
 }
 
 template<typename T>
@@ -602,15 +444,11 @@ void ImageGridComponent<T>::buildImages()
 }
 
 template<typename T>
-void ImageGridComponent<T>::updateImages()
+int ImageGridComponent<T>::getFirstVisibleIndex()
 {
-	if (mTiles.empty())
-		buildImages();
-
 	Eigen::Vector2i gridSize = getGridSize();
 
 	int cursorRow = mCursor / gridSize.x();
-	int cursorCol = mCursor % gridSize.x();
 
 	int start = (cursorRow - (gridSize.y() / 2)) * gridSize.x();
 
@@ -621,7 +459,33 @@ void ImageGridComponent<T>::updateImages()
 	if(start < 0)
 		start = 0;
 
-	unsigned int i = (unsigned int)start;
+	return start;
+}
+
+// true if any entry on screen is still showing a placeholder for a texture that has now loaded
+template<typename T>
+bool ImageGridComponent<T>::hasNewTextures()
+{
+	int end = getFirstVisibleIndex() + (int)mTiles.size();
+	if(end > (int)mEntries.size())
+		end = (int)mEntries.size();
+
+	for(int i = getFirstVisibleIndex(); i < end; i++)
+	{
+		if(!mEntries.at(i).isTextureLoaded && mPrefetcher.get(mEntries.at(i).strdata))
+			return true;
+	}
+
+	return false;
+}
+
+template<typename T>
+void ImageGridComponent<T>::updateImages()
+{
+	if (mTiles.empty())
+		buildImages();
+
+	unsigned int i = (unsigned int)getFirstVisibleIndex();
 	for(unsigned int img = 0; img < mTiles.size(); img++)
 	{
 		// SET IMAGE FROM TEXUTRE
@@ -642,8 +506,17 @@ void ImageGridComponent<T>::updateImages()
 		}else{
 			tile->setSelected(false);
 		}
+		auto& entry = mEntries.at(i);
+		if (!entry.isTextureLoaded) {
+			std::shared_ptr<TextureResource> tex = mPrefetcher.get(entry.strdata);
+			if (tex) {
+				entry.data.texture = tex;
+				entry.isTextureLoaded = true;
+			}
+		}
+
 		tile->setBackgroundPath(":/frame.png");
-		tile->setImage(mEntries.at(i).data.texture);
+		tile->setImage(entry.data.texture);
 		tile->setText(mEntries.at(i).name);
 		tile->setImageToFit(true);
 
@@ -180,13 +180,7 @@ void TextComponent::onTextChanged()
 		const std::string abbrev = "...";
 		Eigen::Vector2f abbrevSize = f->sizeText(abbrev);
 
-		while(text.size() && size.x() + abbrevSize.x() > mSize.x())
-		{
-			size_t newSize = Font::getPrevCursor(text, text.size());
-			text.erase(newSize, text.size() - newSize);
-			size = f->sizeText(text);
-		}
-
+		text.erase(f->getTextCutoff(text, mSize.x() - abbrevSize.x()));
 		text.append(abbrev);
 
 		mTextCache = std::shared_ptr<TextCache>(f->buildTextCache(text, Eigen::Vector2f(0, 0), (mColor >> 8 << 8) | mOpacity, mSize.x(), mAlignment, mLineSpacing));
@@ -17,6 +17,7 @@ GuiTextEditPopupKeyboard::GuiTextEditPopupKeyboard(Window* window, const std::st
 
 	mText = std::make_shared<TextEditComponent>(mWindow);
 	mText->setValue(initValue);
+	mLastValue = initValue;
 
 	if (!multiLine)
 		mText->setCursor(initValue.size());
@@ -218,7 +219,17 @@ bool GuiTextEditPopupKeyboard::input(InputConfig* config, Input input)
 }
 
 void GuiTextEditPopupKeyboard::update(int deltatime) {
+	// keys on the screen and on a real keyboard both end up in mText
+	if(mTextChangedCallback && mText->getValue() != mLastValue)
+	{
+		mLastValue = mText->getValue();
+		mTextChangedCallback(mLastValue);
+	}
+}
 
+void GuiTextEditPopupKeyboard::setTitle(const std::string& title)
+{
+	mTitle->setText(strToUpper(title));
 }
 
 // Shifts the keys when user hits the shift button.
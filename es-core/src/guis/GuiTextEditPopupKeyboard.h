@@ -17,6 +17,10 @@ public:
 	void onSizeChanged();
 	std::vector<HelpPrompt> getHelpPrompts() override;
 
+	void setTitle(const std::string& title);
+	// called with the new text after every change, before OK is pressed
+	inline void setTextChangedCallback(const std::function<void(const std::string&)>& callback) { mTextChangedCallback = callback; }
+
 private:
 	void shiftKeys();
 
@@ -48,6 +52,9 @@ private:
 
 	int mxIndex = 0;		// Stores the X index and makes every grid the same.
 
+	std::function<void(const std::string&)> mTextChangedCallback;
+	std::string mLastValue;
+
 	bool mMultiLine;
 	bool mShift = false;
 	bool mShiftChange = false;
@@ -2,17 +2,50 @@
 #include <iostream>
 #include <algorithm>
 #include <vector>
+#include <iterator>
+#include <cstring>
 #include <boost/filesystem.hpp>
 #include "WindowThemeData.h"
 #include "Renderer.h"
 #include "Log.h"
 #include "Util.h"
+#include "ThreadPool.h"
+#include "Settings.h"
 
 FT_Library Font::sLibrary = NULL;
+std::mutex Font::sLibraryMutex;
+
+// after the library's mutex, so the faces are done with it before it goes at exit
+std::map< std::string, std::shared_ptr<Font::FontFace> > Font::sFaces;
+std::mutex Font::sFacesMutex;
 
 int Font::getSize() const { return mSize; }
 
 std::map< std::pair<std::string, int>, std::weak_ptr<Font> > Font::sFontMap;
+std::map< std::string, std::weak_ptr<Font> > Font::sDistanceFieldAtlases;
+
+std::list<Font::LayoutEntry> Font::sLayoutCache;
+std::unordered_map<Font::LayoutKey, std::list<Font::LayoutEntry>::iterator, Font::LayoutKeyHash> Font::sLayoutCacheIndex;
+Font::LayoutCacheStats Font::sLayoutCacheStats = { 0, 0, 0, 0 };
+
+std::set<UnicodeChar> Font::sWarmGlyphs;
+
+// how many glyphs a work item rasterizes before handing them over to be uploaded
+#define GLYPH_RASTERIZE_BATCH 64
+
+// distance field glyphs are stored at this size and scaled to whatever size they're drawn at
+#define SDF_GLYPH_SIZE 48
+// empty texels around each distance field glyph at SDF_GLYPH_SIZE, so linear filtering near its edge
+// never reads the next glyph in the texture
+#define SDF_SPREAD 4
+// how far inside the edge the field reaches 1, in texels at SDF_GLYPH_SIZE. The field is drawn as the
+// text color's alpha times the field, so this is kept short for the inside to be at the full alpha.
+#define SDF_RAMP 2
+// distance fields are worked out from a rendering this many times larger, so edges fall between texels
+#define SDF_OVERSAMPLE 2
+
+// how much memory the vertex lists of reusable text layouts can take up, in bytes
+#define TEXT_LAYOUT_CACHE_SIZE (4 * 1024 * 1024)
 
 
 // utf8 stuff
@@ -138,20 +171,57 @@ UnicodeChar Font::readUnicodeChar(const std::string& str, size_t& cursor)
 }
 
 
-Font::FontFace::FontFace(ResourceData&& d, int size) : data(d)
+Font::FontFace::FontFace(const ResourceData& d) : data(d), face(NULL)
 {
-	int err = FT_New_Memory_Face(sLibrary, data.ptr.get(), data.length, 0, &face);
-	assert(!err);
-	
-	FT_Set_Pixel_Sizes(face, 0, size);
+	std::lock_guard<std::mutex> lock(sLibraryMutex);
+	if(!data.ptr || FT_New_Memory_Face(sLibrary, data.ptr.get(), data.length, 0, &face))
+		face = NULL;
 }
 
 Font::FontFace::~FontFace()
 {
+	// its sizes go with it
+	std::lock_guard<std::mutex> lock(sLibraryMutex);
 	if(face)
 		FT_Done_Face(face);
 }
 
+bool Font::FontFace::setSize(int size)
+{
+	auto it = sizes.find(size);
+	if(it != sizes.end())
+		return FT_Activate_Size(it->second) == 0;
+
+	FT_Size ftSize;
+	if(FT_New_Size(face, &ftSize) != 0)
+		return false;
+
+	FT_Activate_Size(ftSize);
+	FT_Set_Pixel_Sizes(face, 0, size);
+	sizes[size] = ftSize;
+	return true;
+}
+
+std::shared_ptr<Font::FontFace> Font::getFace(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(sFacesMutex);
+	std::shared_ptr<FontFace>& face = sFaces[path];
+	if(!face)
+	{
+		face.reset(new FontFace(ResourceManager::getInstance()->getFileData(path, RESOURCE_READ_RANDOM)));
+		if(!face->face)
+			LOG(LogError) << "Could not load font face \"" << path << "\"";
+	}
+
+	return face;
+}
+
+void Font::clearFaceCache()
+{
+	std::lock_guard<std::mutex> lock(sFacesMutex);
+	sFaces.clear();
+}
+
 void Font::initLibrary()
 {
 	assert(sLibrary == NULL);
@@ -166,10 +236,7 @@ size_t Font::getMemUsage() const
 {
 	size_t memUsage = 0;
 	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
-		memUsage += it->textureSize.x() * it->textureSize.y() * 4;
-
-	for(auto it = mFaceCache.begin(); it != mFaceCache.end(); it++)
-		memUsage += it->second->data.length;
+		memUsage += (*it)->textureSize.x() * (*it)->textureSize.y() * 4;
 
 	return memUsage;
 }
@@ -191,10 +258,23 @@ size_t Font::getTotalMemUsage()
 		it++;
 	}
 
+	auto atlasIt = sDistanceFieldAtlases.begin();
+	while(atlasIt != sDistanceFieldAtlases.end())
+	{
+		if(atlasIt->second.expired())
+		{
+			atlasIt = sDistanceFieldAtlases.erase(atlasIt);
+			continue;
+		}
+
+		total += atlasIt->second.lock()->getMemUsage();
+		atlasIt++;
+	}
+
 	return total;
 }
 
-Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
+Font::Font(int size, const std::string& path, GlyphMode mode) : mMode(mode), mPendingGlyphs(std::make_shared<PendingGlyphs>()), mWarm(false), mSize(size), mPath(path)
 {
 	assert(mSize > 0);
 	
@@ -203,15 +283,17 @@ Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
 	if(!sLibrary)
 		initLibrary();
 
+	if(mMode == GLYPHS_DISTANCE_FIELD)
+		mAtlas = getDistanceFieldAtlas(mPath);
+
 	// always initialize ASCII characters
 	for(UnicodeChar i = 32; i < 128; i++)
 		getGlyph(i);
-
-	clearFaceCache();
 }
 
 Font::~Font()
 {
+	removeCachedLayouts();
 	unload(ResourceManager::getInstance());
 }
 
@@ -223,6 +305,9 @@ void Font::reload(std::shared_ptr<ResourceManager>& rm)
 void Font::unload(std::shared_ptr<ResourceManager>& rm)
 {
 	unloadTextures();
+
+	// the files may change while we're unloaded, reload() renders from them again
+	clearFaceCache();
 }
 
 std::shared_ptr<Font> Font::get(int size, const std::string& path)
@@ -259,17 +344,30 @@ std::shared_ptr<Font> Font::get(int size, const std::string& path)
 			if (!it->second.expired())  return it->second.lock();
 	}
 
-	std::shared_ptr<Font> font = std::shared_ptr<Font>(new Font(def.second, def.first));
+	const GlyphMode mode = Settings::getInstance()->getBool("FontDistanceField") ? GLYPHS_DISTANCE_FIELD : GLYPHS_BITMAP;
+	std::shared_ptr<Font> font = std::shared_ptr<Font>(new Font(def.second, def.first, mode));
 	sFontMap[def] = std::weak_ptr<Font>(font);
 	ResourceManager::getInstance()->addReloadable(font);
 	return font;
 }
 
+std::shared_ptr<Font> Font::getDistanceFieldAtlas(const std::string& path)
+{
+	auto it = sDistanceFieldAtlases.find(path);
+	if(it != sDistanceFieldAtlases.end() && !it->second.expired())
+		return it->second.lock();
+
+	std::shared_ptr<Font> atlas = std::shared_ptr<Font>(new Font(SDF_GLYPH_SIZE, path, GLYPHS_DISTANCE_FIELD_ATLAS));
+	sDistanceFieldAtlases[path] = std::weak_ptr<Font>(atlas);
+	ResourceManager::getInstance()->addReloadable(atlas);
+	return atlas;
+}
+
 void Font::unloadTextures()
 {
 	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
 	{
-		it->deinitTexture();
+		(*it)->deinitTexture();
 	}
 }
 
@@ -279,6 +377,7 @@ Font::FontTexture::FontTexture()
 	textureSize << 2048, 512;
 	writePos = Eigen::Vector2i::Zero();
 	rowHeight = 0;
+	distanceField = false;
 }
 
 Font::FontTexture::~FontTexture()
@@ -326,8 +425,9 @@ void Font::FontTexture::initTexture()
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	const GLfloat filter = distanceField ? GL_LINEAR : GL_NEAREST;
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
 
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
@@ -349,7 +449,7 @@ void Font::getTextureForNewGlyph(const Eigen::Vector2i& glyphSize, FontTexture*&
 	if(mTextures.size())
 	{
 		// check if the most recent texture has space
-		tex_out = &mTextures.back();
+		tex_out = mTextures.back().get();
 
 		// will this one work?
 		if(tex_out->findEmpty(glyphSize, cursor_out))
@@ -358,8 +458,9 @@ void Font::getTextureForNewGlyph(const Eigen::Vector2i& glyphSize, FontTexture*&
 
 	// current textures are full,
 	// make a new one
-	mTextures.push_back(FontTexture());
-	tex_out = &mTextures.back();
+	mTextures.push_back(std::unique_ptr<FontTexture>(new FontTexture()));
+	tex_out = mTextures.back().get();
+	tex_out->distanceField = (mMode == GLYPHS_DISTANCE_FIELD_ATLAS);
 	tex_out->initTexture();
 	
 	bool ok = tex_out->findEmpty(glyphSize, cursor_out);
@@ -423,124 +524,465 @@ std::vector<std::string> getFallbackFontPaths()
 #endif
 }
 
-FT_Face Font::getFaceForChar(UnicodeChar id)
+int Font::getFaceSize() const
+{
+	return mMode == GLYPHS_DISTANCE_FIELD_ATLAS ? mSize * SDF_OVERSAMPLE : mSize;
+}
+
+std::shared_ptr<Font::FontFace> Font::lockFaceForChar(const std::string& path, UnicodeChar id, std::unique_lock<std::mutex>& lock_out)
 {
 	static const std::vector<std::string> fallbackFonts = getFallbackFontPaths();
 
 	// look through our current font + fallback fonts to see if any have the glyph we're looking for
 	for(unsigned int i = 0; i < fallbackFonts.size() + 1; i++)
 	{
-		auto fit = mFaceCache.find(i);
+		std::shared_ptr<FontFace> face = getFace(i == 0 ? path : fallbackFonts.at(i - 1));
+		if(!face->face)
+			continue;
 
-		if(fit == mFaceCache.end()) // doesn't exist yet
+		std::unique_lock<std::mutex> lock(face->mutex);
+		if(FT_Get_Char_Index(face->face, id) != 0)
 		{
-			// i == 0 -> mPath
-			// otherwise, take from fallbackFonts
-			const std::string& path = (i == 0 ? mPath : fallbackFonts.at(i - 1));
-			ResourceData data = ResourceManager::getInstance()->getFileData(path);
-			mFaceCache[i] = std::unique_ptr<FontFace>(new FontFace(std::move(data), mSize));
-			fit = mFaceCache.find(i);
+			lock_out = std::move(lock);
+			return face;
 		}
-
-		if(FT_Get_Char_Index(fit->second->face, id) != 0)
-			return fit->second->face;
 	}
 
 	// nothing has a valid glyph - return the "real" face so we get a "missing" character
-	return mFaceCache.begin()->second->face;
+	std::shared_ptr<FontFace> face = getFace(path);
+	if(!face->face)
+		return NULL;
+
+	lock_out = std::unique_lock<std::mutex>(face->mutex);
+	return face;
 }
 
-void Font::clearFaceCache()
+// For every texel, the distance to the nearest seed texel. Uses 8SSEDT, which passes the offset
+// to the nearest seed along in two sweeps over the grid instead of searching around each texel.
+static std::vector<float> distanceToSeeds(const std::vector<bool>& seeds, int w, int h)
 {
-	mFaceCache.clear();
+	struct Offset
+	{
+		int x, y;
+		int lengthSq() const { return x * x + y * y; }
+	};
+
+	const Offset none = { w + h, w + h };
+	std::vector<Offset> offsets(w * h);
+	for(int i = 0; i < w * h; i++)
+	{
+		if(seeds[i])
+			offsets[i].x = offsets[i].y = 0;
+		else
+			offsets[i] = none;
+	}
+
+	auto compare = [&](int x, int y, int dx, int dy)
+	{
+		if(x + dx < 0 || x + dx >= w || y + dy < 0 || y + dy >= h)
+			return;
+
+		Offset other = offsets[(y + dy) * w + x + dx];
+		other.x += dx;
+		other.y += dy;
+
+		Offset& offset = offsets[y * w + x];
+		if(other.lengthSq() < offset.lengthSq())
+			offset = other;
+	};
+
+	for(int y = 0; y < h; y++)
+	{
+		for(int x = 0; x < w; x++)
+		{
+			compare(x, y, -1, 0);
+			compare(x, y, 0, -1);
+			compare(x, y, -1, -1);
+			compare(x, y, 1, -1);
+		}
+		for(int x = w - 1; x >= 0; x--)
+			compare(x, y, 1, 0);
+	}
+
+	for(int y = h - 1; y >= 0; y--)
+	{
+		for(int x = w - 1; x >= 0; x--)
+		{
+			compare(x, y, 1, 0);
+			compare(x, y, 0, 1);
+			compare(x, y, -1, 1);
+			compare(x, y, 1, 1);
+		}
+		for(int x = 0; x < w; x++)
+			compare(x, y, -1, 0);
+	}
+
+	std::vector<float> distances(w * h);
+	for(int i = 0; i < w * h; i++)
+		distances[i] = sqrtf((float)offsets[i].lengthSq());
+
+	return distances;
 }
 
-Font::Glyph* Font::getGlyph(UnicodeChar id)
+// Turns a glyph rendered at SDF_OVERSAMPLE times its size into a signed distance field at its size, with
+// SDF_SPREAD texels of padding. The edge of the glyph is 0.5, going up to 1 SDF_RAMP texels inside and down
+// to 0 as far outside.
+static void makeDistanceField(const FT_Bitmap& bitmap, Eigen::Vector2i& size_out, std::vector<unsigned char>& field_out)
 {
-	// is it already loaded?
-	auto it = mGlyphMap.find(id);
-	if(it != mGlyphMap.end())
-		return &it->second;
+	const int pad = SDF_SPREAD * SDF_OVERSAMPLE;
+	const int w = ((bitmap.width + SDF_OVERSAMPLE - 1) / SDF_OVERSAMPLE) * SDF_OVERSAMPLE + pad * 2;
+	const int h = ((bitmap.rows + SDF_OVERSAMPLE - 1) / SDF_OVERSAMPLE) * SDF_OVERSAMPLE + pad * 2;
 
-	// nope, need to make a glyph
-	FT_Face face = getFaceForChar(id);
-	if(!face)
+	std::vector<bool> inside(w * h, false);
+	std::vector<bool> outside(w * h, true);
+	for(unsigned int y = 0; y < bitmap.rows; y++)
 	{
-		LOG(LogError) << "Could not find appropriate font face for character " << id << " for font " << mPath;
-		return NULL;
+		for(unsigned int x = 0; x < bitmap.width; x++)
+		{
+			const int i = (y + pad) * w + x + pad;
+			inside[i] = bitmap.buffer[y * bitmap.pitch + x] >= 128;
+			outside[i] = !inside[i];
+		}
 	}
 
-	FT_GlyphSlot g = face->glyph;
+	// texel centers are half a texel from the edge on either side of it
+	const std::vector<float> toOutside = distanceToSeeds(outside, w, h);
+	const std::vector<float> toInside = distanceToSeeds(inside, w, h);
 
-	if(FT_Load_Char(face, id, FT_LOAD_RENDER))
+	size_out << w / SDF_OVERSAMPLE, h / SDF_OVERSAMPLE;
+	field_out.resize(size_out.x() * size_out.y());
+	for(int y = 0; y < size_out.y(); y++)
 	{
-		LOG(LogError) << "Could not find glyph for character " << id << " for font " << mPath << ", size " << mSize << "!";
-		return NULL;
+		for(int x = 0; x < size_out.x(); x++)
+		{
+			float distance = 0;
+			for(int sy = 0; sy < SDF_OVERSAMPLE; sy++)
+			{
+				for(int sx = 0; sx < SDF_OVERSAMPLE; sx++)
+				{
+					const int i = (y * SDF_OVERSAMPLE + sy) * w + x * SDF_OVERSAMPLE + sx;
+					distance += inside[i] ? toOutside[i] - 0.5f : 0.5f - toInside[i];
+				}
+			}
+			distance /= SDF_OVERSAMPLE * SDF_OVERSAMPLE * SDF_OVERSAMPLE; // averaged, and in texels at the final size
+
+			const float value = 0.5f + distance / (SDF_RAMP * 2);
+			field_out[y * size_out.x() + x] = (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+	}
+}
+
+bool Font::rasterizeGlyph(const std::string& path, int size, UnicodeChar id, bool distanceField, RasterizedGlyph& glyph_out)
+{
+	std::shared_ptr<FontFace> face; // outlives the lock on its mutex
+	std::unique_lock<std::mutex> lock;
+	face = lockFaceForChar(path, id, lock);
+	if(!face || !face->setSize(size) || FT_Load_Char(face->face, id, FT_LOAD_RENDER))
+		return false;
+
+	FT_GlyphSlot g = face->face->glyph;
+
+	// distance fields are rendered larger than they're stored
+	const float scale = distanceField ? 1.0f / SDF_OVERSAMPLE : 1.0f;
+
+	glyph_out.id = id;
+	glyph_out.advance << (float)g->metrics.horiAdvance / 64.0f * scale, (float)g->metrics.vertAdvance / 64.0f * scale;
+	glyph_out.bearing << (float)g->metrics.horiBearingX / 64.0f * scale, (float)g->metrics.horiBearingY / 64.0f * scale;
+
+	// copy it out of the glyph slot, dropping any padding FreeType put at the end of each row
+	glyph_out.size << g->bitmap.width, g->bitmap.rows;
+	glyph_out.padding = 0;
+	glyph_out.bitmap.resize(glyph_out.size.x() * glyph_out.size.y());
+	for(int y = 0; y < glyph_out.size.y(); y++)
+		memcpy(&glyph_out.bitmap[y * glyph_out.size.x()], g->bitmap.buffer + y * g->bitmap.pitch, glyph_out.size.x());
+
+	// the face is shared, so the slow part is done without it
+	lock.unlock();
+
+	if(distanceField)
+	{
+		if(glyph_out.size.x() == 0 || glyph_out.size.y() == 0)
+		{
+			glyph_out.size << 0, 0; // nothing to draw, like a space
+			glyph_out.bitmap.clear();
+			return true;
+		}
+
+		FT_Bitmap coverage;
+		memset(&coverage, 0, sizeof(coverage));
+		coverage.width = glyph_out.size.x();
+		coverage.rows = glyph_out.size.y();
+		coverage.pitch = glyph_out.size.x();
+		coverage.buffer = glyph_out.bitmap.data();
+
+		std::vector<unsigned char> field;
+		makeDistanceField(coverage, glyph_out.size, field);
+		glyph_out.bitmap.swap(field);
+		glyph_out.padding = SDF_SPREAD;
 	}
 
-	Eigen::Vector2i glyphSize(g->bitmap.width, g->bitmap.rows);
+	return true;
+}
 
+Font::Glyph* Font::addGlyph(const RasterizedGlyph& raster, Eigen::Vector2i& cursor_out)
+{
 	FontTexture* tex = NULL;
-	Eigen::Vector2i cursor;
-	getTextureForNewGlyph(glyphSize, tex, cursor);
+	getTextureForNewGlyph(raster.size, tex, cursor_out);
 
 	// getTextureForNewGlyph can fail if the glyph is bigger than the max texture size (absurdly large font size)
 	if(tex == NULL)
 	{
-		LOG(LogError) << "Could not create glyph for character " << id << " for font " << mPath << ", size " << mSize << " (no suitable texture found)!";
+		LOG(LogError) << "Could not create glyph for character " << raster.id << " for font " << mPath << ", size " << mSize << " (no suitable texture found)!";
 		return NULL;
 	}
 
 	// create glyph
-	Glyph& glyph = mGlyphMap[id];
+	Glyph& glyph = mGlyphMap[raster.id];
 	
 	glyph.texture = tex;
-	glyph.texPos << cursor.x() / (float)tex->textureSize.x(), cursor.y() / (float)tex->textureSize.y();
-	glyph.texSize << glyphSize.x() / (float)tex->textureSize.x(), glyphSize.y() / (float)tex->textureSize.y();
+	glyph.texPos << cursor_out.x() / (float)tex->textureSize.x(), cursor_out.y() / (float)tex->textureSize.y();
+	glyph.texSize << raster.size.x() / (float)tex->textureSize.x(), raster.size.y() / (float)tex->textureSize.y();
 
-	glyph.advance << (float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f;
-	glyph.bearing << (float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f;
+	glyph.size = raster.size.cast<float>();
+	glyph.padding = (float)raster.padding;
 
-	// upload glyph bitmap to texture
-	glBindTexture(GL_TEXTURE_2D, tex->textureId);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), GL_ALPHA, GL_UNSIGNED_BYTE, g->bitmap.buffer);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	glyph.advance = raster.advance;
+	glyph.bearing = raster.bearing;
 
 	// update max glyph height
-	if(glyphSize.y() > mMaxGlyphHeight)
-		mMaxGlyphHeight = glyphSize.y();
+	if(raster.size.y() - raster.padding * 2 > mMaxGlyphHeight)
+		mMaxGlyphHeight = raster.size.y() - raster.padding * 2;
 
-	// done
 	return &glyph;
 }
 
-// completely recreate the texture data for all textures based on mGlyphs information
+Font::Glyph* Font::getGlyph(UnicodeChar id)
+{
+	// is it already loaded?
+	auto it = mGlyphMap.find(id);
+	if(it != mGlyphMap.end())
+		return &it->second;
+
+	if(mAtlas)
+	{
+		// everything but the size comes from the shared distance field
+		Glyph* source = mAtlas->getGlyph(id);
+		if(!source)
+			return NULL;
+
+		const float scale = (float)mSize / mAtlas->mSize;
+
+		Glyph& glyph = mGlyphMap[id];
+		glyph = *source;
+		glyph.size *= scale;
+		glyph.padding *= scale;
+		glyph.advance *= scale;
+		glyph.bearing *= scale;
+
+		const int height = (int)(glyph.size.y() - glyph.padding * 2 + 0.5f);
+		if(height > mMaxGlyphHeight)
+			mMaxGlyphHeight = height;
+
+		return &glyph;
+	}
+
+	// nope, need to make a glyph
+	// (if the worker pool is already on it, it's just rendered twice and the second one is ignored)
+	RasterizedGlyph raster;
+	if(!rasterizeGlyph(mPath, getFaceSize(), id, mMode == GLYPHS_DISTANCE_FIELD_ATLAS, raster))
+	{
+		LOG(LogError) << "Could not find glyph for character " << id << " for font " << mPath << ", size " << mSize << "!";
+		return NULL;
+	}
+
+	Eigen::Vector2i cursor;
+	Glyph* glyph = addGlyph(raster, cursor);
+	if(!glyph)
+		return NULL;
+
+	// upload glyph bitmap to texture
+	glBindTexture(GL_TEXTURE_2D, glyph->texture->textureId);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, cursor.x(), cursor.y(), raster.size.x(), raster.size.y(), GL_ALPHA, GL_UNSIGNED_BYTE, raster.bitmap.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return glyph;
+}
+
+void Font::setWarmGlyphs(const std::set<UnicodeChar>& chars)
+{
+	sWarmGlyphs.insert(chars.begin(), chars.end());
+
+	for(auto it = sFontMap.begin(); it != sFontMap.end(); it++)
+	{
+		std::shared_ptr<Font> font = it->second.lock();
+		if(font && font->mWarm)
+			font->requestGlyphs(chars);
+	}
+}
+
+void Font::warmGlyphs()
+{
+	mWarm = true;
+	requestGlyphs(sWarmGlyphs);
+}
+
+void Font::requestGlyphs(const std::set<UnicodeChar>& chars)
+{
+	if(mAtlas)
+	{
+		mAtlas->requestGlyphs(chars);
+		return;
+	}
+
+	std::vector<UnicodeChar> missing;
+	for(auto it = chars.begin(); it != chars.end(); it++)
+	{
+		if(mGlyphMap.find(*it) == mGlyphMap.end() && mRequestedGlyphs.insert(*it).second)
+			missing.push_back(*it);
+	}
+
+	if(missing.empty())
+		return;
+
+	const std::string path = mPath;
+	const int size = getFaceSize();
+	const bool distanceField = (mMode == GLYPHS_DISTANCE_FIELD_ATLAS);
+	std::shared_ptr<PendingGlyphs> pending = mPendingGlyphs;
+
+	ThreadPool::getInstance()->queueWorkItem([path, size, distanceField, missing, pending]
+	{
+		std::vector<RasterizedGlyph> glyphs;
+
+		for(auto it = missing.begin(); it != missing.end(); it++)
+		{
+			RasterizedGlyph glyph;
+			if(rasterizeGlyph(path, size, *it, distanceField, glyph))
+				glyphs.push_back(std::move(glyph));
+
+			// hand them over a few at a time so the first ones can be used while the rest are rendered
+			if(glyphs.size() >= GLYPH_RASTERIZE_BATCH || (it + 1 == missing.end() && !glyphs.empty()))
+			{
+				std::lock_guard<std::mutex> lock(pending->mutex);
+				std::move(glyphs.begin(), glyphs.end(), std::back_inserter(pending->glyphs));
+				glyphs.clear();
+			}
+		}
+	});
+}
+
+void Font::uploadPendingGlyphs()
+{
+	for(auto it = sFontMap.begin(); it != sFontMap.end(); it++)
+	{
+		std::shared_ptr<Font> font = it->second.lock();
+		if(font)
+			font->addPendingGlyphs();
+	}
+
+	for(auto it = sDistanceFieldAtlases.begin(); it != sDistanceFieldAtlases.end(); it++)
+	{
+		std::shared_ptr<Font> atlas = it->second.lock();
+		if(atlas)
+			atlas->addPendingGlyphs();
+	}
+}
+
+void Font::addPendingGlyphs()
+{
+	std::vector<RasterizedGlyph> glyphs;
+	{
+		std::lock_guard<std::mutex> lock(mPendingGlyphs->mutex);
+		glyphs.swap(mPendingGlyphs->glyphs);
+	}
+
+	if(glyphs.empty())
+		return;
+
+	// Glyphs are packed left to right along a row of the texture, so everything that lands on
+	// the same row is copied into one strip and uploaded with a single glTexSubImage2D.
+	FontTexture* stripTex = NULL;
+	Eigen::Vector2i stripPos(0, 0);
+	Eigen::Vector2i stripSize(0, 0);
+	std::vector< std::pair<const RasterizedGlyph*, int> > stripGlyphs; // and their x offset in the strip
+	std::vector<unsigned char> strip;
+
+	auto uploadStrip = [&]
+	{
+		if(stripGlyphs.empty())
+			return;
+
+		strip.assign(stripSize.x() * stripSize.y(), 0);
+		for(auto it = stripGlyphs.begin(); it != stripGlyphs.end(); it++)
+		{
+			const RasterizedGlyph* raster = it->first;
+			for(int y = 0; y < raster->size.y(); y++)
+				memcpy(&strip[y * stripSize.x() + it->second], &raster->bitmap[y * raster->size.x()], raster->size.x());
+		}
+
+		// if the textures are unloaded right now they're filled in by rebuildTextures() instead
+		if(stripTex->textureId != 0)
+		{
+			glBindTexture(GL_TEXTURE_2D, stripTex->textureId);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, stripPos.x(), stripPos.y(), stripSize.x(), stripSize.y(), GL_ALPHA, GL_UNSIGNED_BYTE, strip.data());
+		}
+
+		stripGlyphs.clear();
+	};
+
+	for(auto it = glyphs.begin(); it != glyphs.end(); it++)
+	{
+		// getGlyph() may have needed it before it got here
+		if(mGlyphMap.find(it->id) != mGlyphMap.end())
+			continue;
+
+		Eigen::Vector2i cursor;
+		Glyph* glyph = addGlyph(*it, cursor);
+		if(!glyph)
+			continue;
+
+		if(glyph->texture != stripTex || cursor.y() != stripPos.y())
+		{
+			uploadStrip();
+			stripTex = glyph->texture;
+			stripPos = cursor;
+			stripSize << 0, 0;
+		}
+
+		stripGlyphs.push_back(std::make_pair(&(*it), cursor.x() - stripPos.x()));
+		stripSize << cursor.x() + it->size.x() - stripPos.x(), std::max(stripSize.y(), it->size.y());
+	}
+
+	uploadStrip();
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void Font::rebuildTextures()
 {
 	// recreate OpenGL textures
 	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
 	{
-		it->initTexture();
+		(*it)->initTexture();
 	}
 
+	// distance field fonts don't have any textures, their glyphs are in mAtlas's
+	if(mAtlas)
+		return;
+
 	// reupload the texture data
 	for(auto it = mGlyphMap.begin(); it != mGlyphMap.end(); it++)
 	{
-		FT_Face face = getFaceForChar(it->first);
-		FT_GlyphSlot glyphSlot = face->glyph;
-
-		// load the glyph bitmap through FT
-		FT_Load_Char(face, it->first, FT_LOAD_RENDER);
+		RasterizedGlyph raster;
+		if(!rasterizeGlyph(mPath, getFaceSize(), it->first, mMode == GLYPHS_DISTANCE_FIELD_ATLAS, raster))
+			continue;
 
 		FontTexture* tex = it->second.texture;
 		
-		// find the position/size
-		Eigen::Vector2i cursor(it->second.texPos.x() * tex->textureSize.x(), it->second.texPos.y() * tex->textureSize.y());
-		Eigen::Vector2i glyphSize(it->second.texSize.x() * tex->textureSize.x(), it->second.texSize.y() * tex->textureSize.y());
+		// find the position
+		Eigen::Vector2i cursor(it->second.texPos.x() * tex->textureSize.x() + 0.5f, it->second.texPos.y() * tex->textureSize.y() + 0.5f);
 		
 		// upload to texture
 		glBindTexture(GL_TEXTURE_2D, tex->textureId);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), GL_ALPHA, GL_UNSIGNED_BYTE, glyphSlot->bitmap.buffer);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, cursor.x(), cursor.y(), raster.size.x(), raster.size.y(), GL_ALPHA, GL_UNSIGNED_BYTE, raster.bitmap.data());
 	}
 
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -554,47 +996,63 @@ void Font::renderTextCache(TextCache* cache)
 		return;
 	}
 
-	for(auto it = cache->vertexLists.begin(); it != cache->vertexLists.end(); it++)
+	const std::vector<TextCache::VertexList>& vertexLists = *cache->vertexLists;
+	for(unsigned int i = 0; i < vertexLists.size(); i++)
 	{
-		assert(*it->textureIdPtr != 0);
-
-		auto vertexList = *it;
+		const TextCache::VertexList& vertexList = vertexLists.at(i);
+		assert(*vertexList.textureIdPtr != 0);
 
-		glBindTexture(GL_TEXTURE_2D, *it->textureIdPtr);
+		glBindTexture(GL_TEXTURE_2D, *vertexList.textureIdPtr);
 		glEnable(GL_TEXTURE_2D);
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+		if(vertexList.distanceField)
+		{
+			// Keep what's inside the edge (field >= 0.5) and drop the rest. The alpha is field * color
+			// alpha, so the test is against half the color's alpha and never lets the text get more
+			// opaque than its color. The field is 1 just inside the edge (SDF_RAMP), fading text keeps
+			// its shape and edges are a little softer.
+			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_REPLACE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SRC0_RGB, GL_PRIMARY_COLOR);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_MODULATE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SRC0_ALPHA, GL_TEXTURE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SRC1_ALPHA, GL_PRIMARY_COLOR);
+
+			glEnable(GL_ALPHA_TEST);
+			glAlphaFunc(GL_GEQUAL, cache->colors.at(i).at(3) / 255.0f * 0.5f);
+		}
+
 		glEnableClientState(GL_VERTEX_ARRAY);
 		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 		glEnableClientState(GL_COLOR_ARRAY);
 
-		glVertexPointer(2, GL_FLOAT, sizeof(TextCache::Vertex), it->verts[0].pos.data());
-		glTexCoordPointer(2, GL_FLOAT, sizeof(TextCache::Vertex), it->verts[0].tex.data());
-		glColorPointer(4, GL_UNSIGNED_BYTE, 0, it->colors.data());
+		glVertexPointer(2, GL_FLOAT, sizeof(TextCache::Vertex), vertexList.verts[0].pos.data());
+		glTexCoordPointer(2, GL_FLOAT, sizeof(TextCache::Vertex), vertexList.verts[0].tex.data());
+		glColorPointer(4, GL_UNSIGNED_BYTE, 0, cache->colors.at(i).data());
 
-		glDrawArrays(GL_TRIANGLES, 0, it->verts.size());
+		glDrawArrays(GL_TRIANGLES, 0, vertexList.verts.size());
 
 		glDisableClientState(GL_VERTEX_ARRAY);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		glDisableClientState(GL_COLOR_ARRAY);
 
+		if(vertexList.distanceField)
+		{
+			glDisable(GL_ALPHA_TEST);
+			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		}
+
 		glDisable(GL_TEXTURE_2D);
 		glDisable(GL_BLEND);
 	}
 }
 
-Eigen::Vector2f Font::sizeText(std::string text, float lineSpacing)
+void Font::measureText(const std::string& text, size_t start, size_t end, float& highestWidth, float& lineWidth)
 {
-	float lineWidth = 0.0f;
-	float highestWidth = 0.0f;
-
-	const float lineHeight = getHeight(lineSpacing);
-
-	float y = lineHeight;
-
-	size_t i = 0;
-	while(i < text.length())
+	size_t i = start;
+	while(i < end)
 	{
 		UnicodeChar character = readUnicodeChar(text, i); // advances i
 
@@ -604,13 +1062,31 @@ Eigen::Vector2f Font::sizeText(std::string text, float lineSpacing)
 				highestWidth = lineWidth;
 
 			lineWidth = 0.0f;
-			y += lineHeight;
 		}
 
 		Glyph* glyph = getGlyph(character);
 		if(glyph)
 			lineWidth += glyph->advance.x();
 	}
+}
+
+Eigen::Vector2f Font::sizeText(std::string text, float lineSpacing)
+{
+	float lineWidth = 0.0f;
+	float highestWidth = 0.0f;
+
+	const float lineHeight = getHeight(lineSpacing);
+
+	float y = lineHeight;
+
+	size_t newline = text.find('\n');
+	while(newline != std::string::npos)
+	{
+		y += lineHeight;
+		newline = text.find('\n', newline + 1);
+	}
+
+	measureText(text, 0, text.length(), highestWidth, lineWidth);
 
 	if(lineWidth > highestWidth)
 		highestWidth = lineWidth;
@@ -627,60 +1103,90 @@ float Font::getLetterHeight()
 {
 	Glyph* glyph = getGlyph((UnicodeChar)'S');
 	assert(glyph);
-	return glyph->texSize.y() * glyph->texture->textureSize.y();
+	return glyph->size.y() - glyph->padding * 2;
 }
 
-//the worst algorithm ever written
 //breaks up a normal string with newlines to make it fit xLen
 std::string Font::wrapText(std::string text, float xLen)
 {
-	std::string out;
-
-	std::string line, word, temp;
-	size_t space;
+	return getWrappedLayout(text, xLen).wrapped;
+}
 
-	Eigen::Vector2f textSize;
+const Font::WrappedLayout& Font::getWrappedLayout(const std::string& text, float xLen)
+{
+	if(mLastWrap.xLen == xLen && mLastWrap.text == text)
+		return mLastWrap;
 
-	while(text.length() > 0) //while there's text or we still have text to render
-	{
-		space = text.find_first_of(" \t\n");
-		if(space == std::string::npos)
-			space = text.length() - 1;
+	// Words (including the space, tab or newline after them) are added to the line one at a time,
+	// keeping a running measurement of the line, so each word is only measured again when it has
+	// to start a new line.
+	std::string out;
+	out.reserve(text.length() + text.length() / 8);
 
-		word = text.substr(0, space + 1);
-		text.erase(0, space + 1);
+	size_t lineStart = 0;
+	float lineHighest = 0.0f;
+	float lineWidth = 0.0f;
 
-		temp = line + word;
+	size_t wordStart = 0;
+	while(wordStart < text.length())
+	{
+		size_t space = text.find_first_of(" \t\n", wordStart);
+		size_t wordEnd = (space == std::string::npos) ? text.length() : space + 1;
 
-		textSize = sizeText(temp);
+		float highest = lineHighest;
+		float width = lineWidth;
+		measureText(text, wordStart, wordEnd, highest, width);
 
 		// if the word will fit on the line, add it to our line, and continue
-		if(textSize.x() <= xLen)
+		if(std::max(highest, width) <= xLen)
 		{
-			line = temp;
-			continue;
+			lineHighest = highest;
+			lineWidth = width;
 		}else{
 			// the next word won't fit, so break here
-			out += line + '\n';
-			line = word;
+			out.append(text, lineStart, wordStart - lineStart);
+			out += '\n';
+
+			lineStart = wordStart;
+			lineHighest = 0.0f;
+			lineWidth = 0.0f;
+			measureText(text, wordStart, wordEnd, lineHighest, lineWidth);
 		}
+
+		wordStart = wordEnd;
 	}
 
 	// whatever's left should fit
-	out += line;
+	out.append(text, lineStart, std::string::npos);
+
+	mLastWrap.text = text;
+	mLastWrap.xLen = xLen;
+	mLastWrap.wrapped = out;
 
-	return out;
+	float highestWidth = 0.0f;
+	float width = 0.0f;
+	measureText(out, 0, out.length(), highestWidth, width);
+	mLastWrap.width = std::max(highestWidth, width);
+	mLastWrap.lineCount = std::count(out.begin(), out.end(), '\n') + 1;
+
+	return mLastWrap;
 }
 
 Eigen::Vector2f Font::sizeWrappedText(std::string text, float xLen, float lineSpacing)
 {
-	text = wrapText(text, xLen);
-	return sizeText(text, lineSpacing);
+	const WrappedLayout& layout = getWrappedLayout(text, xLen);
+
+	const float lineHeight = getHeight(lineSpacing);
+	float y = lineHeight;
+	for(unsigned int i = 1; i < layout.lineCount; i++)
+		y += lineHeight;
+
+	return Eigen::Vector2f(layout.width, y);
 }
 
 Eigen::Vector2f Font::getWrappedTextCursorOffset(std::string text, float xLen, size_t stop, float lineSpacing)
 {
-	std::string wrappedText = wrapText(text, xLen);
+	const std::string& wrappedText = getWrappedLayout(text, xLen).wrapped;
 
 	float lineWidth = 0.0f;
 	float y = 0.0f;
@@ -718,6 +1224,29 @@ Eigen::Vector2f Font::getWrappedTextCursorOffset(std::string text, float xLen, s
 	return Eigen::Vector2f(lineWidth, y);
 }
 
+size_t Font::getTextCutoff(const std::string& text, float xLen)
+{
+	// widths only grow as characters are added, so the first one that doesn't fit is the cutoff
+	float width = 0.0f;
+	size_t end = 0;
+	size_t cursor = 0;
+	while(cursor < text.length())
+	{
+		UnicodeChar character = readUnicodeChar(text, cursor); // advances cursor
+
+		Glyph* glyph = getGlyph(character);
+		if(glyph)
+			width += glyph->advance.x();
+
+		if(width > xLen)
+			break;
+
+		end = cursor;
+	}
+
+	return end;
+}
+
 //=============================================================================================================
 //TextCache
 //=============================================================================================================
@@ -748,7 +1277,7 @@ inline float font_round(float v)
 	return round(v);
 }
 
-TextCache* Font::buildTextCache(const std::string& text, Eigen::Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
+std::shared_ptr< const std::vector<TextCache::VertexList> > Font::layoutText(const std::string& text, Eigen::Vector2f offset, float xLen, Alignment alignment, float lineSpacing)
 {
 	float x = offset[0] + (xLen != 0 ? getNewlineStartOffset(text, 0, xLen, alignment) : 0);
 	
@@ -786,14 +1315,13 @@ TextCache* Font::buildTextCache(const std::string& text, Eigen::Vector2f offset,
 		verts.resize(oldVertSize + 6);
 		TextCache::Vertex* tri = verts.data() + oldVertSize;
 
-		const float glyphStartX = x + glyph->bearing.x();
-
-		const Eigen::Vector2i& textureSize = glyph->texture->textureSize;
+		const float glyphStartX = x + glyph->bearing.x() - glyph->padding;
+		const float glyphTop = y - glyph->bearing.y() - glyph->padding;
 
 		// triangle 1
 		// round to fix some weird "cut off" text bugs
-		tri[0].pos << font_round(glyphStartX), font_round(y + (glyph->texSize.y() * textureSize.y() - glyph->bearing.y()));
-		tri[1].pos << font_round(glyphStartX + glyph->texSize.x() * textureSize.x()), font_round(y - glyph->bearing.y());
+		tri[0].pos << font_round(glyphStartX), font_round(glyphTop + glyph->size.y());
+		tri[1].pos << font_round(glyphStartX + glyph->size.x()), font_round(glyphTop);
 		tri[2].pos << tri[0].pos.x(), tri[1].pos.y();
 
 		//tri[0].tex << 0, 0;
@@ -817,29 +1345,111 @@ TextCache* Font::buildTextCache(const std::string& text, Eigen::Vector2f offset,
 		x += glyph->advance.x();
 	}
 
-	//TextCache::CacheMetrics metrics = { sizeText(text, lineSpacing) };
-
-	TextCache* cache = new TextCache();
-	cache->vertexLists.resize(vertMap.size());
-	cache->metrics = { sizeText(text, lineSpacing) };
+	std::shared_ptr< std::vector<TextCache::VertexList> > vertexLists = std::make_shared< std::vector<TextCache::VertexList> >(vertMap.size());
 
 	unsigned int i = 0;
-	for(auto it = vertMap.begin(); it != vertMap.end(); it++)
+	for(auto it = vertMap.begin(); it != vertMap.end(); it++, i++)
 	{
-		TextCache::VertexList& vertList = cache->vertexLists.at(i);
+		TextCache::VertexList& vertList = vertexLists->at(i);
 
 		vertList.textureIdPtr = &it->first->textureId;
-		vertList.verts = it->second;
+		vertList.distanceField = it->first->distanceField;
+		vertList.verts.swap(it->second);
+	}
 
-		vertList.colors.resize(4 * it->second.size());
-		Renderer::buildGLColorArray(vertList.colors.data(), color, it->second.size());
+	return vertexLists;
+}
+
+TextCache* Font::buildTextCache(const std::string& text, Eigen::Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
+{
+	TextCache* cache = new TextCache();
+
+	LayoutKey key = { this, text, offset, xLen, alignment, lineSpacing };
+	auto found = sLayoutCacheIndex.find(key);
+	if(found != sLayoutCacheIndex.end())
+	{
+		// move it to the front
+		sLayoutCache.splice(sLayoutCache.begin(), sLayoutCache, found->second);
+
+		cache->vertexLists = found->second->vertexLists;
+		cache->metrics.size = found->second->size;
+		sLayoutCacheStats.hits++;
+	}else{
+		cache->vertexLists = layoutText(text, offset, xLen, alignment, lineSpacing);
+		cache->metrics = { sizeText(text, lineSpacing) };
+		sLayoutCacheStats.misses++;
+
+		LayoutEntry entry;
+		entry.key = key;
+		entry.vertexLists = cache->vertexLists;
+		entry.size = cache->metrics.size;
+		entry.bytes = text.size();
+		for(auto it = cache->vertexLists->begin(); it != cache->vertexLists->end(); it++)
+			entry.bytes += it->verts.size() * sizeof(TextCache::Vertex);
+
+		// something that big would push everything else out
+		if(entry.bytes <= TEXT_LAYOUT_CACHE_SIZE / 8)
+		{
+			sLayoutCache.push_front(entry);
+			sLayoutCacheIndex[key] = sLayoutCache.begin();
+			sLayoutCacheStats.bytes += entry.bytes;
+
+			while(sLayoutCacheStats.bytes > TEXT_LAYOUT_CACHE_SIZE)
+			{
+				sLayoutCacheStats.bytes -= sLayoutCache.back().bytes;
+				sLayoutCacheIndex.erase(sLayoutCache.back().key);
+				sLayoutCache.pop_back();
+			}
+		}
 	}
 
-	clearFaceCache();
+	cache->colors.resize(cache->vertexLists->size());
+	cache->setColor(color);
 
 	return cache;
 }
 
+void Font::removeCachedLayouts()
+{
+	for(auto it = sLayoutCache.begin(); it != sLayoutCache.end(); )
+	{
+		if(it->key.font != this)
+		{
+			it++;
+			continue;
+		}
+
+		sLayoutCacheStats.bytes -= it->bytes;
+		sLayoutCacheIndex.erase(it->key);
+		it = sLayoutCache.erase(it);
+	}
+}
+
+Font::LayoutCacheStats Font::getLayoutCacheStats()
+{
+	LayoutCacheStats stats = sLayoutCacheStats;
+	stats.entries = sLayoutCache.size();
+	return stats;
+}
+
+bool Font::LayoutKey::operator==(const LayoutKey& other) const
+{
+	return font == other.font && xLen == other.xLen && alignment == other.alignment && lineSpacing == other.lineSpacing &&
+		offset == other.offset && text == other.text;
+}
+
+size_t Font::LayoutKeyHash::operator()(const LayoutKey& key) const
+{
+	size_t hash = std::hash<std::string>()(key.text);
+	hash ^= std::hash<const Font*>()(key.font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<float>()(key.xLen) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<float>()(key.offset.x()) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<float>()(key.offset.y()) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<float>()(key.lineSpacing) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= (size_t)key.alignment;
+	return hash;
+}
+
 TextCache* Font::buildTextCache(const std::string& text, float offsetX, float offsetY, unsigned int color)
 {
 	return buildTextCache(text, Eigen::Vector2f(offsetX, offsetY), color, 0.0f);
@@ -847,8 +1457,12 @@ TextCache* Font::buildTextCache(const std::string& text, float offsetX, float of
 
 void TextCache::setColor(unsigned int color)
 {
-	for(auto it = vertexLists.begin(); it != vertexLists.end(); it++)
-		Renderer::buildGLColorArray(it->colors.data(), color, it->verts.size());
+	for(unsigned int i = 0; i < vertexLists->size(); i++)
+	{
+		const size_t vertCount = vertexLists->at(i).verts.size();
+		colors.at(i).resize(4 * vertCount);
+		Renderer::buildGLColorArray(colors.at(i).data(), color, vertCount);
+	}
 }
 
 std::shared_ptr<Font> Font::getFromTheme(const ThemeData::ThemeElement* elem, unsigned int properties, const std::shared_ptr<Font>& orig)
@@ -1,15 +1,22 @@
 #pragma once
 
 #include <string>
+#include <list>
+#include <set>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include "platform.h"
 #include GLHEADER
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_SIZES_H
 #include <Eigen/Dense>
 #include "resources/ResourceManager.h"
 #include "ThemeData.h"
 
-class TextCache;
+class Font;
 
 #define FONT_SIZE_MINI ((unsigned int)(0.030f * std::min(Renderer::getScreenHeight(), Renderer::getScreenWidth())))
 #define FONT_SIZE_SMALL ((unsigned int)(0.035f * std::min(Renderer::getScreenHeight(), Renderer::getScreenWidth())))
@@ -28,6 +35,41 @@ enum Alignment
 	ALIGN_RIGHT
 };
 
+// Used to store a sort of "pre-rendered" string.
+// When a TextCache is constructed (Font::buildTextCache()), the vertices and texture coordinates of the string are calculated and stored in the TextCache object.
+// Rendering a previously constructed TextCache (Font::renderTextCache) every frame is MUCH faster than rebuilding one every frame.
+// Keep in mind you still need the Font object to render a TextCache (as the Font holds the OpenGL texture), and if a Font changes your TextCache may become invalid.
+class TextCache
+{
+protected:
+	struct Vertex
+	{
+		Eigen::Vector2f pos;
+		Eigen::Vector2f tex;
+	};
+
+	struct VertexList
+	{
+		GLuint* textureIdPtr; // this is a pointer because the texture ID can change during deinit/reinit (when launching a game)
+		bool distanceField; // the texture holds distance fields rather than coverage, see Font::GLYPHS_DISTANCE_FIELD
+		std::vector<Vertex> verts;
+	};
+
+	// shared with every other TextCache built from the same text and layout, only the colors are our own
+	std::shared_ptr< const std::vector<VertexList> > vertexLists;
+	std::vector< std::vector<GLubyte> > colors; // one array per vertex list
+
+public:
+	struct CacheMetrics
+	{
+		Eigen::Vector2f size;
+	} metrics;
+
+	void setColor(unsigned int color);
+
+	friend Font;
+};
+
 //A TrueType Font renderer that uses FreeType and OpenGL.
 //The library is automatically initialized when it's needed.
 class Font : public IReloadable
@@ -47,6 +89,7 @@ public:
 	std::string wrapText(std::string text, float xLen); // Inserts newlines into text to make it wrap properly.
 	Eigen::Vector2f sizeWrappedText(std::string text, float xLen, float lineSpacing = 1.5f); // Returns the expected size of a string after wrapping is applied.
 	Eigen::Vector2f getWrappedTextCursorOffset(std::string text, float xLen, size_t cursor, float lineSpacing = 1.5f); // Returns the position of of the cursor after moving "cursor" characters.
+	size_t getTextCutoff(const std::string& text, float xLen); // Returns the length in bytes of the longest start of a single line of text that fits in xLen.
 
 	float getHeight(float lineSpacing = 1.5f) const;
 	float getLetterHeight();
@@ -64,6 +107,27 @@ public:
 	size_t getMemUsage() const; // returns an approximation of VRAM used by this font's texture (in bytes)
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by font textures (in bytes)
 
+	struct LayoutCacheStats
+	{
+		unsigned int hits;
+		unsigned int misses;
+		unsigned int entries;
+		size_t bytes;
+	};
+
+	static LayoutCacheStats getLayoutCacheStats(); // for the text layouts buildTextCache reuses
+
+	// The characters the gamelists are known to need (e.g. from the game names). Fonts that draw
+	// them call warmGlyphs() to have them rasterized on the worker pool, so drawing them for the
+	// first time doesn't have to wait on FreeType. Other fonts never load them.
+	static void setWarmGlyphs(const std::set<UnicodeChar>& chars);
+	void warmGlyphs(); // also requests whatever later setWarmGlyphs() calls add
+	// Puts the glyphs the worker pool has finished into the font textures. Call once per frame.
+	static void uploadPendingGlyphs();
+
+	// Forget the font files that have been read, so they're read again if they were replaced
+	static void clearFaceCache();
+
 	// utf8 stuff
 	static size_t getNextCursor(const std::string& str, size_t cursor);
 	static size_t getPrevCursor(const std::string& str, size_t cursor);
@@ -71,10 +135,26 @@ public:
 	static UnicodeChar readUnicodeChar(const std::string& str, size_t& cursor); // reads unicode character at cursor AND moves cursor to the next valid unicode char
 
 private:
+	// How a font gets its glyphs.
+	enum GlyphMode
+	{
+		GLYPHS_BITMAP, // rendered by FreeType at this size into our own textures
+		GLYPHS_DISTANCE_FIELD_ATLAS, // signed distance fields at SDF_GLYPH_SIZE, shared by every size of the face
+		GLYPHS_DISTANCE_FIELD // mAtlas's glyphs scaled to this size, drawn with an alpha test
+	};
+
 	static FT_Library sLibrary;
+	static std::mutex sLibraryMutex; // faces are created on the worker pool too, and FT_Library isn't thread safe
 	static std::map< std::pair<std::string, int>, std::weak_ptr<Font> > sFontMap;
 
-	Font(int size, const std::string& path);
+	Font(int size, const std::string& path, GlyphMode mode = GLYPHS_BITMAP);
+
+	const GlyphMode mMode;
+	std::shared_ptr<Font> mAtlas; // only for GLYPHS_DISTANCE_FIELD
+
+	// with "FontDistanceField" set, Font::get() makes every size of a face use the same one of these
+	static std::map< std::string, std::weak_ptr<Font> > sDistanceFieldAtlases;
+	static std::shared_ptr<Font> getDistanceFieldAtlas(const std::string& path);
 
 	struct FontTexture
 	{
@@ -84,6 +164,8 @@ private:
 		Eigen::Vector2i writePos;
 		int rowHeight;
 
+		bool distanceField; // filtered linearly so the edges can be found between texels
+
 		FontTexture();
 		~FontTexture();
 		bool findEmpty(const Eigen::Vector2i& size, Eigen::Vector2i& cursor_out);
@@ -93,25 +175,67 @@ private:
 		void deinitTexture(); // deinitializes the OpenGL texture if any exists, is automatically called in the destructor
 	};
 
+	// One FT_Face per font file, shared by every Font and every size of it until the fonts are
+	// unloaded or the theme reloaded, so making a new size doesn't touch the disk. Each size has its
+	// own FT_Size that the face is switched to. FreeType faces can only be used by one thread at a
+	// time, hence the mutex. A glyph being rendered keeps its face alive if the cache is cleared.
 	struct FontFace
 	{
 		const ResourceData data;
-		FT_Face face;
+		FT_Face face; // NULL if the file couldn't be loaded
+		std::mutex mutex;
+		std::map<int, FT_Size> sizes;
 
-		FontFace(ResourceData&& d, int size);
-		virtual ~FontFace();
+		FontFace(const ResourceData& d);
+		~FontFace();
+
+		bool setSize(int size); // with mutex held
 	};
 
+	static std::map< std::string, std::shared_ptr<FontFace> > sFaces;
+	static std::mutex sFacesMutex;
+	static std::shared_ptr<FontFace> getFace(const std::string& path);
+
 	void rebuildTextures();
 	void unloadTextures();
 
-	std::vector<FontTexture> mTextures;
+	std::vector< std::unique_ptr<FontTexture> > mTextures; // glyphs point to these, so they can't move
 
 	void getTextureForNewGlyph(const Eigen::Vector2i& glyphSize, FontTexture*& tex_out, Eigen::Vector2i& cursor_out);
 
-	std::map< unsigned int, std::unique_ptr<FontFace> > mFaceCache;
-	FT_Face getFaceForChar(UnicodeChar id);
-	void clearFaceCache();
+	int getFaceSize() const; // distance fields are worked out from a larger rendering
+	// The first of path's face and the fallback fonts that has the glyph, or path's face if none do.
+	// Returned locked, NULL if path's face couldn't be loaded.
+	static std::shared_ptr<FontFace> lockFaceForChar(const std::string& path, UnicodeChar id, std::unique_lock<std::mutex>& lock_out);
+
+	// A glyph rendered by FreeType that isn't in a texture yet.
+	struct RasterizedGlyph
+	{
+		UnicodeChar id;
+		Eigen::Vector2i size;
+		std::vector<unsigned char> bitmap; // one byte per texel, rows aren't padded
+		int padding; // empty texels around each side, for distance fields to fade out in
+		Eigen::Vector2f advance;
+		Eigen::Vector2f bearing;
+	};
+
+	static bool rasterizeGlyph(const std::string& path, int size, UnicodeChar id, bool distanceField, RasterizedGlyph& glyph_out);
+
+	// Filled by the worker pool and emptied by uploadPendingGlyphs(). The work items hold on to it
+	// too, so it doesn't matter if the font goes away before they finish.
+	struct PendingGlyphs
+	{
+		std::mutex mutex;
+		std::vector<RasterizedGlyph> glyphs;
+	};
+
+	std::shared_ptr<PendingGlyphs> mPendingGlyphs;
+	std::set<UnicodeChar> mRequestedGlyphs; // already sent to the worker pool
+	static std::set<UnicodeChar> sWarmGlyphs;
+	bool mWarm; // warmGlyphs() was called
+
+	void requestGlyphs(const std::set<UnicodeChar>& chars);
+	void addPendingGlyphs();
 
 	struct Glyph
 	{
@@ -120,6 +244,9 @@ private:
 		Eigen::Vector2f texPos;
 		Eigen::Vector2f texSize; // in texels!
 
+		Eigen::Vector2f size; // on screen, padding included
+		float padding;
+
 		Eigen::Vector2f advance;
 		Eigen::Vector2f bearing;
 	};
@@ -127,6 +254,7 @@ private:
 	std::map<UnicodeChar, Glyph> mGlyphMap;
 
 	Glyph* getGlyph(UnicodeChar id);
+	Glyph* addGlyph(const RasterizedGlyph& raster, Eigen::Vector2i& cursor_out); // finds it a place in a texture, but doesn't upload it
 
 	int mMaxGlyphHeight;
 	
@@ -135,38 +263,59 @@ private:
 
 	float getNewlineStartOffset(const std::string& text, const unsigned int& charStart, const float& xLen, const Alignment& alignment);
 
-	friend TextCache;
-};
+	// Adds the width of text[start, end) to a running measurement, the same way sizeText does.
+	void measureText(const std::string& text, size_t start, size_t end, float& highestWidth, float& lineWidth);
 
-// Used to store a sort of "pre-rendered" string.
-// When a TextCache is constructed (Font::buildTextCache()), the vertices and texture coordinates of the string are calculated and stored in the TextCache object.
-// Rendering a previously constructed TextCache (Font::renderTextCache) every frame is MUCH faster than rebuilding one every frame.
-// Keep in mind you still need the Font object to render a TextCache (as the Font holds the OpenGL texture), and if a Font changes your TextCache may become invalid.
-class TextCache
-{
-protected:
-	struct Vertex
+	// The last text wrapText laid out. wrapText, sizeWrappedText and getWrappedTextCursorOffset
+	// are usually called one after the other with the same text, so they share it.
+	struct WrappedLayout
 	{
-		Eigen::Vector2f pos;
-		Eigen::Vector2f tex;
+		WrappedLayout() : xLen(-1), width(0), lineCount(0) {}
+
+		std::string text;
+		float xLen;
+
+		std::string wrapped;
+		float width;
+		unsigned int lineCount;
 	};
 
-	struct VertexList
+	WrappedLayout mLastWrap;
+	const WrappedLayout& getWrappedLayout(const std::string& text, float xLen);
+
+	// Vertex lists built by buildTextCache, most recently used first. Shared by every font so
+	// they all fit in one budget, and only the colors are rebuilt when a layout is reused.
+	struct LayoutKey
 	{
-		GLuint* textureIdPtr; // this is a pointer because the texture ID can change during deinit/reinit (when launching a game)
-		std::vector<Vertex> verts;
-		std::vector<GLubyte> colors;
+		const Font* font;
+		std::string text;
+		Eigen::Vector2f offset;
+		float xLen;
+		Alignment alignment;
+		float lineSpacing;
+
+		bool operator==(const LayoutKey& other) const;
 	};
 
-	std::vector<VertexList> vertexLists;
+	struct LayoutKeyHash
+	{
+		size_t operator()(const LayoutKey& key) const;
+	};
 
-public:
-	struct CacheMetrics
+	struct LayoutEntry
 	{
+		LayoutKey key;
+		std::shared_ptr< const std::vector<TextCache::VertexList> > vertexLists;
 		Eigen::Vector2f size;
-	} metrics;
+		size_t bytes;
+	};
 
-	void setColor(unsigned int color);
+	static std::list<LayoutEntry> sLayoutCache;
+	static std::unordered_map<LayoutKey, std::list<LayoutEntry>::iterator, LayoutKeyHash> sLayoutCacheIndex;
+	static LayoutCacheStats sLayoutCacheStats;
 
-	friend Font;
+	std::shared_ptr< const std::vector<TextCache::VertexList> > layoutText(const std::string& text, Eigen::Vector2f offset, float xLen, Alignment alignment, float lineSpacing);
+	void removeCachedLayouts();
+
+	friend TextCache;
 };
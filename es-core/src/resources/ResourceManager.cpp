@@ -1,9 +1,19 @@
 #include "ResourceManager.h"
 #include "Log.h"
+#include "resources/SVGCache.h"
 #include "../data/Resources.h"
 #include <fstream>
+#include <algorithm>
 #include <boost/filesystem.hpp>
 
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
 namespace fs = boost::filesystem;
 
 auto array_deleter = [](unsigned char* p) { delete[] p; };
@@ -11,7 +21,7 @@ auto nop_deleter = [](unsigned char* p) { };
 
 std::shared_ptr<ResourceManager> ResourceManager::sInstance = nullptr;
 
-ResourceManager::ResourceManager()
+ResourceManager::ResourceManager() : mSweepSize(64)
 {
 }
 
@@ -23,14 +33,14 @@ std::shared_ptr<ResourceManager>& ResourceManager::getInstance()
 	return sInstance;
 }
 
-const ResourceData ResourceManager::getFileData(const std::string& path) const
+const ResourceData ResourceManager::getFileData(const std::string& path, ResourceAccess access) const
 {
 	//check if its embedded
-	
-	if(res2hMap.find(path) != res2hMap.end())
+	auto embedded = res2hMap.find(path);
+	if(embedded != res2hMap.end())
 	{
 		//it is
-		Res2hEntry embeddedEntry = res2hMap.find(path)->second;
+		const Res2hEntry& embeddedEntry = embedded->second;
 		ResourceData data = { 
 			std::shared_ptr<unsigned char>(const_cast<unsigned char*>(embeddedEntry.data), nop_deleter), 
 			embeddedEntry.size
@@ -38,19 +48,112 @@ const ResourceData ResourceManager::getFileData(const std::string& path) const
 		return data;
 	}
 
-	//it's not embedded; load the file
+	//it's not embedded; load the file, an "empty" ResourceData if it doesn't exist
+	return loadFile(path, access);
+}
+
+ResourceData ResourceManager::loadFile(const std::string& path, ResourceAccess access) const
+{
+#ifdef WIN32
 	if(!fs::exists(path))
 	{
-		//if the file doesn't exist, return an "empty" ResourceData
 		ResourceData data = {NULL, 0};
 		return data;
-	}else{
-		ResourceData data = loadFile(path);
+	}
+
+	return readFile(path);
+#else
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		ResourceData data = {NULL, 0};
 		return data;
 	}
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+	{
+		close(fd);
+		ResourceData data = {NULL, 0};
+		return data;
+	}
+
+	const size_t size = (size_t)info.st_size;
+
+	//a mapped file that's truncated or rewritten in place (a scraped image being downloaded again,
+	//say) crashes whoever reads past its new end, so only fonts are mapped; they're in the install
+	//or theme folders, and are the ones that only page in the little that's used
+	if(access != RESOURCE_READ_RANDOM)
+	{
+		std::shared_ptr<unsigned char> data(new unsigned char[size], array_deleter);
+		size_t length = 0;
+		while(length < size)
+		{
+			const ssize_t count = read(fd, data.get() + length, size - length);
+			if(count < 0 && errno == EINTR)
+				continue;
+			if(count <= 0)
+				break; //shrunk since the fstat(), keep what's there
+			length += (size_t)count;
+		}
+		close(fd);
+
+		ResourceData ret = {length > 0 ? data : NULL, length};
+		return ret;
+	}
+
+	//held while mapping too, so two threads loading the same file don't both map it
+	std::unique_lock<std::mutex> lock(mMappingsMutex);
+
+	auto it = mMappings.find(path);
+	if(it != mMappings.end() && it->second.length == size && it->second.modified == info.st_mtime && it->second.inode == (unsigned long)info.st_ino)
+	{
+		std::shared_ptr<unsigned char> shared = it->second.data.lock();
+		if(shared)
+		{
+			close(fd);
+			ResourceData data = {shared, size};
+			return data;
+		}
+	}
+
+	void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED)
+	{
+		//some file systems can't be mapped
+		lock.unlock();
+		return readFile(path);
+	}
+
+	madvise(mapped, size, MADV_RANDOM);
+
+	std::shared_ptr<unsigned char> data((unsigned char*)mapped, [size](unsigned char* p) { munmap(p, size); });
+	Mapping& mapping = mMappings[path];
+	mapping.data = data;
+	mapping.length = size;
+	mapping.modified = info.st_mtime;
+	mapping.inode = (unsigned long)info.st_ino;
+
+	//drop the ones nobody's using anymore now and then
+	if(mMappings.size() >= mSweepSize)
+	{
+		for(auto entry = mMappings.begin(); entry != mMappings.end(); )
+		{
+			if(entry->second.data.expired())
+				entry = mMappings.erase(entry);
+			else
+				entry++;
+		}
+		mSweepSize = std::max((size_t)64, mMappings.size() * 2);
+	}
+
+	ResourceData ret = {data, size};
+	return ret;
+#endif
 }
 
-ResourceData ResourceManager::loadFile(const std::string& path) const
+ResourceData ResourceManager::readFile(const std::string& path) const
 {
 	std::ifstream stream(path, std::ios::binary);
 
@@ -78,6 +181,9 @@ bool ResourceManager::fileExists(const std::string& path) const
 
 void ResourceManager::unloadAll()
 {
+	// the files may well change while we're unloaded (e.g. a game run), and it frees the memory
+	SVGCache::clear();
+
 	auto iter = mReloadables.begin();
 	while(iter != mReloadables.end())
 	{
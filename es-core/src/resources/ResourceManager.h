@@ -4,17 +4,29 @@
 #include <memory>
 #include <map>
 #include <list>
+#include <mutex>
+#include <ctime>
 
 //The ResourceManager exists to...
 //Allow loading resources embedded into the executable like an actual file.
 //Allow embedded resources to be optionally remapped to actual files for further customization.
 
+//Fonts on disk are mapped rather than read, so the data is read-only and only paged in as it's used.
+//Everyone loading the same font while it's mapped shares the mapping. Other files are read, as they
+//may be user media that's rewritten while we're using it.
 struct ResourceData
 {
 	const std::shared_ptr<unsigned char> ptr;
 	const size_t length;
 };
 
+//How a file is going to be read, so the OS knows what to page in ahead of time.
+enum ResourceAccess
+{
+	RESOURCE_READ_ALL, //start to end right away, like an image being decoded
+	RESOURCE_READ_RANDOM //bits of it whenever they're needed, like a font's glyphs; mapped, so not for files that can change
+};
+
 class ResourceManager;
 
 class IReloadable
@@ -34,7 +46,8 @@ public:
 	void unloadAll();
 	void reloadAll();
 
-	const ResourceData getFileData(const std::string& path) const;
+	//Thread safe.
+	const ResourceData getFileData(const std::string& path, ResourceAccess access = RESOURCE_READ_ALL) const;
 	bool fileExists(const std::string& path) const;
 
 private:
@@ -42,7 +55,21 @@ private:
 
 	static std::shared_ptr<ResourceManager> sInstance;
 
-	ResourceData loadFile(const std::string& path) const;
+	ResourceData loadFile(const std::string& path, ResourceAccess access) const;
+	ResourceData readFile(const std::string& path) const;
+
+	//files that are mapped right now, the entry is only used while the file is unchanged
+	struct Mapping
+	{
+		std::weak_ptr<unsigned char> data;
+		size_t length;
+		std::time_t modified;
+		unsigned long inode;
+	};
+
+	mutable std::mutex mMappingsMutex;
+	mutable std::map<std::string, Mapping> mMappings;
+	mutable size_t mSweepSize; //expired entries are dropped when there are this many
 
 	std::list< std::weak_ptr<IReloadable> > mReloadables;
 };
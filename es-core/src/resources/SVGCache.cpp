@@ -0,0 +1,102 @@
+#include "resources/SVGCache.h"
+#include "resources/ResourceManager.h"
+#include "ImageIO.h"
+#include "Log.h"
+#include "nanosvg/nanosvg.h"
+#include "nanosvg/nanosvgrast.h"
+#include <string.h>
+
+#define DPI 96
+
+std::mutex SVGCache::sMutex;
+std::map< std::string, std::shared_ptr<NSVGimage> > SVGCache::sImages;
+SVGCache::RasterList SVGCache::sRasters;
+std::map<SVGCache::RasterKey, SVGCache::RasterList::iterator> SVGCache::sRasterLookup;
+size_t SVGCache::sRasterBytes = 0;
+
+std::shared_ptr<NSVGimage> SVGCache::getImage(const std::string& path)
+{
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		auto it = sImages.find(path);
+		if(it != sImages.end())
+			return it->second;
+	}
+
+	// Parse outside the lock. If two threads race on the same file the second result is thrown away
+	const ResourceData data = ResourceManager::getInstance()->getFileData(path);
+	if(!data.ptr || data.length == 0)
+		return nullptr;
+
+	// nsvgParse expects a modifiable, null-terminated string
+	std::vector<char> copy(data.length + 1);
+	memcpy(copy.data(), data.ptr.get(), data.length);
+	copy[data.length] = '\0';
+
+	NSVGimage* parsed = nsvgParse(copy.data(), "px", DPI);
+	if(!parsed)
+	{
+		LOG(LogError) << "Error parsing SVG image \"" << path << "\".";
+		return nullptr;
+	}
+
+	std::shared_ptr<NSVGimage> image(parsed, nsvgDelete);
+
+	std::unique_lock<std::mutex> lock(sMutex);
+	auto it = sImages.find(path);
+	if(it != sImages.end())
+		return it->second;
+	sImages[path] = image;
+	return image;
+}
+
+std::shared_ptr<const SVGCache::Pixels> SVGCache::getRaster(const std::string& path, const std::shared_ptr<NSVGimage>& image, size_t width, size_t height)
+{
+	RasterKey key = { path, width, height };
+
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		auto it = sRasterLookup.find(key);
+		if(it != sRasterLookup.end())
+		{
+			// move it to the front of the LRU
+			sRasters.splice(sRasters.begin(), sRasters, it->second);
+			return it->second->second;
+		}
+	}
+
+	std::shared_ptr<Pixels> pixels = std::make_shared<Pixels>(width * height * 4);
+
+	NSVGrasterizer* rast = nsvgCreateRasterizer();
+	nsvgRasterize(rast, image.get(), 0, 0, height / image->height, pixels->data(), (int)width, (int)height, (int)width * 4);
+	nsvgDeleteRasterizer(rast);
+
+	ImageIO::flipPixelsVert(pixels->data(), width, height);
+
+	std::unique_lock<std::mutex> lock(sMutex);
+	if(sRasterLookup.find(key) == sRasterLookup.end() && pixels->size() <= SVG_RASTER_CACHE_SIZE)
+	{
+		sRasters.push_front(std::make_pair(key, std::shared_ptr<const Pixels>(pixels)));
+		sRasterLookup[key] = sRasters.begin();
+		sRasterBytes += pixels->size();
+
+		// drop the least recently used rasters until we're back under budget
+		while(sRasterBytes > SVG_RASTER_CACHE_SIZE)
+		{
+			sRasterBytes -= sRasters.back().second->size();
+			sRasterLookup.erase(sRasters.back().first);
+			sRasters.pop_back();
+		}
+	}
+
+	return pixels;
+}
+
+void SVGCache::clear()
+{
+	std::unique_lock<std::mutex> lock(sMutex);
+	sImages.clear();
+	sRasters.clear();
+	sRasterLookup.clear();
+	sRasterBytes = 0;
+}
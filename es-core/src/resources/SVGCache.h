@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+
+struct NSVGimage;
+
+// Maximum number of bytes of rasterized SVG data kept around for reuse
+#define SVG_RASTER_CACHE_SIZE (32 * 1024 * 1024)
+
+// Caches for SVG textures, shared by every TextureData and safe to use from the loader thread.
+//
+// Parsed images are kept per path until clear() (theme reloads and ResourceManager::unloadAll()),
+// so an SVG file is only read and parsed once no matter how many sizes it is displayed at.
+// Rasterized pixels are kept per (path, width, height) in a size-limited LRU so that e.g. the
+// normal and selected carousel logos don't rasterize the same thing twice.
+class SVGCache
+{
+public:
+	typedef std::vector<unsigned char> Pixels;
+
+	// Returns the parsed image for path, or nullptr if it could not be loaded
+	static std::shared_ptr<NSVGimage> getImage(const std::string& path);
+
+	// Returns RGBA pixels (already flipped for OpenGL) for path rasterized at width x height
+	static std::shared_ptr<const Pixels> getRaster(const std::string& path, const std::shared_ptr<NSVGimage>& image, size_t width, size_t height);
+
+	// Forget everything (e.g. when the files on disk may have changed)
+	static void clear();
+
+private:
+	struct RasterKey
+	{
+		std::string path;
+		size_t width;
+		size_t height;
+
+		bool operator<(const RasterKey& other) const
+		{
+			if(path != other.path)
+				return path < other.path;
+			if(width != other.width)
+				return width < other.width;
+			return height < other.height;
+		}
+	};
+
+	typedef std::list< std::pair<RasterKey, std::shared_ptr<const Pixels> > > RasterList;
+
+	static std::mutex sMutex;
+	static std::map< std::string, std::shared_ptr<NSVGimage> > sImages;
+	static RasterList sRasters; // most recently used first
+	static std::map<RasterKey, RasterList::iterator> sRasterLookup;
+	static size_t sRasterBytes;
+};
@@ -1,15 +1,13 @@
 #include "resources/TextureData.h"
 #include "resources/ResourceManager.h"
+#include "resources/SVGCache.h"
 #include "Log.h"
 #include "ImageIO.h"
 #include "string.h"
 #include "Util.h"
 #include "nanosvg/nanosvg.h"
-#include "nanosvg/nanosvgrast.h"
 #include <vector>
 
-#define DPI 96
-
 TextureData::TextureData(bool tile) : mTile(tile), mTextureID(0), mDataRGBA(nullptr), mScalable(false),
 									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f)
 {
@@ -27,62 +25,92 @@ void TextureData::initFromPath(const std::string& path)
 	mPath = path;
 	// Only textures with paths are reloadable
 	mReloadable = true;
+	// SVGs are rasterized at whatever size they are displayed at
+	mScalable = (path.size() > 4) && (path.substr(path.size() - 4, std::string::npos) == ".svg");
 }
 
-bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length)
+// Work out the size to rasterize an SVG at. Either dimension of the source size may be 0,
+// in which case it is set from the other one keeping the image's aspect ratio
+static void getSVGRasterSize(const NSVGimage* svgImage, float sourceWidth, float sourceHeight, size_t& width, size_t& height)
 {
-	// If already initialised then don't read again
-	{
-		std::unique_lock<std::mutex> lock(mMutex);
-		if (mDataRGBA)
-			return true;
-	}
+	width = (size_t)round(sourceWidth);
+	height = (size_t)round(sourceHeight);
 
-	// nsvgParse excepts a modifiable, null-terminated string
-	char* copy = (char*)malloc(length + 1);
-	assert(copy != NULL);
-	memcpy(copy, fileData, length);
-	copy[length] = '\0';
+	if (width == 0)
+		width = (size_t)round(((float)height / svgImage->height) * svgImage->width);
+	else if (height == 0)
+		height = (size_t)round(((float)width / svgImage->width) * svgImage->height);
+}
 
-	NSVGimage* svgImage = nsvgParse(copy, "px", DPI);
-	free(copy);
+bool TextureData::initSVGSize()
+{
+	std::shared_ptr<NSVGimage> svgImage = SVGCache::getImage(mPath);
 	if (!svgImage)
-	{
-		LOG(LogError) << "Error parsing SVG image.";
 		return false;
-	}
 
-	// We want to rasterise this texture at a specific resolution. If the source size
-	// variables are set then use them otherwise set them from the parsed file
+	std::unique_lock<std::mutex> lock(mMutex);
 	if ((mSourceWidth == 0.0f) && (mSourceHeight == 0.0f))
 	{
 		mSourceWidth = svgImage->width;
 		mSourceHeight = svgImage->height;
 	}
-	mWidth = (size_t)round(mSourceWidth);
-	mHeight = (size_t)round(mSourceHeight);
+	getSVGRasterSize(svgImage.get(), mSourceWidth, mSourceHeight, mWidth, mHeight);
+	return true;
+}
 
-	if (mWidth == 0)
+bool TextureData::initSVGFromCache()
+{
+	float sourceWidth, sourceHeight;
 	{
-		// auto scale width to keep aspect
-		mWidth = (size_t)round(((float)mHeight / svgImage->height) * svgImage->width);
+		// If already initialised then don't read again
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA)
+			return true;
+		sourceWidth = mSourceWidth;
+		sourceHeight = mSourceHeight;
 	}
-	else if (mHeight == 0)
+
+	std::shared_ptr<NSVGimage> svgImage = SVGCache::getImage(mPath);
+	if (!svgImage)
 	{
-		// auto scale height to keep aspect
-		mHeight = (size_t)round(((float)mWidth / svgImage->width) * svgImage->height);
+		LOG(LogError) << "Could not load SVG image \"" << mPath << "\".";
+		return false;
 	}
 
-	unsigned char* dataRGBA = new unsigned char[mWidth * mHeight * 4];
+	// No size asked for yet, use the natural size of the image
+	if ((sourceWidth == 0.0f) && (sourceHeight == 0.0f))
+	{
+		sourceWidth = svgImage->width;
+		sourceHeight = svgImage->height;
+	}
 
-	NSVGrasterizer* rast = nsvgCreateRasterizer();
-	nsvgRasterize(rast, svgImage, 0, 0, mHeight / svgImage->height, dataRGBA, mWidth, mHeight, mWidth * 4);
-	nsvgDeleteRasterizer(rast);
+	size_t width, height;
+	getSVGRasterSize(svgImage.get(), sourceWidth, sourceHeight, width, height);
+	if ((width == 0) || (height == 0))
+		return false;
 
-	ImageIO::flipPixelsVert(dataRGBA, mWidth, mHeight);
+	std::shared_ptr<const SVGCache::Pixels> pixels = SVGCache::getRaster(mPath, svgImage, width, height);
 
 	std::unique_lock<std::mutex> lock(mMutex);
-	mDataRGBA = dataRGBA;
+	if (mDataRGBA)
+		return true;
+
+	if ((mSourceWidth == 0.0f) && (mSourceHeight == 0.0f))
+	{
+		mSourceWidth = sourceWidth;
+		mSourceHeight = sourceHeight;
+	}
+	else if ((mSourceWidth != sourceWidth) || (mSourceHeight != sourceHeight))
+	{
+		// setSourceSize() was called while we were rasterizing so this is already out of date.
+		// The next bind() queues it again at the new size
+		return false;
+	}
+
+	mWidth = width;
+	mHeight = height;
+	mDataRGBA = new unsigned char[pixels->size()];
+	memcpy(mDataRGBA, pixels->data(), pixels->size());
 
 	return true;
 }
@@ -134,16 +162,13 @@ bool TextureData::load()
 	// Need to load. See if there is a file
 	if (!mPath.empty())
 	{
+		// SVGs are parsed once and rasterized through the shared cache
+		if (mScalable)
+			return initSVGFromCache();
+
 		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 		const ResourceData& data = rm->getFileData(mPath);
-		// is it an SVG?
-		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
-		{
-			mScalable = true;
-			retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
-		}
-		else
-			retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
+		retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
 	}
 	return retval;
 }
@@ -211,28 +236,49 @@ void TextureData::releaseRAM()
 size_t TextureData::width()
 {
 	if (mWidth == 0)
-		load();
+	{
+		// SVG sizes only need the parsed image, not a rasterized one
+		if (mScalable)
+			initSVGSize();
+		else
+			load();
+	}
 	return mWidth;
 }
 
 size_t TextureData::height()
 {
 	if (mHeight == 0)
-		load();
+	{
+		if (mScalable)
+			initSVGSize();
+		else
+			load();
+	}
 	return mHeight;
 }
 
 float TextureData::sourceWidth()
 {
 	if (mSourceWidth == 0)
-		load();
+	{
+		if (mScalable)
+			initSVGSize();
+		else
+			load();
+	}
 	return mSourceWidth;
 }
 
 float TextureData::sourceHeight()
 {
 	if (mSourceHeight == 0)
-		load();
+	{
+		if (mScalable)
+			initSVGSize();
+		else
+			load();
+	}
 	return mSourceHeight;
 }
 
@@ -240,13 +286,17 @@ void TextureData::setSourceSize(float width, float height)
 {
 	if (mScalable)
 	{
-		if ((mSourceWidth != width) || (mSourceHeight != height))
 		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			if ((mSourceWidth == width) && (mSourceHeight == height))
+				return;
 			mSourceWidth = width;
 			mSourceHeight = height;
-			releaseVRAM();
-			releaseRAM();
 		}
+		releaseVRAM();
+		releaseRAM();
+		// Keep the pixel size up to date for the memory accounting. The parse is cached so this is cheap
+		initSVGSize();
 	}
 }
 
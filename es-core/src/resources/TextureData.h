@@ -18,7 +18,6 @@ public:
 
 	//!!!! Needs to be canonical path. Caller should check for duplicates before calling this
 	void initFromPath(const std::string& path);
-	bool initSVGFromMemory(const unsigned char* fileData, size_t length);
 	bool initImageFromMemory(const unsigned char* fileData, size_t length);
 	bool initFromRGBA(const unsigned char* dataRGBA, size_t width, size_t height);
 
@@ -39,6 +38,9 @@ public:
 
 	// Get the amount of VRAM currenty used by this texture
 	size_t getVRAMUsage();
+	// Get the amount of VRAM this texture will use once loaded, without loading it. This is
+	// 0 if it has never been loaded
+	size_t getPendingVRAMUsage() { return mWidth * mHeight * 4; }
 
 	size_t width();
 	size_t height();
@@ -47,8 +49,15 @@ public:
 	void setSourceSize(float width, float height);
 
 	bool tiled() { return mTile; }
+	// True for SVGs, which are rasterized at the size passed to setSourceSize()
+	bool isScalable() { return mScalable; }
 
 private:
+	// Fill in the sizes of an SVG from its (cached) parsed image without rasterizing it
+	bool initSVGSize();
+	// Rasterize an SVG at the current source size, going through SVGCache
+	bool initSVGFromCache();
+
 	std::mutex		mMutex;
 	bool			mTile;
 	std::string		mPath;
@@ -1,6 +1,9 @@
 #include "resources/TextureDataManager.h"
 #include "resources/TextureResource.h"
 #include "Settings.h"
+#include <SDL.h>
+#include <string.h>
+#include <iterator>
 
 TextureDataManager::TextureDataManager()
 {
@@ -37,6 +40,8 @@ void TextureDataManager::remove(const TextureResource* key)
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.end())
 	{
+		// Nobody wants it any more so don't waste the loader's time on it
+		mLoader->remove(*(*it).second);
 		// Remove the list entry
 		mTextures.erase((*it).second);
 		// And the lookup
@@ -66,9 +71,21 @@ std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key)
 	return tex;
 }
 
+bool TextureDataManager::isLoaded(const TextureResource* key)
+{
+	auto it = mTextureLookup.find(key);
+	if (it == mTextureLookup.end())
+		return false;
+	return (*(*it).second)->isLoaded();
+}
+
 bool TextureDataManager::bind(const TextureResource* key)
 {
-	std::shared_ptr<TextureData> tex = get(key);
+	return bind(get(key));
+}
+
+bool TextureDataManager::bind(std::shared_ptr<TextureData> tex)
+{
 	bool bound = false;
 	if (tex != nullptr)
 		bound = tex->uploadAndBind();
@@ -98,17 +115,30 @@ size_t TextureDataManager::getQueueSize()
 	return mLoader->getQueueSize();
 }
 
-void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
+std::shared_ptr<TextureLoadHandle> TextureDataManager::request(const TextureResource* key, TexturePriority priority)
 {
-	// See if it's already loaded
+	auto it = mTextureLookup.find(key);
+	if (it == mTextureLookup.end())
+		return nullptr;
+
+	std::shared_ptr<TextureData> tex = *(*it).second;
 	if (tex->isLoaded())
-		return;
-	// Not loaded. Make sure there is room
+		return nullptr;
+
+	makeRoom();
+	return mLoader->request(tex, priority);
+}
+
+TextureLoaderStats TextureDataManager::getLoaderStats()
+{
+	return mLoader->getStats();
+}
+
+void TextureDataManager::makeRoom()
+{
 	size_t size = TextureResource::getTotalMemUsage();
 	size_t max_texture = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
 
-	size_t in = size;
-
 	for (auto it = mTextures.rbegin(); it != mTextures.rend(); ++it)
 	{
 		if (size < max_texture)
@@ -121,25 +151,57 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 		mLoader->remove(*it);
 		size = TextureResource::getTotalMemUsage();
 	}
+}
+
+void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block, TexturePriority priority)
+{
+	// See if it's already loaded
+	if (tex->isLoaded())
+		return;
+	// Not loaded. Make sure there is room
+	makeRoom();
 	if (!block)
-		mLoader->load(tex);
+		mLoader->load(tex, priority);
 	else
 		tex->load();
 }
 
-TextureLoader::TextureLoader() : mExit(false)
+TextureLoadHandle::TextureLoadHandle(TextureLoader* loader, TextureData* key, unsigned int requestId) :
+	mLoader(loader), mKey(key), mRequestId(requestId), mCancelled(false)
+{
+}
+
+TextureLoadHandle::~TextureLoadHandle()
+{
+	cancel();
+}
+
+void TextureLoadHandle::cancel()
 {
+	if (mCancelled)
+		return;
+	mCancelled = true;
+	mLoader->cancel(mKey, mRequestId);
+}
+
+TextureLoader::TextureLoader() : mNextRequestId(1), mExit(false)
+{
+	memset(&mStats, 0, sizeof(mStats));
 	mThread = new std::thread(&TextureLoader::threadProc, this);
 }
 
 TextureLoader::~TextureLoader()
 {
 	// Just abort any waiting texture
-	mTextureDataQ.clear();
-	mTextureDataLookup.clear();
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (int i = 0; i < TEXTURE_PRIORITY_COUNT; ++i)
+			mTextureDataQ[i].clear();
+		mTextureDataLookup.clear();
 
-	// Exit the thread
-	mExit = true;
+		// Exit the thread
+		mExit = true;
+	}
 	mEvent.notify_one();
 	mThread->join();
 	delete mThread;
@@ -147,69 +209,140 @@ TextureLoader::~TextureLoader()
 
 void TextureLoader::threadProc()
 {
-	while (!mExit)
+	while (true)
 	{
 		std::shared_ptr<TextureData> textureData;
 		{
 			// Wait for an event to say there is something in the queue
 			std::unique_lock<std::mutex> lock(mMutex);
-			mEvent.wait(lock);
-			if (!mTextureDataQ.empty())
-			{
-				textureData = mTextureDataQ.front();
-				mTextureDataQ.pop_front();
-				mTextureDataLookup.erase(mTextureDataLookup.find(textureData.get()));
-			}
+			mEvent.wait(lock, [this] { return mExit || !mTextureDataLookup.empty(); });
+			if (mExit)
+				return;
+			textureData = popNext();
 		}
-		// Queue has been released here but we might have a texture to process
-		while (textureData)
-		{
+		// Queue has been released here so we can do the slow bit
+		if (textureData)
 			textureData->load();
+	}
+}
 
-			// See if there is another item in the queue
-			textureData = nullptr;
-			std::unique_lock<std::mutex> lock(mMutex);
-			if (!mTextureDataQ.empty())
-			{
-				textureData = mTextureDataQ.front();
-				mTextureDataQ.pop_front();
-				mTextureDataLookup.erase(mTextureDataLookup.find(textureData.get()));
-			}
+TextureLoader::RequestQueue::iterator TextureLoader::enqueue(std::shared_ptr<TextureData> textureData, TexturePriority priority)
+{
+	auto td = mTextureDataLookup.find(textureData.get());
+	if (td != mTextureDataLookup.end())
+	{
+		// Already queued. Leave it where it is unless it has been asked for at a higher
+		// priority, in which case it goes to the front of that queue
+		RequestQueue::iterator req = (*td).second;
+		if (priority < req->priority)
+		{
+			mTextureDataQ[priority].splice(mTextureDataQ[priority].begin(), mTextureDataQ[req->priority], req);
+			req->priority = priority;
+			req->queuedAt = SDL_GetTicks();
 		}
+		return req;
 	}
+
+	// Put it on the start of the queue as we want the newly requested textures to load first
+	Request req;
+	req.data = textureData;
+	req.priority = priority;
+	req.queuedAt = SDL_GetTicks();
+	req.id = mNextRequestId++;
+	req.claims = 0;
+	mTextureDataQ[priority].push_front(req);
+	mTextureDataLookup[textureData.get()] = mTextureDataQ[priority].begin();
+	return mTextureDataQ[priority].begin();
 }
 
-void TextureLoader::load(std::shared_ptr<TextureData> textureData)
+void TextureLoader::promoteAged()
 {
-	// Make sure it's not already loaded
-	if (!textureData->isLoaded())
+	// The oldest request in each queue is at the back. Anything that has waited too long
+	// jumps to the front of the queue above so it can't be starved forever
+	const unsigned int now = SDL_GetTicks();
+	for (int i = 1; i < TEXTURE_PRIORITY_COUNT; ++i)
 	{
-		std::unique_lock<std::mutex> lock(mMutex);
-		// Remove it from the queue if it is already there
-		auto td = mTextureDataLookup.find(textureData.get());
-		if (td != mTextureDataLookup.end())
+		RequestQueue& queue = mTextureDataQ[i];
+		while (!queue.empty() && (now - queue.back().queuedAt) >= TEXTURE_AGING_TIME)
 		{
-			mTextureDataQ.erase((*td).second);
-			mTextureDataLookup.erase(td);
+			RequestQueue::iterator req = std::prev(queue.end());
+			mTextureDataQ[i - 1].splice(mTextureDataQ[i - 1].begin(), queue, req);
+			req->priority = (TexturePriority)(i - 1);
+			req->queuedAt = now;
+			mStats.promoted[i - 1]++;
 		}
+	}
+}
 
-		// Put it on the start of the queue as we want the newly requested textures to load first
-		mTextureDataQ.push_front(textureData);
-		mTextureDataLookup[textureData.get()] = mTextureDataQ.begin();
+std::shared_ptr<TextureData> TextureLoader::popNext()
+{
+	promoteAged();
+
+	for (int i = 0; i < TEXTURE_PRIORITY_COUNT; ++i)
+	{
+		if (mTextureDataQ[i].empty())
+			continue;
+
+		std::shared_ptr<TextureData> textureData = mTextureDataQ[i].front().data;
+		mTextureDataQ[i].pop_front();
+		mTextureDataLookup.erase(textureData.get());
+		mStats.loaded[i]++;
+		return textureData;
+	}
+	return nullptr;
+}
+
+void TextureLoader::erase(std::map<TextureData*, RequestQueue::iterator>::iterator lookup)
+{
+	RequestQueue::iterator req = (*lookup).second;
+	mStats.cancelled[req->priority]++;
+	mTextureDataQ[req->priority].erase(req);
+	mTextureDataLookup.erase(lookup);
+}
+
+void TextureLoader::load(std::shared_ptr<TextureData> textureData, TexturePriority priority)
+{
+	// Make sure it's not already loaded
+	if (!textureData->isLoaded())
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		enqueue(textureData, priority);
 		mEvent.notify_one();
 	}
 }
 
+std::shared_ptr<TextureLoadHandle> TextureLoader::request(std::shared_ptr<TextureData> textureData, TexturePriority priority)
+{
+	if (textureData->isLoaded())
+		return nullptr;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	RequestQueue::iterator req = enqueue(textureData, priority);
+	req->claims++;
+	mEvent.notify_one();
+	return std::shared_ptr<TextureLoadHandle>(new TextureLoadHandle(this, textureData.get(), req->id));
+}
+
+void TextureLoader::cancel(TextureData* key, unsigned int requestId)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	auto td = mTextureDataLookup.find(key);
+	// The request may have been loaded (or replaced by a newer one) since the handle was issued
+	if (td == mTextureDataLookup.end() || (*td).second->id != requestId)
+		return;
+
+	// Only drop it once nobody holding a handle wants it any more
+	if (--(*td).second->claims <= 0)
+		erase(td);
+}
+
 void TextureLoader::remove(std::shared_ptr<TextureData> textureData)
 {
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mMutex);
 	auto td = mTextureDataLookup.find(textureData.get());
 	if (td != mTextureDataLookup.end())
-	{
-		mTextureDataQ.erase((*td).second);
-		mTextureDataLookup.erase(td);
-	}
+		erase(td);
 }
 
 size_t TextureLoader::getQueueSize()
@@ -218,9 +351,19 @@ size_t TextureLoader::getQueueSize()
 	// the queue are loaded
 	size_t mem = 0;
 	std::unique_lock<std::mutex> lock(mMutex);
-	for (auto tex : mTextureDataQ)
+	for (int i = 0; i < TEXTURE_PRIORITY_COUNT; ++i)
 	{
-		mem += tex->width() * tex->height() * 4;
+		for (auto req : mTextureDataQ[i])
+			mem += req.data->getPendingVRAMUsage();
 	}
 	return mem;
 }
+
+TextureLoaderStats TextureLoader::getStats()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	TextureLoaderStats stats = mStats;
+	for (int i = 0; i < TEXTURE_PRIORITY_COUNT; ++i)
+		stats.queued[i] = mTextureDataQ[i].size();
+	return stats;
+}
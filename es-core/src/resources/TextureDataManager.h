@@ -9,8 +9,52 @@
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <list>
 
 class TextureResource;
+class TextureLoader;
+
+enum TexturePriority
+{
+	TEXTURE_PRIORITY_VISIBLE,		// On screen right now
+	TEXTURE_PRIORITY_NEAR,			// Likely to be on screen in a moment (e.g. next to the cursor)
+	TEXTURE_PRIORITY_SPECULATIVE,	// Might be needed, only worth loading when there's nothing better to do
+	TEXTURE_PRIORITY_COUNT
+};
+
+// How long (in ms) a request waits before it is promoted to the next priority up, so that
+// speculative work still gets done while visible textures keep arriving
+#define TEXTURE_AGING_TIME 400
+
+// Per priority class counters. The loaded, cancelled and promoted counts are totals since startup
+struct TextureLoaderStats
+{
+	size_t queued[TEXTURE_PRIORITY_COUNT];
+	size_t loaded[TEXTURE_PRIORITY_COUNT];
+	size_t cancelled[TEXTURE_PRIORITY_COUNT];
+	size_t promoted[TEXTURE_PRIORITY_COUNT];
+};
+
+// Returned by TextureLoader::request(). Cancelling it (or destroying it) tells the loader that
+// this caller no longer wants the texture. The request is dropped from the queue once nobody
+// holding a handle wants it.
+class TextureLoadHandle
+{
+public:
+	~TextureLoadHandle();
+
+	void cancel();
+	bool isCancelled() const { return mCancelled; }
+
+private:
+	friend class TextureLoader;
+	TextureLoadHandle(TextureLoader* loader, TextureData* key, unsigned int requestId);
+
+	TextureLoader*	mLoader;
+	TextureData*	mKey;
+	unsigned int	mRequestId;
+	bool			mCancelled;
+};
 
 class TextureLoader
 {
@@ -18,17 +62,43 @@ public:
 	TextureLoader();
 	~TextureLoader();
 
-	void load(std::shared_ptr<TextureData> textureData);
+	// Queue a texture for loading. Requesting a texture that is already queued only
+	// ever raises its priority
+	void load(std::shared_ptr<TextureData> textureData, TexturePriority priority = TEXTURE_PRIORITY_VISIBLE);
+	// Same as load() but returns a handle that can cancel the request
+	std::shared_ptr<TextureLoadHandle> request(std::shared_ptr<TextureData> textureData, TexturePriority priority);
 	void remove(std::shared_ptr<TextureData> textureData);
 
 	size_t getQueueSize();
+	TextureLoaderStats getStats();
 
 private:
-	void processQueue();
+	friend class TextureLoadHandle;
+
+	struct Request
+	{
+		std::shared_ptr<TextureData>	data;
+		TexturePriority					priority;
+		unsigned int					queuedAt;
+		unsigned int					id;
+		int								claims;	// number of live handles
+	};
+	typedef std::list<Request> RequestQueue;
+
+	// All of these expect mMutex to be held
+	RequestQueue::iterator enqueue(std::shared_ptr<TextureData> textureData, TexturePriority priority);
+	void promoteAged();
+	std::shared_ptr<TextureData> popNext();
+	void erase(std::map<TextureData*, RequestQueue::iterator>::iterator lookup);
+
+	void cancel(TextureData* key, unsigned int requestId);
 	void threadProc();
 
-	std::list<std::shared_ptr<TextureData> > 										mTextureDataQ;
-	std::map<TextureData*, std::list<std::shared_ptr<TextureData> >::iterator > 	mTextureDataLookup;
+	// One queue per priority. Each is used as a LIFO so newly requested textures load first
+	RequestQueue																mTextureDataQ[TEXTURE_PRIORITY_COUNT];
+	std::map<TextureData*, RequestQueue::iterator>								mTextureDataLookup;
+	unsigned int																mNextRequestId;
+	TextureLoaderStats															mStats;
 
 	std::thread*				mThread;
 	std::mutex					mMutex;
@@ -60,11 +130,19 @@ public:
 
 	// The texturedata being removed may be loading in a different thread. However it will
 	// be referenced by a smart point so we only need to remove it from our array and it
-	// will be deleted when the other thread has finished with it
+	// will be deleted when the other thread has finished with it. If it is still waiting
+	// in the loader queue it is dropped from there too
 	void remove(const TextureResource* key);
 
 	std::shared_ptr<TextureData> get(const TextureResource* key);
+	// Check if a texture is loaded without touching its position in the cache or queueing it
+	bool isLoaded(const TextureResource* key);
+	// Queue a texture at the given priority and return a handle that can cancel it. Returns
+	// nullptr if the texture is already loaded
+	std::shared_ptr<TextureLoadHandle> request(const TextureResource* key, TexturePriority priority);
 	bool bind(const TextureResource* key);
+	// Bind texture data that isn't managed here, binding a blank texture if it isn't loaded
+	bool bind(std::shared_ptr<TextureData> tex);
 
 	// Get the total size of all textures managed by this object, loaded and unloaded in bytes
 	size_t	getTotalSize();
@@ -74,9 +152,13 @@ public:
 	// be committed to VRAM as the queue is processed
 	size_t  getQueueSize();
 	// Load a texture, freeing resources as necessary to make space
-	void load(std::shared_ptr<TextureData> tex, bool block = false);
+	void load(std::shared_ptr<TextureData> tex, bool block = false, TexturePriority priority = TEXTURE_PRIORITY_VISIBLE);
+
+	TextureLoaderStats getLoaderStats();
 
 private:
+	// Release the least recently used textures until there is room for another one
+	void makeRoom();
 
 	std::list<std::shared_ptr<TextureData> >												mTextures;
 	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::iterator > 	mTextureLookup;
@@ -0,0 +1,114 @@
+#include "resources/TexturePrefetcher.h"
+#include "resources/TextureResource.h"
+#include <vector>
+#include <algorithm>
+
+TexturePrefetcher::TexturePrefetcher(int radius) : mRadius(radius)
+{
+}
+
+TexturePrefetcher::~TexturePrefetcher()
+{
+	cancel();
+}
+
+void TexturePrefetcher::prefetch(int predicted, int count, bool loop, const std::function<std::string(int)>& pathForIndex)
+{
+	if(count <= 0)
+	{
+		cancel();
+		return;
+	}
+
+	// Work out which entries are wanted, furthest from the predicted cursor first
+	std::vector< std::pair<std::string, TexturePriority> > wanted;
+	for(int distance = mRadius; distance >= 0; distance--)
+	{
+		for(int side = -1; side <= 1; side += 2)
+		{
+			if(distance == 0 && side > 0)
+				break;
+
+			int index = predicted + distance * side;
+			if(loop)
+			{
+				index %= count;
+				if(index < 0)
+					index += count;
+			}else if(index < 0 || index >= count)
+			{
+				continue;
+			}
+
+			const std::string path = pathForIndex(index);
+			if(!path.empty())
+				wanted.push_back(std::make_pair(path, distance * 2 <= mRadius ? TEXTURE_PRIORITY_NEAR : TEXTURE_PRIORITY_SPECULATIVE));
+		}
+	}
+
+	// Drop anything that's no longer in range. Releasing the handle cancels the load
+	// unless someone else still wants the texture
+	for(auto it = mRequests.begin(); it != mRequests.end(); )
+	{
+		auto match = std::find_if(wanted.begin(), wanted.end(),
+			[&](const std::pair<std::string, TexturePriority>& w) { return w.first == it->first; });
+		if(match == wanted.end())
+			it = mRequests.erase(it);
+		else
+			it++;
+	}
+
+	// The loader works from the front of its queues, so queueing the nearest entries last
+	// means they are loaded first
+	for(auto it = wanted.begin(); it != wanted.end(); it++)
+	{
+		auto existing = mRequests.find(it->first);
+		if(existing != mRequests.end())
+		{
+			// Moved closer to the cursor, bump it up. The new handle is taken before the old
+			// one is released so the request never drops out of the queue in between
+			if(it->second < existing->second.priority && existing->second.texture)
+			{
+				existing->second.handle = existing->second.texture->requestLoad(it->second);
+				existing->second.priority = it->second;
+			}
+			continue;
+		}
+
+		Request& req = mRequests[it->first];
+		req.texture = TextureResource::prefetch(it->first);
+		req.priority = it->second;
+		if(req.texture)
+			req.handle = req.texture->requestLoad(it->second);
+	}
+}
+
+void TexturePrefetcher::cancel()
+{
+	for(auto it = mRequests.begin(); it != mRequests.end(); it++)
+	{
+		if(it->second.handle)
+			it->second.handle->cancel();
+	}
+	mRequests.clear();
+}
+
+std::shared_ptr<TextureResource> TexturePrefetcher::get(const std::string& path) const
+{
+	auto it = mRequests.find(path);
+	if(it == mRequests.end() || !it->second.texture || !it->second.texture->isLoaded())
+		return nullptr;
+
+	return it->second.texture;
+}
+
+bool TexturePrefetcher::isPending() const
+{
+	for(auto it = mRequests.begin(); it != mRequests.end(); it++)
+	{
+		if(it->second.texture && !it->second.texture->isLoaded())
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <functional>
+#include "resources/TextureDataManager.h"
+
+class TextureResource;
+
+// Loads the textures for the list entries around where the cursor is going to land.
+//
+// Lists feed it their predicted cursor position (see IList::getPredictedCursor) every
+// time the cursor moves. Textures around that position are handed to the texture loader
+// thread - the closer half of the range as TEXTURE_PRIORITY_NEAR and the rest as
+// TEXTURE_PRIORITY_SPECULATIVE. Requests that have drifted out of range are cancelled,
+// which pulls them out of the loader queue if they have not been started yet.
+//
+// Components should only display a prefetched texture once get() returns it, which
+// happens when it has finished loading in the background.
+class TexturePrefetcher
+{
+public:
+	// radius is the number of entries either side of the predicted cursor to load
+	TexturePrefetcher(int radius = 4);
+	~TexturePrefetcher();
+
+	inline void setRadius(int radius) { mRadius = radius; }
+	inline int getRadius() const { return mRadius; }
+
+	// Request the textures around index "predicted" in a list of "count" entries. pathForIndex
+	// should return the texture path for an entry, or an empty string if it has none.
+	void prefetch(int predicted, int count, bool loop, const std::function<std::string(int)>& pathForIndex);
+
+	// Drop all outstanding requests (e.g. when scrolling too fast for loading to be of any use)
+	void cancel();
+
+	// Returns the texture for path if it was prefetched and has finished loading, otherwise nullptr
+	std::shared_ptr<TextureResource> get(const std::string& path) const;
+
+	// True if any of the requested textures are still waiting to be loaded
+	bool isPending() const;
+
+private:
+	struct Request
+	{
+		std::shared_ptr<TextureResource>	texture;
+		std::shared_ptr<TextureLoadHandle>	handle;
+		TexturePriority						priority;
+	};
+
+	int mRadius;
+	std::map<std::string, Request> mRequests;
+};
@@ -1,4 +1,6 @@
 #include "resources/TextureResource.h"
+#include "resources/SVGCache.h"
+#include "ThreadPool.h"
 #include "Log.h"
 #include "platform.h"
 #include GLHEADER
@@ -11,32 +13,57 @@ TextureDataManager		TextureResource::sTextureDataManager;
 std::map< TextureResource::TextureKeyType, std::weak_ptr<TextureResource> > TextureResource::sTextureMap;
 std::set<TextureResource*> 	TextureResource::sAllTextures;
 
-TextureResource::TextureResource(const std::string& path, bool tile, bool dynamic) : mTextureData(nullptr), mForceLoad(false)
+static bool isSVG(const std::string& path)
 {
+	return path.size() >= 4 && path.compare(path.size() - 4, 4, ".svg") == 0;
+}
+
+TextureResource::TextureResource(const std::string& path, bool tile, bool dynamic, bool async) : mTextureData(nullptr), mSizePending(false), mForceLoad(false)
+{
+	mSize << 0, 0;
+	mSourceSize << 0.0f, 0.0f;
+
 	// Create a texture data object for this texture
 	if (!path.empty())
 	{
 		// If there is a path then the 'dynamic' flag tells us whether to use the texture
 		// data manager to manage loading/unloading of this texture
 		std::shared_ptr<TextureData> data;
-		if (dynamic)
+		if (dynamic && async)
+		{
+			// Don't load it here, the creator queues it with requestLoad(). The size
+			// is filled in later by resolveSize()
+			data = sTextureDataManager.add(this, tile);
+			data->initFromPath(path);
+			mSizePending = true;
+		}
+		else if (dynamic)
 		{
 			data = sTextureDataManager.add(this, tile);
 			data->initFromPath(path);
-			// Force the texture manager to load it using a blocking load
-			sTextureDataManager.load(data, true);
+			// Force the texture manager to load it using a blocking load. SVGs don't need
+			// to be rasterized to know their size so they're left for the loader thread
+			if (!data->isScalable())
+				sTextureDataManager.load(data, true);
 		}
 		else
 		{
 			mTextureData = std::shared_ptr<TextureData>(new TextureData(tile));
 			data = mTextureData;
 			data->initFromPath(path);
-			// Load it so we can read the width/height
-			data->load();
+			// Load it so we can read the width/height. SVGs are rasterized on the loader
+			// thread once they're given a size (see bind()) and async ones are decoded by preload()
+			if (async)
+				mSizePending = true;
+			else if (!data->isScalable())
+				data->load();
 		}
 
-		mSize << data->width(), data->height();
-		mSourceSize << data->sourceWidth(), data->sourceHeight();
+		if (!mSizePending)
+		{
+			mSize << data->width(), data->height();
+			mSourceSize << data->sourceWidth(), data->sourceHeight();
+		}
 	}
 	else
 	{
@@ -78,8 +105,29 @@ void TextureResource::initFromMemory(const char* data, size_t length)
 	mSourceSize << mTextureData->sourceWidth(), mTextureData->sourceHeight();
 }
 
+void TextureResource::resolveSize() const
+{
+	if (!mSizePending)
+		return;
+
+	// If the loader thread hasn't got to it yet this falls back to a blocking load,
+	// which is no worse than what get() would have done
+	std::shared_ptr<TextureData> data;
+	if (mTextureData != nullptr)
+		data = mTextureData;
+	else
+		data = sTextureDataManager.get(this);
+	if (data == nullptr)
+		return;
+
+	mSize << data->width(), data->height();
+	mSourceSize << data->sourceWidth(), data->sourceHeight();
+	mSizePending = false;
+}
+
 const Eigen::Vector2i TextureResource::getSize() const
 {
+	resolveSize();
 	return mSize;
 }
 
@@ -91,12 +139,41 @@ bool TextureResource::isTiled() const
 	return data->tiled();
 }
 
+bool TextureResource::isLoaded() const
+{
+	if (mTextureData != nullptr)
+		return mTextureData->isLoaded();
+	return sTextureDataManager.isLoaded(this);
+}
+
+std::shared_ptr<TextureLoadHandle> TextureResource::requestLoad(TexturePriority priority)
+{
+	// Textures that manage their own data are loaded as soon as they're created
+	if (mTextureData != nullptr)
+		return nullptr;
+	return sTextureDataManager.request(this, priority);
+}
+
+TextureLoaderStats TextureResource::getLoaderStats()
+{
+	return sTextureDataManager.getLoaderStats();
+}
+
 bool TextureResource::bind()
 {
 	if (mTextureData != nullptr)
 	{
-		mTextureData->uploadAndBind();
-		return true;
+		if (!mTextureData->isScalable())
+		{
+			mTextureData->uploadAndBind();
+			return true;
+		}
+
+		// Show a blank until the loader thread has rasterized it
+		bool bound = sTextureDataManager.bind(mTextureData);
+		if (!bound)
+			sTextureDataManager.load(mTextureData);
+		return bound;
 	}
 	else
 	{
@@ -130,7 +207,7 @@ std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, b
 	std::shared_ptr<TextureData> data = sTextureDataManager.get(tex.get());
 
 	// is it an SVG?
-	if(key.first.substr(key.first.size() - 4, std::string::npos) != ".svg")
+	if(!isSVG(key.first))
 	{
 		// Probably not. Add it to our map. We don't add SVGs because 2 svgs might be rasterized at different sizes
 		sTextureMap[key] = std::weak_ptr<TextureResource>(tex);
@@ -149,6 +226,69 @@ std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, b
 	return tex;
 }
 
+std::shared_ptr<TextureResource> TextureResource::prefetch(const std::string& path, bool tile)
+{
+	if(path.empty() || !ResourceManager::getInstance()->fileExists(path))
+		return nullptr;
+
+	const std::string canonicalPath = getCanonicalPath(path);
+	// SVGs are rasterized at whatever size they are displayed at so there is nothing useful to prefetch
+	if(canonicalPath.empty() || isSVG(canonicalPath))
+		return nullptr;
+
+	TextureKeyType key(canonicalPath, tile);
+	auto foundTexture = sTextureMap.find(key);
+	if(foundTexture != sTextureMap.end() && !foundTexture->second.expired())
+		return foundTexture->second.lock();
+
+	std::shared_ptr<TextureResource> tex(new TextureResource(key.first, tile, true, true));
+	sTextureMap[key] = std::weak_ptr<TextureResource>(tex);
+	ResourceManager::getInstance()->addReloadable(tex);
+	return tex;
+}
+
+std::vector< std::shared_ptr<TextureResource> > TextureResource::preload(const std::vector<std::string>& paths, bool tile)
+{
+	std::vector< std::shared_ptr<TextureResource> > textures;
+	std::vector< std::future<void> > work;
+	ThreadPool* pool = ThreadPool::getInstance();
+
+	for (auto it = paths.begin(); it != paths.end(); it++)
+	{
+		const std::string canonicalPath = getCanonicalPath(*it);
+		if (canonicalPath.empty())
+			continue;
+
+		if (isSVG(canonicalPath))
+		{
+			work.push_back(pool->queueWorkItem([canonicalPath] { SVGCache::getImage(canonicalPath); }));
+			continue;
+		}
+
+		TextureKeyType key(canonicalPath, tile);
+		auto foundTexture = sTextureMap.find(key);
+		if (foundTexture != sTextureMap.end() && !foundTexture->second.expired())
+		{
+			textures.push_back(foundTexture->second.lock());
+			continue;
+		}
+
+		std::shared_ptr<TextureResource> tex(new TextureResource(key.first, tile, false, true));
+		sTextureMap[key] = std::weak_ptr<TextureResource>(tex);
+		ResourceManager::getInstance()->addReloadable(tex);
+		textures.push_back(tex);
+
+		// Only the decode happens on the pool, the GL upload is left for the first bind()
+		std::shared_ptr<TextureData> data = tex->mTextureData;
+		work.push_back(pool->queueWorkItem([data] { data->load(); }));
+	}
+
+	for (auto it = work.begin(); it != work.end(); it++)
+		it->wait();
+
+	return textures;
+}
+
 // For scalable source images in textures we want to set the resolution to rasterize at
 void TextureResource::rasterizeAt(size_t width, size_t height)
 {
@@ -159,12 +299,15 @@ void TextureResource::rasterizeAt(size_t width, size_t height)
 		data = sTextureDataManager.get(this);
 	mSourceSize << (float)width, (float)height;
 	data->setSourceSize((float)width, (float)height);
-	if (mForceLoad || (mTextureData != nullptr))
+	if (mForceLoad)
 		data->load();
+	else if (mTextureData != nullptr)
+		sTextureDataManager.load(data);
 }
 
 Eigen::Vector2f TextureResource::getSourceImageSize() const
 {
+	resolveSize();
 	return mSourceSize;
 }
 
@@ -5,6 +5,7 @@
 #include <string>
 #include <set>
 #include <list>
+#include <vector>
 #include <Eigen/Dense>
 #include "platform.h"
 #include "resources/TextureData.h"
@@ -17,6 +18,14 @@ class TextureResource : public IReloadable
 {
 public:
 	static std::shared_ptr<TextureResource> get(const std::string& path, bool tile = false, bool forceLoad = false, bool dynamic = true);
+	// Like get() but never blocks. Nothing is loaded until requestLoad() is called, and the size
+	// is only known once isLoaded() returns true. Used by TexturePrefetcher.
+	static std::shared_ptr<TextureResource> prefetch(const std::string& path, bool tile = false);
+	// Decode a batch of textures (the non-dynamic kind, as get(path, tile, false, false) makes) on
+	// the worker pool and wait for them all. They go into the texture map so later get() calls
+	// return them without decoding again, as long as the returned pointers are kept until then.
+	// SVGs are only parsed here, they are rasterized once they are given a size.
+	static std::vector< std::shared_ptr<TextureResource> > preload(const std::vector<std::string>& paths, bool tile = false);
 	void initFromPixels(const unsigned char* dataRGBA, size_t width, size_t height);
 	virtual void initFromMemory(const char* file, size_t length);
 
@@ -28,15 +37,21 @@ public:
 
 	bool isInitialized() const;
 	bool isTiled() const;
+	bool isLoaded() const;
+
+	// Queue the texture for loading at the given priority. Dropping or cancelling the returned
+	// handle withdraws the request. Returns nullptr if there is nothing to wait for.
+	std::shared_ptr<TextureLoadHandle> requestLoad(TexturePriority priority);
 
 	const Eigen::Vector2i getSize() const;
 	bool bind();
 
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by textures (in bytes)
 	static size_t getTotalTextureSize(); // returns the number of bytes that would be used if all textures were in memory
+	static TextureLoaderStats getLoaderStats(); // per priority counters for the background loader
 
 protected:
-	TextureResource(const std::string& path, bool tile, bool dynamic);
+	TextureResource(const std::string& path, bool tile, bool dynamic, bool async = false);
 	virtual void unload(std::shared_ptr<ResourceManager>& rm);
 	virtual void reload(std::shared_ptr<ResourceManager>& rm);
 
@@ -48,8 +63,12 @@ private:
 	// The texture data manager manages loading and unloading of filesystem based textures
 	static TextureDataManager		sTextureDataManager;
 
-	Eigen::Vector2i					mSize;
-	Eigen::Vector2f					mSourceSize;
+	// Fills in the sizes of an asynchronously created texture once they are needed
+	void resolveSize() const;
+
+	mutable Eigen::Vector2i			mSize;
+	mutable Eigen::Vector2f			mSourceSize;
+	mutable bool					mSizePending;
 	bool							mForceLoad;
 
 	typedef std::pair<std::string, bool> TextureKeyType;
@@ -77,6 +77,20 @@ void nsvgDeleteRasterizer(NSVGrasterizer*);
 #define NSVG__FIX			(1 << NSVG__FIXSHIFT)
 #define NSVG__FIXMASK		(NSVG__FIX-1)
 #define NSVG__MEMPAGE_SIZE	1024
+#define NSVG__SPAN_CHUNK	64
+
+// The scanline fill and compositing have SSE2 and NEON versions, picked at compile time.
+// They do exactly the same integer maths as the scalar code so the output is identical.
+// Define NSVG_NO_SIMD to always use the scalar code.
+#ifndef NSVG_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NSVG__SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NSVG__NEON 1
+#include <arm_neon.h>
+#endif
+#endif
 
 typedef struct NSVGedge {
 	float x0,y0, x1,y1;
@@ -882,6 +896,24 @@ static void nsvg__freeActive(NSVGrasterizer* r, NSVGactiveEdge* z)
 	r->freelist = z;
 }
 
+// Add w to the coverage of pixels i to j-1
+static void nsvg__addCoverage(unsigned char* scanline, int i, int j, unsigned char w)
+{
+#if defined(NSVG__SSE2)
+	__m128i vw = _mm_set1_epi8((char)w);
+	for (; i + 16 <= j; i += 16) {
+		__m128i s = _mm_loadu_si128((__m128i*)&scanline[i]);
+		_mm_storeu_si128((__m128i*)&scanline[i], _mm_add_epi8(s, vw));
+	}
+#elif defined(NSVG__NEON)
+	uint8x16_t vw = vdupq_n_u8(w);
+	for (; i + 16 <= j; i += 16)
+		vst1q_u8(&scanline[i], vaddq_u8(vld1q_u8(&scanline[i]), vw));
+#endif
+	for (; i < j; ++i)
+		scanline[i] += w;
+}
+
 static void nsvg__fillScanline(unsigned char* scanline, int len, int x0, int x1, int maxWeight, int* xmin, int* xmax)
 {
 	int i = x0 >> NSVG__FIXSHIFT;
@@ -903,8 +935,8 @@ static void nsvg__fillScanline(unsigned char* scanline, int len, int x0, int x1,
 			else
 				j = len; // clip
 
-			for (++i; i < j; ++i) // fill pixels between x0 and x1
-				scanline[i] += (unsigned char)maxWeight;
+			// fill pixels between x0 and x1
+			nsvg__addCoverage(scanline, i + 1, j, (unsigned char)maxWeight);
 		}
 	}
 }
@@ -978,83 +1010,138 @@ static inline int nsvg__div255(int x)
     return ((x+1) * 257) >> 16;
 }
 
+#if defined(NSVG__SSE2)
+static inline __m128i nsvg__div255_sse2(__m128i x)
+{
+	// Same as nsvg__div255 but without needing 32 bit intermediates
+	x = _mm_add_epi16(x, _mm_set1_epi16(1));
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Blend two pixels, one 16 bit lane per channel
+static inline __m128i nsvg__blend2_sse2(__m128i dst, __m128i col, __m128i ca, __m128i cov)
+{
+	__m128i a = nsvg__div255_sse2(_mm_mullo_epi16(cov, ca));
+	__m128i ia = _mm_sub_epi16(_mm_set1_epi16(255), a);
+	return _mm_add_epi16(nsvg__div255_sse2(_mm_mullo_epi16(col, a)), nsvg__div255_sse2(_mm_mullo_epi16(ia, dst)));
+}
+
+static void nsvg__blend4(unsigned char* dst, const unsigned int* col, const unsigned int* ca, const unsigned int* cov)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i d = _mm_loadu_si128((__m128i*)dst);
+	__m128i c = _mm_loadu_si128((const __m128i*)col);
+	__m128i a = _mm_loadu_si128((const __m128i*)ca);
+	__m128i v = _mm_loadu_si128((const __m128i*)cov);
+	__m128i lo = nsvg__blend2_sse2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(v, zero));
+	__m128i hi = nsvg__blend2_sse2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(v, zero));
+	// Results never exceed 255 so saturating is the same as truncating
+	_mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+}
+#elif defined(NSVG__NEON)
+static inline uint16x8_t nsvg__div255_neon(uint16x8_t x)
+{
+	// Same as nsvg__div255 but without needing 32 bit intermediates
+	x = vaddq_u16(x, vdupq_n_u16(1));
+	return vshrq_n_u16(vsraq_n_u16(x, x, 8), 8);
+}
+
+// Blend two pixels, one 16 bit lane per channel
+static inline uint16x8_t nsvg__blend2_neon(uint16x8_t dst, uint16x8_t col, uint16x8_t ca, uint16x8_t cov)
+{
+	uint16x8_t a = nsvg__div255_neon(vmulq_u16(cov, ca));
+	uint16x8_t ia = vsubq_u16(vdupq_n_u16(255), a);
+	return vaddq_u16(nsvg__div255_neon(vmulq_u16(col, a)), nsvg__div255_neon(vmulq_u16(ia, dst)));
+}
+
+static void nsvg__blend4(unsigned char* dst, const unsigned int* col, const unsigned int* ca, const unsigned int* cov)
+{
+	uint8x16_t d = vld1q_u8(dst);
+	uint8x16_t c = vreinterpretq_u8_u32(vld1q_u32(col));
+	uint8x16_t a = vreinterpretq_u8_u32(vld1q_u32(ca));
+	uint8x16_t v = vreinterpretq_u8_u32(vld1q_u32(cov));
+	uint16x8_t lo = nsvg__blend2_neon(vmovl_u8(vget_low_u8(d)), vmovl_u8(vget_low_u8(c)), vmovl_u8(vget_low_u8(a)), vmovl_u8(vget_low_u8(v)));
+	uint16x8_t hi = nsvg__blend2_neon(vmovl_u8(vget_high_u8(d)), vmovl_u8(vget_high_u8(c)), vmovl_u8(vget_high_u8(a)), vmovl_u8(vget_high_u8(v)));
+	vst1q_u8(dst, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+}
+#endif
+
+// Composite count pixels over dst, weighted by cover. colors has one color per pixel,
+// or a single color for the whole span if colorStep is 0.
+static void nsvg__compositeSpan(unsigned char* dst, int count, unsigned char* cover, const unsigned int* colors, int colorStep)
+{
+	int i = 0;
+
+#if defined(NSVG__SSE2) || defined(NSVG__NEON)
+	// Each channel is blended as (color * a + dst * (255 - a)) / 255. Forcing the color's
+	// alpha to 255 makes the alpha channel come out as a + dst * (255 - a) / 255, which is
+	// what the scalar code does.
+	for (; i + 4 <= count; i += 4) {
+		unsigned int col[4], ca[4], cov[4];
+		int k;
+		for (k = 0; k < 4; k++) {
+			unsigned int c = colors[(i + k) * colorStep];
+			col[k] = c | 0xff000000u;
+			ca[k] = (c >> 24) * 0x01010101u;
+			cov[k] = cover[i + k] * 0x01010101u;
+		}
+		nsvg__blend4(dst + i*4, col, ca, cov);
+	}
+#endif
+
+	for (; i < count; i++) {
+		unsigned int c = colors[i * colorStep];
+		unsigned char* d = dst + i*4;
+		int r,g,b;
+		int a = nsvg__div255((int)cover[i] * (int)((c >> 24) & 0xff));
+		int ia = 255 - a;
+		// Premultiply
+		r = nsvg__div255((int)(c & 0xff) * a);
+		g = nsvg__div255((int)((c >> 8) & 0xff) * a);
+		b = nsvg__div255((int)((c >> 16) & 0xff) * a);
+
+		// Blend over
+		r += nsvg__div255(ia * (int)d[0]);
+		g += nsvg__div255(ia * (int)d[1]);
+		b += nsvg__div255(ia * (int)d[2]);
+		a += nsvg__div255(ia * (int)d[3]);
+
+		d[0] = (unsigned char)r;
+		d[1] = (unsigned char)g;
+		d[2] = (unsigned char)b;
+		d[3] = (unsigned char)a;
+	}
+}
+
 static void nsvg__scanlineSolid(unsigned char* dst, int count, unsigned char* cover, int x, int y,
 								float tx, float ty, float scale, NSVGcachedPaint* cache)
 {
 
 	if (cache->type == NSVG_PAINT_COLOR) {
-		int i, cr, cg, cb, ca;
-		cr = cache->colors[0] & 0xff;
-		cg = (cache->colors[0] >> 8) & 0xff;
-		cb = (cache->colors[0] >> 16) & 0xff;
-		ca = (cache->colors[0] >> 24) & 0xff;
-
-		for (i = 0; i < count; i++) {
-			int r,g,b;
-			int a = nsvg__div255((int)cover[0] * ca);
-			int ia = 255 - a;
-			// Premultiply
-			r = nsvg__div255(cr * a);
-			g = nsvg__div255(cg * a);
-			b = nsvg__div255(cb * a);
-
-			// Blend over
-			r += nsvg__div255(ia * (int)dst[0]);
-			g += nsvg__div255(ia * (int)dst[1]);
-			b += nsvg__div255(ia * (int)dst[2]);
-			a += nsvg__div255(ia * (int)dst[3]);
-
-			dst[0] = (unsigned char)r;
-			dst[1] = (unsigned char)g;
-			dst[2] = (unsigned char)b;
-			dst[3] = (unsigned char)a;
-
-			cover++;
-			dst += 4;
-		}
+		nsvg__compositeSpan(dst, count, cover, &cache->colors[0], 0);
 	} else if (cache->type == NSVG_PAINT_LINEAR_GRADIENT) {
 		// TODO: spread modes.
 		// TODO: plenty of opportunities to optimize.
 		float fx, fy, dx, gy;
 		float* t = cache->xform;
-		int i, cr, cg, cb, ca;
-		unsigned int c;
+		unsigned int colors[NSVG__SPAN_CHUNK];
+		int i, k, n;
 
 		fx = (x - tx) / scale;
 		fy = (y - ty) / scale;
 		dx = 1.0f / scale;
 
-		for (i = 0; i < count; i++) {
-			int r,g,b,a,ia;
-			gy = fx*t[1] + fy*t[3] + t[5];
-			c = cache->colors[(int)nsvg__clampf(gy*255.0f, 0, 255.0f)];
-			cr = (c) & 0xff;
-			cg = (c >> 8) & 0xff;
-			cb = (c >> 16) & 0xff;
-			ca = (c >> 24) & 0xff;
-
-			a = nsvg__div255((int)cover[0] * ca);
-			ia = 255 - a;
-
-			// Premultiply
-			r = nsvg__div255(cr * a);
-			g = nsvg__div255(cg * a);
-			b = nsvg__div255(cb * a);
-
-			// Blend over
-			r += nsvg__div255(ia * (int)dst[0]);
-			g += nsvg__div255(ia * (int)dst[1]);
-			b += nsvg__div255(ia * (int)dst[2]);
-			a += nsvg__div255(ia * (int)dst[3]);
-
-			dst[0] = (unsigned char)r;
-			dst[1] = (unsigned char)g;
-			dst[2] = (unsigned char)b;
-			dst[3] = (unsigned char)a;
-
-			cover++;
-			dst += 4;
-			fx += dx;
+		// Look up the colors a chunk at a time, then composite them in one go
+		for (i = 0; i < count; i += n) {
+			n = count - i < NSVG__SPAN_CHUNK ? count - i : NSVG__SPAN_CHUNK;
+			for (k = 0; k < n; k++) {
+				gy = fx*t[1] + fy*t[3] + t[5];
+				colors[k] = cache->colors[(int)nsvg__clampf(gy*255.0f, 0, 255.0f)];
+				fx += dx;
+			}
+			nsvg__compositeSpan(dst, n, cover, colors, 1);
+			cover += n;
+			dst += n*4;
 		}
 	} else if (cache->type == NSVG_PAINT_RADIAL_GRADIENT) {
 		// TODO: spread modes.
@@ -1062,46 +1149,25 @@ static void nsvg__scanlineSolid(unsigned char* dst, int count, unsigned char* co
 		// TODO: focus (fx,fy)
 		float fx, fy, dx, gx, gy, gd;
 		float* t = cache->xform;
-		int i, cr, cg, cb, ca;
-		unsigned int c;
+		unsigned int colors[NSVG__SPAN_CHUNK];
+		int i, k, n;
 
 		fx = (x - tx) / scale;
 		fy = (y - ty) / scale;
 		dx = 1.0f / scale;
 
-		for (i = 0; i < count; i++) {
-			int r,g,b,a,ia;
-			gx = fx*t[0] + fy*t[2] + t[4];
-			gy = fx*t[1] + fy*t[3] + t[5];
-			gd = sqrtf(gx*gx + gy*gy);
-			c = cache->colors[(int)nsvg__clampf(gd*255.0f, 0, 255.0f)];
-			cr = (c) & 0xff;
-			cg = (c >> 8) & 0xff;
-			cb = (c >> 16) & 0xff;
-			ca = (c >> 24) & 0xff;
-
-			a = nsvg__div255((int)cover[0] * ca);
-			ia = 255 - a;
-
-			// Premultiply
-			r = nsvg__div255(cr * a);
-			g = nsvg__div255(cg * a);
-			b = nsvg__div255(cb * a);
-
-			// Blend over
-			r += nsvg__div255(ia * (int)dst[0]);
-			g += nsvg__div255(ia * (int)dst[1]);
-			b += nsvg__div255(ia * (int)dst[2]);
-			a += nsvg__div255(ia * (int)dst[3]);
-
-			dst[0] = (unsigned char)r;
-			dst[1] = (unsigned char)g;
-			dst[2] = (unsigned char)b;
-			dst[3] = (unsigned char)a;
-
-			cover++;
-			dst += 4;
-			fx += dx;
+		for (i = 0; i < count; i += n) {
+			n = count - i < NSVG__SPAN_CHUNK ? count - i : NSVG__SPAN_CHUNK;
+			for (k = 0; k < n; k++) {
+				gx = fx*t[0] + fy*t[2] + t[4];
+				gy = fx*t[1] + fy*t[3] + t[5];
+				gd = sqrtf(gx*gx + gy*gy);
+				colors[k] = cache->colors[(int)nsvg__clampf(gd*255.0f, 0, 255.0f)];
+				fx += dx;
+			}
+			nsvg__compositeSpan(dst, n, cover, colors, 1);
+			cover += n;
+			dst += n*4;
 		}
 	}
 }
@@ -0,0 +1,138 @@
+// Checks that the SSE2/NEON rasterizer gives exactly the same pixels as the scalar one.
+//
+// The nanosvg library is built with SIMD (unless NANOSVG_SIMD is off), this file compiles a
+// second, scalar copy of the rasterizer under other names and compares the two on some
+// generated shapes and on every SVG in the folders given on the command line.
+//
+// usage: nanosvg_simd_test [folder...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include "nanosvg.h"
+
+#define NSVG_NO_SIMD
+#define nsvgCreateRasterizer nsvgScalarCreateRasterizer
+#define nsvgRasterize nsvgScalarRasterize
+#define nsvgDeleteRasterizer nsvgScalarDeleteRasterizer
+#define NANOSVGRAST_IMPLEMENTATION
+#include "nanosvgrast.h"
+#undef nsvgCreateRasterizer
+#undef nsvgRasterize
+#undef nsvgDeleteRasterizer
+
+// the library's, nanosvgrast.h has already been included under the scalar names
+extern "C" {
+NSVGrasterizer* nsvgCreateRasterizer();
+void nsvgRasterize(NSVGrasterizer* r, NSVGimage* image, float tx, float ty, float scale, unsigned char* dst, int w, int h, int stride);
+void nsvgDeleteRasterizer(NSVGrasterizer*);
+}
+
+// solid fills, translucency and both gradient types, with edges at odd places so the
+// spans aren't multiples of the vector width
+static const char* sShapes[] = {
+	"<svg width='61' height='47'><rect x='3.3' y='2.7' width='50.1' height='39.9' fill='#c83264'/></svg>",
+	"<svg width='64' height='64'><circle cx='31.7' cy='32.2' r='27.5' fill='#20a0e0' fill-opacity='0.55'/>"
+		"<rect x='5' y='20' width='53' height='9' fill='#ffcc00' fill-opacity='0.3'/></svg>",
+	"<svg width='97' height='33'><defs><linearGradient id='g' x1='0' y1='0' x2='1' y2='0.3'>"
+		"<stop offset='0' stop-color='#ff0000'/><stop offset='0.5' stop-color='#00ff00' stop-opacity='0.4'/>"
+		"<stop offset='1' stop-color='#0000ff'/></linearGradient></defs>"
+		"<path d='M1.5 2 L95 4.5 L90 31 L6 28 Z' fill='url(#g)'/></svg>",
+	"<svg width='80' height='80'><defs><radialGradient id='r' cx='0.45' cy='0.55' r='0.6'>"
+		"<stop offset='0' stop-color='#ffffff'/><stop offset='1' stop-color='#103050' stop-opacity='0.2'/>"
+		"</radialGradient></defs><ellipse cx='40' cy='40' rx='37.3' ry='21.9' fill='url(#r)'/>"
+		"<circle cx='40' cy='40' r='12' fill='none' stroke='#000000' stroke-width='3.5'/></svg>",
+};
+
+static const float sScales[] = { 0.37f, 1.0f, 2.0f, 4.0f, 8.0f };
+
+static int sFailures = 0;
+static int sCompared = 0;
+
+static void compare(NSVGimage* image, const std::string& name)
+{
+	NSVGrasterizer* simd = nsvgCreateRasterizer();
+	NSVGrasterizer* scalar = nsvgScalarCreateRasterizer();
+
+	for(unsigned int i = 0; i < sizeof(sScales) / sizeof(sScales[0]); i++)
+	{
+		const float scale = sScales[i];
+		const int w = (int)(image->width * scale) + 1;
+		const int h = (int)(image->height * scale) + 1;
+
+		// not cleared to zero, so blending over what's already there is covered too
+		std::vector<unsigned char> a(w * h * 4), b;
+		for(size_t k = 0; k < a.size(); k++)
+			a[k] = (unsigned char)(k * 37 + 11);
+		b = a;
+
+		nsvgRasterize(simd, image, 0.5f, 0.25f, scale, a.data(), w, h, w * 4);
+		nsvgScalarRasterize(scalar, image, 0.5f, 0.25f, scale, b.data(), w, h, w * 4);
+
+		sCompared++;
+		if(a != b)
+		{
+			size_t k = 0;
+			while(a[k] == b[k])
+				k++;
+			printf("FAIL %s at %gx: first difference at pixel %d,%d (%d vs %d)\n", name.c_str(), scale,
+				(int)(k / 4) % w, (int)(k / 4) / w, a[k], b[k]);
+			sFailures++;
+		}
+	}
+
+	nsvgScalarDeleteRasterizer(scalar);
+	nsvgDeleteRasterizer(simd);
+}
+
+static void compareFolder(const std::string& folder)
+{
+	DIR* dir = opendir(folder.c_str());
+	if(!dir)
+	{
+		printf("FAIL could not open %s\n", folder.c_str());
+		sFailures++;
+		return;
+	}
+
+	while(struct dirent* entry = readdir(dir))
+	{
+		const std::string name = entry->d_name;
+		if(name.size() < 4 || name.compare(name.size() - 4, 4, ".svg") != 0)
+			continue;
+
+		const std::string path = folder + "/" + name;
+		NSVGimage* image = nsvgParseFromFile(path.c_str(), "px", 96);
+		if(!image)
+		{
+			printf("FAIL could not parse %s\n", path.c_str());
+			sFailures++;
+			continue;
+		}
+
+		compare(image, path);
+		nsvgDelete(image);
+	}
+
+	closedir(dir);
+}
+
+int main(int argc, char* argv[])
+{
+	for(unsigned int i = 0; i < sizeof(sShapes) / sizeof(sShapes[0]); i++)
+	{
+		std::string svg = sShapes[i]; // nsvgParse writes to it
+		NSVGimage* image = nsvgParse(&svg[0], "px", 96);
+		compare(image, "shape " + std::to_string(i));
+		nsvgDelete(image);
+	}
+
+	for(int i = 1; i < argc; i++)
+		compareFolder(argv[i]);
+
+	printf("%d of %d rasterizations differ\n", sFailures, sCompared);
+	return sFailures == 0 ? 0 : 1;
+}